@@ -1,5 +1,9 @@
 cmake_dependent_option(AVALANCHE_ENABLE_DX12 "Enable DX12 features for RHI" ON "WIN32" OFF)
 option(AVALANCHE_ENABLE_VULKAN "Enable Vulkan features for RHI" ON)
+option(AVALANCHE_ENABLE_PROFILER "Compile in profiler zones, they are still disabled by default at runtime" ON)
 
 # render_driver_vulkan
 option(AVALANCHE_ENABLE_VULKAN_DRIVER_TESTS "Enable vulkan driver tests" OFF)
+
+# benchmarks
+option(AVALANCHE_BUILD_BENCHMARKS "Build benchmarks of core containers and execution" OFF)
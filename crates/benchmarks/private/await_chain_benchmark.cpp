@@ -0,0 +1,62 @@
+#include "benchmark.h"
+#include "execution/async_coroutine.h"
+#include "execution/parallel.h"
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using namespace avalanche::core::execution;
+
+        constexpr size_t chain_length = 1000000;
+
+        async<size_t> nested_chain(const size_t depth) {
+            if (depth == 0) {
+                co_return 0;
+            }
+            co_return co_await nested_chain(depth - 1) + 1;
+        }
+
+        async<size_t> leaf(size_t value) {
+            co_return value;
+        }
+
+        async<size_t> sequential_chain(const size_t length) {
+            size_t sum = 0;
+            for (size_t i = 0; i < length; ++i) {
+                sum += co_await leaf(1);
+            }
+            co_return sum;
+        }
+
+        template <typename Ret>
+        Ret run_blocking(async<Ret>& task) {
+            core::execution::detail::parallel::block_on(task);
+            return task->get_result();
+        }
+    }
+
+    /**
+     * Every level of the nested chain completes by transferring to its awaiter from the final awaiter. Without
+     * symmetric transfer, each level would add native stack frames and the 1M levels overflow the stack, so this also
+     * guards that path. It relies on the tail call the compiler emits for it, in an optimized build.
+     */
+    bool run_await_chain_benchmark() {
+        bool is_correct = true;
+
+        const double nested_ms = measure([&is_correct] {
+            auto task = nested_chain(chain_length);
+            is_correct &= run_blocking(task) == chain_length;
+        });
+        report("nested co_await chain, 1M levels", nested_ms);
+
+        const double sequential_ms = measure([&is_correct] {
+            auto task = sequential_chain(chain_length);
+            is_correct &= run_blocking(task) == chain_length;
+        });
+        report("sequential co_await, 1M tasks", sequential_ms);
+
+        return is_correct;
+    }
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+
+namespace avalanche::benchmark {
+
+    using clock_type = std::chrono::steady_clock;
+
+    /**
+     * @brief Best wall time of `repeat` runs of `function` in millisecond, the first runs usually warm up pools and caches.
+     */
+    template <typename Function>
+    double measure(Function&& function, const int repeat = 3) {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < repeat; ++i) {
+            const auto begin = clock_type::now();
+            function();
+            const std::chrono::duration<double, std::milli> elapsed = clock_type::now() - begin;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    /**
+     * @brief Make a result observable, so the work producing it isn't optimized out.
+     */
+    void consume(size_t value);
+
+    inline void report(const char* name, const double milliseconds) {
+        AVALANCHE_LOGGER.info("{:<48} {:>12.3f} ms", name, milliseconds);
+    }
+
+    inline void report_count(const char* name, const size_t count) {
+        AVALANCHE_LOGGER.info("{:<48} {:>12}", name, count);
+    }
+
+    /**
+     * @return false if the benchmark observed a wrong result, which fails the whole run
+     */
+    bool run_await_chain_benchmark();
+    bool run_parallel_benchmark();
+    bool run_graph_benchmark();
+    bool run_tick_manager_benchmark();
+    bool run_hash_map_benchmark();
+    bool run_timing_wheel_benchmark();
+    bool run_ordered_map_benchmark();
+    bool run_small_vector_benchmark();
+    bool run_vector_resize_benchmark();
+    bool run_frame_allocator_benchmark();
+
+}
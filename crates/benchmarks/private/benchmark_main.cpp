@@ -0,0 +1,56 @@
+#include "benchmark.h"
+#include <cstring>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        volatile size_t g_sink = 0;
+
+        struct BenchmarkSuite {
+            const char* name;
+            bool (*run)();
+        };
+
+        constexpr BenchmarkSuite suites[] = {
+            { "await_chain", &run_await_chain_benchmark },
+            { "parallel", &run_parallel_benchmark },
+            { "graph", &run_graph_benchmark },
+            { "tick_manager", &run_tick_manager_benchmark },
+            { "hash_map", &run_hash_map_benchmark },
+            { "timing_wheel", &run_timing_wheel_benchmark },
+            { "ordered_map", &run_ordered_map_benchmark },
+            { "small_vector", &run_small_vector_benchmark },
+            { "vector_resize", &run_vector_resize_benchmark },
+            { "frame_allocator", &run_frame_allocator_benchmark },
+        };
+    }
+
+    void consume(const size_t value) {
+        g_sink = g_sink + value;
+    }
+
+}
+
+using namespace avalanche::benchmark;
+
+/**
+ * Run every suite, or only the ones named in arguments, e.g. `avalanche_benchmarks await_chain`.
+ */
+int main(int argc, char* argv[]) {
+    int result = 0;
+    for (const BenchmarkSuite& suite : suites) {
+        const bool is_selected = argc <= 1 || std::any_of(argv + 1, argv + argc, [&suite](const char* arg) {
+            return std::strcmp(arg, suite.name) == 0;
+        });
+        if (!is_selected) {
+            continue;
+        }
+        AVALANCHE_LOGGER.info("[{}]", suite.name);
+        if (!suite.run()) {
+            AVALANCHE_LOGGER.error("Benchmark {} observed a wrong result", suite.name);
+            result = 1;
+        }
+    }
+    return result;
+}
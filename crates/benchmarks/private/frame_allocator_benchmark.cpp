@@ -0,0 +1,120 @@
+#include "benchmark.h"
+#include "container/vector.hpp"
+#include "execution/async_coroutine.h"
+#include "execution/executor.h"
+#include "execution/frame_allocator.h"
+#include "execution/parallel.h"
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using namespace avalanche::core::execution;
+
+        constexpr int num_warm_up_frames = 16;
+        constexpr int num_frames = 1000;
+        constexpr size_t num_jobs_per_frame = 256;
+        constexpr size_t num_awaits_per_job = 4;
+        constexpr size_t expected_frame_sum = num_awaits_per_job * num_jobs_per_frame * (num_jobs_per_frame - 1) / 2;
+
+        async<size_t> leaf(size_t value) {
+            co_return value;
+        }
+
+        async<size_t> job(size_t index) {
+            size_t sum = 0;
+            for (size_t i = 0; i < num_awaits_per_job; ++i) {
+                sum += co_await leaf(index);
+            }
+            co_return sum;
+        }
+
+        /**
+         * @brief Launch jobs on `executor`, or the workers if it is null, and join them.
+         */
+        async<size_t> frame(vector<async<size_t>>& jobs, coroutine_executor_base* executor) {
+            jobs.clear();
+            for (size_t i = 0; i < num_jobs_per_frame; ++i) {
+                jobs.push_back(job(i));
+                if (executor != nullptr) {
+                    launch(jobs.last_item(), *executor);
+                } else {
+                    launch(jobs.last_item());
+                }
+            }
+            size_t sum = 0;
+            for (async<size_t>& pending : jobs) {
+                sum += co_await pending;
+            }
+            jobs.clear();
+            co_return sum;
+        }
+
+        /**
+         * @brief Frames resumed on calling thread only, like the main thread coroutines `tick_frame()` drains.
+         */
+        bool run_main_thread_frames(vector<async<size_t>>& jobs, main_thread_executor& executor, const int frames) {
+            bool is_correct = true;
+            for (int i = 0; i < frames; ++i) {
+                auto task = frame(jobs, &executor);
+                launch(task, executor);
+                while (!task->is_ready()) {
+                    executor.drain();
+                }
+                is_correct &= task->get_result() == expected_frame_sum;
+            }
+            return is_correct;
+        }
+
+        /**
+         * @brief Frames fanned out to the workers, so most frames are destroyed on another thread than they were
+         * spawned on.
+         */
+        bool run_worker_frames(vector<async<size_t>>& jobs, const int frames) {
+            bool is_correct = true;
+            for (int i = 0; i < frames; ++i) {
+                auto task = frame(jobs, nullptr);
+                core::execution::detail::parallel::block_on(task);
+                is_correct &= task->get_result() == expected_frame_sum;
+            }
+            return is_correct;
+        }
+
+        uint64_t get_system_allocations() {
+            return frame_allocator::get_global_stats().system_allocations;
+        }
+    }
+
+    /**
+     * Once the free lists are warm, coroutine frames of a frame are recycled from the ones of the previous frames.
+     * On a single thread that is exact, steady state frames must not fall back to the system allocator at all. Across
+     * workers, blocks cached by each worker add up to a bound depending on scheduling, so the pools might still grow
+     * a little after warming up, but never by a block per frame.
+     */
+    bool run_frame_allocator_benchmark() {
+        bool is_correct = true;
+        vector<async<size_t>> jobs(num_jobs_per_frame);
+
+        main_thread_executor executor{};
+        is_correct &= run_main_thread_frames(jobs, executor, num_warm_up_frames);
+        const uint64_t main_thread_begin = get_system_allocations();
+        report("1000 main thread frames, 256 jobs each", measure([&] {
+            is_correct &= run_main_thread_frames(jobs, executor, num_frames);
+        }, 1));
+        const uint64_t main_thread_system_allocations = get_system_allocations() - main_thread_begin;
+        report_count("system allocations, main thread frames", main_thread_system_allocations);
+        is_correct &= main_thread_system_allocations == 0;
+
+        is_correct &= run_worker_frames(jobs, num_warm_up_frames);
+        const uint64_t worker_begin = get_system_allocations();
+        report("1000 worker frames, 256 jobs each", measure([&] {
+            is_correct &= run_worker_frames(jobs, num_frames);
+        }, 1));
+        const uint64_t worker_system_allocations = get_system_allocations() - worker_begin;
+        report_count("system allocations, worker frames", worker_system_allocations);
+        is_correct &= worker_system_allocations < static_cast<uint64_t>(num_frames);
+
+        return is_correct;
+    }
+
+}
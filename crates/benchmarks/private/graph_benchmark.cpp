@@ -0,0 +1,100 @@
+#include "benchmark.h"
+#include "execution/graph.h"
+#include "execution/graph_executor.h"
+#include <atomic>
+#include <format>
+#include <random>
+#include <utility>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using namespace avalanche::core::execution;
+
+        constexpr int traversal_repeat = 20;
+
+        /**
+         * @brief Fill an empty graph as a random DAG with about 4 edges per node, wired forward so it never forms a cycle.
+         */
+        void populate_random_graph(Graph<TaskNode>& graph, const size_t num_nodes) {
+            using adjacency_list_type = Graph<TaskNode>::adjacency_list_type;
+
+            vector<shared_ptr<TaskNode>> nodes(num_nodes);
+            nodes.push_back(graph.default_root_node());
+
+            std::mt19937 random(3);
+            graph.begin_batch();
+            for (size_t i = 1; i < num_nodes; ++i) {
+                nodes.push_back(graph.new_node());
+                graph.add_edge(nodes[random() % i], nodes[i]);
+            }
+            for (size_t i = 0; i < 3 * num_nodes; ++i) {
+                size_t from = random() % num_nodes;
+                size_t to = random() % num_nodes;
+                if (from == to) {
+                    continue;
+                }
+                if (from > to) {
+                    std::swap(from, to);
+                }
+                if (graph.get_successors(static_cast<int64_t>(from)).find(static_cast<int64_t>(to)) == adjacency_list_type::npos) {
+                    graph.add_edge(nodes[from], nodes[to]);
+                }
+            }
+            graph.commit();
+        }
+
+        template <typename GraphType>
+        size_t traverse_in_order(const GraphType& graph) {
+            size_t sum = 0;
+            for (int i = 0; i < traversal_repeat; ++i) {
+                for (const auto nid : graph.get_topological_order()) {
+                    for (const auto next_nid : graph.get_successors(nid)) {
+                        sum += static_cast<size_t>(graph.get_node(next_nid).node_id());
+                    }
+                }
+            }
+            return sum;
+        }
+
+        bool run_graph_benchmark(const size_t num_nodes) {
+            Graph<TaskNode> graph(num_nodes);
+            populate_random_graph(graph, num_nodes);
+            CompiledGraph<TaskNode> compiled_graph = graph.compile();
+
+            size_t graph_sum = 0;
+            size_t compiled_sum = 0;
+            report(std::format("Graph traversal x{}, {} nodes", traversal_repeat, num_nodes).c_str(), measure([&] {
+                graph_sum = traverse_in_order(graph);
+            }));
+            report(std::format("CompiledGraph traversal x{}, {} nodes", traversal_repeat, num_nodes).c_str(), measure([&] {
+                compiled_sum = traverse_in_order(compiled_graph);
+            }));
+            consume(graph_sum);
+
+            std::atomic<size_t> num_executed{0};
+            for (size_t nid = 0; nid < compiled_graph.node_count(); ++nid) {
+                compiled_graph.get_node(static_cast<int64_t>(nid)).set_task([&num_executed] {
+                    num_executed.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            GraphExecutor<TaskNode, CompiledGraph<TaskNode>> executor(compiled_graph);
+            constexpr int execution_repeat = 3;
+            report(std::format("GraphExecutor run, {} nodes", num_nodes).c_str(), measure([&executor] {
+                executor.run();
+            }, execution_repeat));
+
+            return graph_sum == compiled_sum && num_executed.load() == num_nodes * execution_repeat;
+        }
+    }
+
+    bool run_graph_benchmark() {
+        bool is_correct = true;
+        for (const size_t num_nodes : { size_t{10000}, size_t{100000} }) {
+            is_correct &= run_graph_benchmark(num_nodes);
+        }
+        return is_correct;
+    }
+
+}
@@ -0,0 +1,118 @@
+#include "benchmark.h"
+#include "container/hash_map.hpp"
+#include "container/vector.hpp"
+#include <cstdint>
+#include <format>
+#include <random>
+#include <unordered_map>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        /**
+         * @brief Run the same operations on `hash_map` and `std::unordered_map`, with a few accessors bridging their APIs.
+         */
+        template <typename Map>
+        struct map_operations;
+
+        template <>
+        struct map_operations<hash_map<uint64_t, uint64_t>> {
+            using map_type = hash_map<uint64_t, uint64_t>;
+            static constexpr const char* name = "hash_map";
+
+            static uint64_t find(const map_type& map, const uint64_t key) {
+                const uint64_t* value = map.find(key);
+                return value != nullptr ? *value : 0;
+            }
+        };
+
+        template <>
+        struct map_operations<std::unordered_map<uint64_t, uint64_t>> {
+            using map_type = std::unordered_map<uint64_t, uint64_t>;
+            static constexpr const char* name = "std::unordered_map";
+
+            static uint64_t find(const map_type& map, const uint64_t key) {
+                const auto it = map.find(key);
+                return it != map.end() ? it->second : 0;
+            }
+        };
+
+        template <typename Map>
+        bool run_map_benchmark(const vector<uint64_t>& keys, const vector<uint64_t>& missing_keys, const int repeat) {
+            using operations = map_operations<Map>;
+            const size_t num_keys = keys.size();
+
+            Map map{};
+            report(std::format("{} insert x{}, {} keys", operations::name, repeat, num_keys).c_str(), measure([&] {
+                for (int i = 0; i < repeat; ++i) {
+                    map = Map{};
+                    for (const uint64_t key : keys) {
+                        map.insert_or_assign(key, key);
+                    }
+                }
+            }, 1));
+
+            uint64_t hit_sum = 0;
+            report(std::format("{} find hit x{}, {} keys", operations::name, repeat, num_keys).c_str(), measure([&] {
+                for (int i = 0; i < repeat; ++i) {
+                    for (const uint64_t key : keys) {
+                        hit_sum += operations::find(map, key);
+                    }
+                }
+            }, 1));
+
+            size_t num_found_missing = 0;
+            report(std::format("{} find miss x{}, {} keys", operations::name, repeat, num_keys).c_str(), measure([&] {
+                for (int i = 0; i < repeat; ++i) {
+                    for (const uint64_t key : missing_keys) {
+                        num_found_missing += map.contains(key);
+                    }
+                }
+            }, 1));
+
+            report(std::format("{} erase, {} keys", operations::name, num_keys).c_str(), measure([&] {
+                for (const uint64_t key : keys) {
+                    map.erase(key);
+                }
+            }, 1));
+
+            uint64_t expected_sum = 0;
+            for (const uint64_t key : keys) {
+                expected_sum += key;
+            }
+            consume(hit_sum);
+            return hit_sum == expected_sum * static_cast<uint64_t>(repeat) && num_found_missing == 0 && map.size() == 0;
+        }
+
+        /**
+         * @brief Distinct random keys, the first `num_keys` are inserted and the others are looked up as misses.
+         */
+        void generate_keys(const size_t num_keys, vector<uint64_t>& keys, vector<uint64_t>& missing_keys) {
+            std::mt19937_64 random(42);
+            std::unordered_map<uint64_t, bool> generated{};
+            generated.reserve(num_keys * 2);
+            while (generated.size() < num_keys * 2) {
+                const uint64_t key = random();
+                if (generated.emplace(key, true).second) {
+                    (generated.size() <= num_keys ? keys : missing_keys).push_back(key);
+                }
+            }
+        }
+    }
+
+    bool run_hash_map_benchmark() {
+        bool is_correct = true;
+        // Small maps stay in cache, repeat them so both sizes take comparable time
+        for (const auto [num_keys, repeat] : { std::pair<size_t, int>{1000, 1000}, std::pair<size_t, int>{1000000, 1} }) {
+            vector<uint64_t> keys(num_keys);
+            vector<uint64_t> missing_keys(num_keys);
+            generate_keys(num_keys, keys, missing_keys);
+
+            is_correct &= run_map_benchmark<hash_map<uint64_t, uint64_t>>(keys, missing_keys, repeat);
+            is_correct &= run_map_benchmark<std::unordered_map<uint64_t, uint64_t>>(keys, missing_keys, repeat);
+        }
+        return is_correct;
+    }
+
+}
@@ -0,0 +1,134 @@
+#include "benchmark.h"
+#include "container/impl/b_tree.hpp"
+#include "container/impl/red_black_tree.hpp"
+#include "container/vector.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <random>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        /**
+         * @brief Bridges the trees behind `map_base` and `std::map`, the baseline, to the same operations.
+         */
+        template <typename Map>
+        struct ordered_map_operations {
+            static void insert(Map& map, const uint64_t key) {
+                map.insert(key, key);
+            }
+
+            static uint64_t find(const Map& map, const uint64_t key) {
+                return map.get(key);
+            }
+
+            static uint64_t sum_keys(const Map& map) {
+                uint64_t sum = 0;
+                for (auto it = map.begin(); it != map.end(); ++it) {
+                    sum += it.key();
+                }
+                return sum;
+            }
+
+            static void erase(Map& map, const uint64_t key) {
+                map.remove(key);
+            }
+        };
+
+        template <>
+        struct ordered_map_operations<std::map<uint64_t, uint64_t>> {
+            using map_type = std::map<uint64_t, uint64_t>;
+
+            static void insert(map_type& map, const uint64_t key) {
+                map.emplace(key, key);
+            }
+
+            static uint64_t find(const map_type& map, const uint64_t key) {
+                return map.at(key);
+            }
+
+            static uint64_t sum_keys(const map_type& map) {
+                uint64_t sum = 0;
+                for (const auto& [key, value] : map) {
+                    sum += key;
+                }
+                return sum;
+            }
+
+            static void erase(map_type& map, const uint64_t key) {
+                map.erase(key);
+            }
+        };
+
+        template <typename Map>
+        bool run_ordered_map_benchmark(const char* name, const vector<uint64_t>& keys, const vector<uint64_t>& shuffled_keys) {
+            using operations = ordered_map_operations<Map>;
+            const size_t num_keys = keys.size();
+
+            uint64_t expected_sum = 0;
+            for (const uint64_t key : keys) {
+                expected_sum += key;
+            }
+
+            bool is_correct = true;
+            const auto label = [name, num_keys](const char* operation) {
+                return std::format("{} {}, {} keys", name, operation, num_keys);
+            };
+
+            Map map{};
+            report(label("insert").c_str(), measure([&] {
+                for (const uint64_t key : keys) {
+                    operations::insert(map, key);
+                }
+            }, 1));
+
+            uint64_t found_sum = 0;
+            report(label("find").c_str(), measure([&] {
+                for (const uint64_t key : shuffled_keys) {
+                    found_sum += operations::find(map, key);
+                }
+            }, 1));
+            is_correct &= found_sum == expected_sum;
+
+            uint64_t iterated_sum = 0;
+            report(label("iterate").c_str(), measure([&] {
+                iterated_sum = operations::sum_keys(map);
+            }, 1));
+            is_correct &= iterated_sum == expected_sum;
+
+            report(label("erase").c_str(), measure([&] {
+                for (const uint64_t key : shuffled_keys) {
+                    operations::erase(map, key);
+                }
+            }, 1));
+            is_correct &= operations::sum_keys(map) == 0;
+
+            consume(found_sum);
+            return is_correct;
+        }
+    }
+
+    bool run_ordered_map_benchmark() {
+        bool is_correct = true;
+        for (const size_t num_keys : { size_t{1000}, size_t{100000}, size_t{1000000} }) {
+            std::mt19937_64 random(42);
+            vector<uint64_t> keys(num_keys);
+            for (size_t i = 0; i < num_keys; ++i) {
+                // Distinct keys, so every map ends up with the same entries
+                keys.push_back((random() << 20) | i);
+            }
+            vector<uint64_t> shuffled_keys = keys;
+            std::shuffle(shuffled_keys.begin(), shuffled_keys.end(), random);
+
+            is_correct &= run_ordered_map_benchmark<RBTreeMap<uint64_t, uint64_t>>("RBTreeMap", keys, shuffled_keys);
+            is_correct &= run_ordered_map_benchmark<BTreeMap<uint64_t, uint64_t, std::less<uint64_t>, 8>>("BTreeMap<8>", keys, shuffled_keys);
+            is_correct &= run_ordered_map_benchmark<BTreeMap<uint64_t, uint64_t, std::less<uint64_t>, 16>>("BTreeMap<16>", keys, shuffled_keys);
+            is_correct &= run_ordered_map_benchmark<std::map<uint64_t, uint64_t>>("std::map", keys, shuffled_keys);
+        }
+        return is_correct;
+    }
+
+}
@@ -0,0 +1,61 @@
+#include "benchmark.h"
+#include "container/vector.hpp"
+#include "execution/parallel.h"
+#include <cmath>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using namespace avalanche::core::execution;
+
+        constexpr size_t num_elements = size_t{1} << 22;
+        constexpr size_t grain = 4096;
+
+        // Enough arithmetic per element that the loop isn't bound by memory bandwidth
+        double transform(double value) {
+            for (int i = 0; i < 16; ++i) {
+                value = std::sqrt(value * value + 1.0);
+            }
+            return value;
+        }
+    }
+
+    bool run_parallel_benchmark() {
+        vector<double> values(num_elements);
+        for (size_t i = 0; i < num_elements; ++i) {
+            values.emplace_back(static_cast<double>(i));
+        }
+
+        report("serial for, 4M elements", measure([&values] {
+            for (size_t i = 0; i < num_elements; ++i) {
+                values[i] = transform(values[i]);
+            }
+        }));
+        report("parallel_for, 4M elements", measure([&values] {
+            parallel_for(size_t{0}, num_elements, grain, [&values](const size_t i) {
+                values[i] = transform(values[i]);
+            });
+        }));
+
+        double serial_sum = 0;
+        report("serial reduce, 4M elements", measure([&values, &serial_sum] {
+            serial_sum = 0;
+            for (size_t i = 0; i < num_elements; ++i) {
+                serial_sum += values[i];
+            }
+        }));
+        double parallel_sum = 0;
+        report("parallel_reduce, 4M elements", measure([&values, &parallel_sum] {
+            parallel_sum = parallel_reduce(size_t{0}, num_elements, grain, 0.0, [&values](const size_t i) {
+                return values[i];
+            }, [](const double lhs, const double rhs) {
+                return lhs + rhs;
+            });
+        }));
+
+        // Chunks are summed in another order, only rounding differs
+        return std::abs(parallel_sum - serial_sum) <= serial_sum * 1e-9;
+    }
+
+}
@@ -0,0 +1,106 @@
+#include "benchmark.h"
+#include "container/allocator.hpp"
+#include "container/inplace_vector.hpp"
+#include "container/small_vector.hpp"
+#include "container/vector.hpp"
+#include <cstdint>
+#include <format>
+#include <random>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        size_t g_num_allocations = 0;
+
+        /**
+         * @brief `simple_allocator` counting every block it hands out, including reallocations.
+         */
+        template <typename T>
+        class counting_allocator : public simple_allocator<T> {
+        public:
+            using typename simple_allocator<T>::pointer_type;
+            using typename simple_allocator<T>::size_type;
+
+            pointer_type allocate(const size_type n, const void* hint = nullptr) {
+                ++g_num_allocations;
+                return simple_allocator<T>::allocate(n, hint);
+            }
+
+            pointer_type reallocate(pointer_type pointer, const size_type old_n, const size_type new_n) {
+                ++g_num_allocations;
+                return simple_allocator<T>::reallocate(pointer, old_n, new_n);
+            }
+        };
+
+        constexpr size_t num_lists = 100000;
+
+        /**
+         * @brief Fill `num_lists` lists with the given sizes, like building the adjacency lists of a graph.
+         * @return Sum of every element, to check and keep the work
+         */
+        template <typename List>
+        uint64_t build_lists(const vector<uint8_t>& sizes) {
+            vector<List> lists(num_lists);
+            for (const uint8_t size : sizes) {
+                lists.emplace_back();
+                List& list = lists.last_item();
+                for (uint8_t i = 0; i < size; ++i) {
+                    list.push_back(i);
+                }
+            }
+            uint64_t sum = 0;
+            for (const List& list : lists) {
+                for (const uint64_t value : list) {
+                    sum += value;
+                }
+            }
+            return sum;
+        }
+
+        template <typename List>
+        bool run_list_benchmark(const char* name, const vector<uint8_t>& sizes, const uint64_t expected_sum) {
+            g_num_allocations = 0;
+            uint64_t sum = 0;
+            const double milliseconds = measure([&sizes, &sum] {
+                sum = build_lists<List>(sizes);
+            }, 1);
+            report(std::format("{}, 100k lists", name).c_str(), milliseconds);
+            report_count(std::format("{} element allocations", name).c_str(), g_num_allocations);
+            return sum == expected_sum;
+        }
+
+        /**
+         * @brief Sizes of lists, up to `common_max` in most lists and up to `rare_max` in a few of them.
+         */
+        vector<uint8_t> generate_sizes(const uint8_t common_max, const uint8_t rare_max, uint64_t& expected_sum) {
+            std::mt19937 random(11);
+            vector<uint8_t> sizes(num_lists);
+            expected_sum = 0;
+            for (size_t i = 0; i < num_lists; ++i) {
+                const uint8_t size = static_cast<uint8_t>(random() % 10 == 0 ? random() % (rare_max + 1) : random() % (common_max + 1));
+                sizes.push_back(size);
+                expected_sum += static_cast<uint64_t>(size) * (size - (size > 0 ? 1 : 0)) / 2;
+            }
+            return sizes;
+        }
+    }
+
+    bool run_small_vector_benchmark() {
+        bool is_correct = true;
+        uint64_t expected_sum = 0;
+
+        // Adjacency lists in execution::Graph and dynamic offsets of a draw, a few spill past the inline capacity
+        const vector<uint8_t> short_sizes = generate_sizes(4, 12, expected_sum);
+        is_correct &= run_list_benchmark<vector<uint64_t, counting_allocator<uint64_t>>>("vector", short_sizes, expected_sum);
+        is_correct &= run_list_benchmark<small_vector<uint64_t, 4, counting_allocator<uint64_t>>>("small_vector<4>", short_sizes, expected_sum);
+
+        // Color attachments of a render pass, never more than 8 so inplace_vector never allocates
+        const vector<uint8_t> bounded_sizes = generate_sizes(8, 8, expected_sum);
+        is_correct &= run_list_benchmark<vector<uint64_t, counting_allocator<uint64_t>>>("vector, at most 8", bounded_sizes, expected_sum);
+        is_correct &= run_list_benchmark<inplace_vector<uint64_t, 8>>("inplace_vector<8>", bounded_sizes, expected_sum);
+
+        return is_correct;
+    }
+
+}
@@ -0,0 +1,92 @@
+#include "benchmark.h"
+#include "manager/tick_manager.h"
+#include "container/unique_ptr.hpp"
+#include "container/vector.hpp"
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using namespace avalanche::core;
+
+        constexpr size_t num_tickables = 100000;
+        constexpr int num_frames = 100;
+        constexpr tick_group_t num_groups = 9;
+
+        /**
+         * @brief Counts ticks and checks that groups tick in ascending order.
+         */
+        struct TickCounter {
+            size_t num_ticks = 0;
+            size_t num_out_of_order = 0;
+            tick_group_t last_group = 0;
+        };
+
+        class CountingTickable final : public ITickable {
+        public:
+            CountingTickable(TickCounter& counter, const tick_group_t group) : m_counter(counter), m_group(group) {}
+
+            void tick(duration_type) override {
+                if (m_group < m_counter.last_group) {
+                    ++m_counter.num_out_of_order;
+                }
+                m_counter.last_group = m_group;
+                ++m_counter.num_ticks;
+            }
+
+            AVALANCHE_NO_DISCARD tick_group_t group() const {
+                return m_group;
+            }
+
+        private:
+            TickCounter& m_counter;
+            tick_group_t m_group;
+        };
+
+        void tick_frames(ITickManager& manager, TickCounter& counter, const int frames) {
+            for (int i = 0; i < frames; ++i) {
+                counter.last_group = 0;
+                manager.tick_frame();
+            }
+        }
+    }
+
+    bool run_tick_manager_benchmark() {
+        ITickManager& manager = ITickManager::get();
+        TickCounter counter{};
+
+        vector<unique_ptr<CountingTickable>> tickables(num_tickables);
+        for (size_t i = 0; i < num_tickables; ++i) {
+            // Groups interleaved in registration order, so the tick list really has to be sorted
+            const auto group = static_cast<tick_group_t>(i * 7 % static_cast<size_t>(num_groups));
+            tickables.push_back(make_unique<CountingTickable>(counter, group));
+        }
+
+        report("register 100k tickables", measure([&manager, &tickables] {
+            for (const unique_ptr<CountingTickable>& tickable : tickables) {
+                manager.register_tickable(tickable.get(), tickable->group());
+            }
+        }, 1));
+        // The first frame rebuilds the tick list
+        report("first frame, 100k tickables", measure([&manager, &counter] {
+            tick_frames(manager, counter, 1);
+        }, 1));
+        report("100 frames, 100k tickables", measure([&manager, &counter] {
+            tick_frames(manager, counter, num_frames);
+        }, 1));
+        report("unregister 50k tickables", measure([&manager, &tickables] {
+            for (size_t i = 0; i < num_tickables; i += 2) {
+                manager.unregister_tickable(tickables[i].get());
+            }
+        }, 1));
+        tick_frames(manager, counter, 1);
+
+        for (size_t i = 1; i < num_tickables; i += 2) {
+            manager.unregister_tickable(tickables[i].get());
+        }
+
+        const size_t expected_ticks = num_tickables * (num_frames + 1) + num_tickables / 2;
+        return counter.num_out_of_order == 0 && counter.num_ticks == expected_ticks;
+    }
+
+}
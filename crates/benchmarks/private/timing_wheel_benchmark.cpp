@@ -0,0 +1,79 @@
+#include "benchmark.h"
+#include "container/timing_wheel.hpp"
+#include "container/vector.hpp"
+#include <cstdint>
+#include <format>
+#include <map>
+#include <random>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        using tick_type = timing_wheel<size_t>::tick_type;
+
+        constexpr size_t num_timers = 100000;
+        // Deadlines between 2 s and about 28 h in millisecond ticks, so timers land on several levels of the wheel
+        constexpr tick_type min_delay = 2000;
+        constexpr tick_type max_delay = 100000000;
+        constexpr tick_type advance_step = 16;
+
+        /**
+         * @brief Schedule every timer, then advance in frame sized steps until all of them expired.
+         * @return Sum of expired values
+         */
+        size_t run_timing_wheel(const vector<tick_type>& delays) {
+            timing_wheel<size_t> wheel{};
+            for (size_t i = 0; i < delays.size(); ++i) {
+                wheel.schedule(i, delays[i]);
+            }
+            size_t sum = 0;
+            while (!wheel.is_empty()) {
+                // Skip idle time like the executor does, waking up at the next occupied slot
+                const tick_type now = std::max(wheel.current_tick() + advance_step, wheel.earliest_deadline());
+                wheel.advance(now, [&sum](const size_t value) {
+                    sum += value;
+                });
+            }
+            return sum;
+        }
+
+        size_t run_ordered_map(const vector<tick_type>& delays) {
+            std::multimap<tick_type, size_t> timers{};
+            for (size_t i = 0; i < delays.size(); ++i) {
+                timers.emplace(delays[i], i);
+            }
+            size_t sum = 0;
+            tick_type current_tick = 0;
+            while (!timers.empty()) {
+                current_tick = std::max(current_tick + advance_step, timers.begin()->first);
+                while (!timers.empty() && timers.begin()->first <= current_tick) {
+                    sum += timers.begin()->second;
+                    timers.erase(timers.begin());
+                }
+            }
+            return sum;
+        }
+    }
+
+    bool run_timing_wheel_benchmark() {
+        vector<tick_type> delays(num_timers);
+        std::mt19937_64 random(7);
+        for (size_t i = 0; i < num_timers; ++i) {
+            delays.push_back(min_delay + random() % (max_delay - min_delay));
+        }
+
+        size_t wheel_sum = 0;
+        size_t map_sum = 0;
+        report(std::format("timing_wheel schedule and expire, {} timers", num_timers).c_str(), measure([&] {
+            wheel_sum = run_timing_wheel(delays);
+        }));
+        report(std::format("std::multimap schedule and expire, {} timers", num_timers).c_str(), measure([&] {
+            map_sum = run_ordered_map(delays);
+        }));
+
+        const size_t expected_sum = num_timers * (num_timers - 1) / 2;
+        return wheel_sum == expected_sum && map_sum == expected_sum;
+    }
+
+}
@@ -0,0 +1,63 @@
+#include "benchmark.h"
+#include "container/vector.hpp"
+#include <cstdint>
+#include <cstring>
+
+
+namespace avalanche::benchmark {
+
+    namespace {
+        constexpr size_t max_chunk_size = size_t{1} << 20;
+        constexpr size_t num_chunks = 1000;
+
+        /**
+         * @brief Read chunks of varying sizes into a reused buffer, like streaming a file in blocks.
+         */
+        template <typename Resize>
+        uint64_t read_chunks(vector<uint8_t>& buffer, Resize&& resize) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < num_chunks; ++i) {
+                const size_t chunk_size = (i * 7919) % max_chunk_size;
+                resize(buffer, chunk_size);
+                if (chunk_size > 0) {
+                    std::memset(buffer.data(), static_cast<int>(i & 0xff), chunk_size);
+                    sum += buffer[chunk_size - 1];
+                }
+            }
+            return sum;
+        }
+    }
+
+    bool run_vector_resize_benchmark() {
+        bool is_correct = true;
+
+        vector<uint8_t> initialized_buffer{};
+        uint64_t initialized_sum = 0;
+        report("resize, 1000 chunks up to 1 MiB", measure([&] {
+            initialized_sum = read_chunks(initialized_buffer, [](vector<uint8_t>& buffer, const size_t size) {
+                buffer.resize(size);
+            });
+        }));
+
+        vector<uint8_t> uninitialized_buffer{};
+        uint64_t uninitialized_sum = 0;
+        report("resize_uninitialized, 1000 chunks up to 1 MiB", measure([&] {
+            uninitialized_sum = read_chunks(uninitialized_buffer, [](vector<uint8_t>& buffer, const size_t size) {
+                buffer.resize_uninitialized(size);
+            });
+        }));
+        is_correct &= initialized_sum == uninitialized_sum;
+        consume(uninitialized_sum);
+
+        // Shrinking, even to nothing, must keep the buffer for the next chunk
+        const size_t capacity = uninitialized_buffer.capacity();
+        for (int i = 0; i < 20; ++i) {
+            uninitialized_buffer.resize_uninitialized(0);
+            uninitialized_buffer.resize_uninitialized(1);
+        }
+        is_correct &= uninitialized_buffer.capacity() == capacity && capacity >= max_chunk_size - 1 && capacity < 2 * max_chunk_size;
+
+        return is_correct;
+    }
+
+}
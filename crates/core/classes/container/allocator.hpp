@@ -12,6 +12,10 @@ namespace avalanche {
 
     AVALANCHE_CORE_API void* allocate_memory(size_t bytes, const void* hint = nullptr);
     AVALANCHE_CORE_API void deallocate_memory(void* pointer, size_t bytes);
+    /**
+     * @brief Resize a block from `allocate_memory`, in place if possible, its content is kept up to the smaller size.
+     */
+    AVALANCHE_CORE_API void* reallocate_memory(void* pointer, size_t old_bytes, size_t new_bytes);
 
     template <typename Allocator>
     concept AllocatorType = requires(Allocator allocator, typename Allocator::value_type* ptr, typename Allocator::size_type n, const void* hint)
@@ -52,6 +56,13 @@ namespace avalanche {
             deallocate_memory(pointer, n * sizeof(T));
         }
 
+        /**
+         * @brief Only valid for trivially relocatable `T`, elements are moved bytewise if the block can't grow in place.
+         */
+        pointer_type reallocate(pointer_type pointer, size_type old_n, size_type new_n) {
+            return static_cast<pointer_type>(reallocate_memory(pointer, old_n * sizeof(T), new_n * sizeof(T)));
+        }
+
         template <typename U, typename... Args>
         void construct(U* p, Args&&... args) {
             new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
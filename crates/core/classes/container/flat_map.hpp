@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include "container/vector.hpp"
+#include "container/utility.hpp"
+
+namespace avalanche {
+
+    /**
+     * @brief Ordered map stored as a vector of entries sorted by key.
+     *
+     * Lookups are binary searches over contiguous memory, which beats any tree for small or read-mostly maps such as
+     * config tables. Insertion and removal shift the entries after the position, and invalidate iterators and
+     * pointers to values. Build large maps at once from a vector of entries rather than one insertion at a time.
+     *
+     * Lookup is heterogeneous if `Compare` declares `is_transparent`.
+     */
+    template <typename Key, typename Value, typename Compare = std::less<Key>>
+    class flat_map {
+    public:
+        using key_type = Key;
+        using key_reference_type = key_type&;
+        using key_const_reference_type = const key_type&;
+        using value_type = Value;
+        using value_pointer_type = value_type*;
+        using value_const_pointer_type = const value_type*;
+        using size_type = size_t;
+        using value_reference_type = value_type&;
+        using value_const_reference_type = const value_type&;
+        using key_compare = Compare;
+        using entry_type = pair<key_type, value_type>;
+        using storage_type = vector<entry_type>;
+        // Keys must not be modified through iterators
+        using iterator = typename storage_type::iterator_type;
+        using const_iterator = typename storage_type::const_iterator_type;
+        using range_type = std::ranges::subrange<iterator>;
+        using const_range_type = std::ranges::subrange<const_iterator>;
+
+    private:
+        template <typename K>
+        static constexpr bool is_lookup_key = std::is_same_v<K, key_type> || (requires { typename Compare::is_transparent; });
+
+        storage_type m_entries{};
+        AVALANCHE_NO_UNIQUE_ADDRESS key_compare m_compare{};
+
+    public:
+        flat_map() = default;
+
+        explicit flat_map(key_compare compare) : m_compare(std::move(compare)) {}
+
+        flat_map(const std::initializer_list<entry_type> entries) : flat_map(storage_type(entries)) {}
+
+        /**
+         * @brief Sort `entries` once, later entries win over earlier ones with the same key.
+         */
+        explicit flat_map(storage_type entries, key_compare compare = key_compare{})
+            : m_entries(std::move(entries))
+            , m_compare(std::move(compare))
+        {
+            std::stable_sort(m_entries.begin(), m_entries.end(), [this](const entry_type& lhs, const entry_type& rhs) {
+                return m_compare(lhs.first, rhs.first);
+            });
+
+            size_type num_kept = 0;
+            for (size_type i = 0; i < m_entries.size(); ++i) {
+                if (num_kept > 0 && !m_compare(m_entries[num_kept - 1].first, m_entries[i].first)) {
+                    m_entries[num_kept - 1] = std::move(m_entries[i]);
+                } else {
+                    if (num_kept != i) {
+                        m_entries[num_kept] = std::move(m_entries[i]);
+                    }
+                    ++num_kept;
+                }
+            }
+            while (m_entries.size() > num_kept) {
+                m_entries.remove_last();
+            }
+        }
+
+        AVALANCHE_NO_DISCARD size_type size() const AVALANCHE_NOEXCEPT {
+            return m_entries.size();
+        }
+
+        AVALANCHE_NO_DISCARD bool is_empty() const AVALANCHE_NOEXCEPT {
+            return m_entries.is_empty();
+        }
+
+        AVALANCHE_NO_DISCARD size_type capacity() const AVALANCHE_NOEXCEPT {
+            return m_entries.capacity();
+        }
+
+        void reserve(const size_type count) {
+            m_entries.ensure_capacity(count);
+        }
+
+        void clear() {
+            m_entries.clear();
+        }
+
+        void reset() {
+            clear();
+        }
+
+        void swap(flat_map& other) AVALANCHE_NOEXCEPT {
+            m_entries.swap(other.m_entries);
+            std::swap(m_compare, other.m_compare);
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        value_pointer_type find(const K& key) {
+            iterator it = find_entry(key);
+            return it != end() ? &it->second : nullptr;
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        value_const_pointer_type find(const K& key) const {
+            const_iterator it = find_entry(key);
+            return it != end() ? &it->second : nullptr;
+        }
+
+        value_pointer_type find(key_const_reference_type key) {
+            return find<key_type>(key);
+        }
+
+        value_const_pointer_type find(key_const_reference_type key) const {
+            return find<key_type>(key);
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        iterator find_entry(const K& key) {
+            iterator it = lower_bound(key);
+            return it != end() && !m_compare(key, it->first) ? it : end();
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        const_iterator find_entry(const K& key) const {
+            const_iterator it = lower_bound(key);
+            return it != end() && !m_compare(key, it->first) ? it : end();
+        }
+
+        value_reference_type get(key_const_reference_type key) {
+            value_pointer_type ptr = find(key);
+            AVALANCHE_CHECK(nullptr != ptr, "Trying visit a non-exist item in flat_map");
+            return *ptr;
+        }
+
+        value_const_reference_type get(key_const_reference_type key) const {
+            value_const_pointer_type ptr = find(key);
+            AVALANCHE_CHECK(nullptr != ptr, "Trying visit a non-exist item in flat_map");
+            return *ptr;
+        }
+
+        value_reference_type operator[](key_const_reference_type key) {
+            return get(key);
+        }
+
+        value_const_reference_type operator[](key_const_reference_type key) const {
+            return get(key);
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        bool contains(const K& key) const {
+            return find_entry(key) != end();
+        }
+
+        bool contains(key_const_reference_type key) const {
+            return find_entry(key) != end();
+        }
+
+        value_type get_or_default(key_const_reference_type key, value_const_reference_type default_value) const {
+            value_const_pointer_type value = find(key);
+            return value != nullptr ? *value : default_value;
+        }
+
+        template <typename X = key_type, typename Y = value_type>
+        requires std::convertible_to<const X&, key_const_reference_type> && std::convertible_to<Y, value_type>
+        void insert(const X& key, Y&& value) {
+            auto [it, is_inserted] = try_emplace(static_cast<key_const_reference_type>(key), std::forward<Y>(value));
+            if (!is_inserted) {
+                it->second = std::forward<Y>(value);
+            }
+        }
+
+        template <typename X = key_type, typename Y = value_type>
+        requires std::convertible_to<const X&, key_const_reference_type> && std::convertible_to<const Y&, value_type >
+        bool insert_if_not_exist(const X& key, Y&& value) {
+            return try_emplace(static_cast<key_const_reference_type>(key), std::forward<Y>(value)).second;
+        }
+
+        /**
+         * @brief Construct the value from `args` if `key` is absent, otherwise nothing is touched.
+         * @return The entry of `key`, and whether it was inserted
+         */
+        template <typename... Args>
+        pair<iterator, bool> try_emplace(key_const_reference_type key, Args&&... args) {
+            iterator it = lower_bound(key);
+            if (it != end() && !m_compare(key, it->first)) {
+                return { it, false };
+            }
+            const auto index = static_cast<size_type>(it - begin());
+            // Appending is the common case when entries come in order
+            if (index == m_entries.size()) {
+                m_entries.emplace_back(key, value_type(std::forward<Args>(args)...));
+            } else {
+                m_entries.emplace_at(index, key, value_type(std::forward<Args>(args)...));
+            }
+            return { begin() + index, true };
+        }
+
+        template <typename X = key_type>
+        requires std::convertible_to<const X&, const key_type&>
+        bool remove(const X& key) {
+            iterator it = find_entry(static_cast<key_const_reference_type>(key));
+            if (it == end()) {
+                return false;
+            }
+            erase(it);
+            return true;
+        }
+
+        template <typename X = key_type>
+        requires std::convertible_to<const X&, const key_type&>
+        value_type pop(const X& key) {
+            iterator it = find_entry(static_cast<key_const_reference_type>(key));
+            AVALANCHE_CHECK(it != end(), "Trying pop a non-exist item in flat_map");
+            value_type value = std::move(it->second);
+            erase(it);
+            return value;
+        }
+
+        /**
+         * @return Iterator to the entry following the erased one
+         */
+        iterator erase(const_iterator position) {
+            const auto index = static_cast<size_type>(position - begin());
+            m_entries.remove_at(index);
+            return begin() + index;
+        }
+
+        /**
+         * @return Iterator to the first entry whose key is not less than `key`
+         */
+        template <typename K>
+        requires is_lookup_key<K>
+        iterator lower_bound(const K& key) {
+            return begin() + (std::as_const(*this).lower_bound(key) - std::as_const(*this).begin());
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        const_iterator lower_bound(const K& key) const {
+            return search(key, [this](const entry_type& entry, const K& value) {
+                return m_compare(entry.first, value);
+            });
+        }
+
+        /**
+         * @return Iterator to the first entry whose key is greater than `key`
+         */
+        template <typename K>
+        requires is_lookup_key<K>
+        iterator upper_bound(const K& key) {
+            return begin() + (std::as_const(*this).upper_bound(key) - std::as_const(*this).begin());
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        const_iterator upper_bound(const K& key) const {
+            return search(key, [this](const entry_type& entry, const K& value) {
+                return !m_compare(value, entry.first);
+            });
+        }
+
+        /**
+         * @brief Entries whose key is in [from, to), in key order. Empty if `to` is less than `from`.
+         */
+        range_type range(key_const_reference_type from, key_const_reference_type to) {
+            if (m_compare(to, from)) {
+                return { end(), end() };
+            }
+            return { lower_bound(from), lower_bound(to) };
+        }
+
+        const_range_type range(key_const_reference_type from, key_const_reference_type to) const {
+            if (m_compare(to, from)) {
+                return { end(), end() };
+            }
+            return { lower_bound(from), lower_bound(to) };
+        }
+
+        iterator begin() AVALANCHE_NOEXCEPT {
+            return m_entries.begin();
+        }
+
+        iterator end() AVALANCHE_NOEXCEPT {
+            return m_entries.end();
+        }
+
+        const_iterator begin() const AVALANCHE_NOEXCEPT {
+            return m_entries.begin();
+        }
+
+        const_iterator end() const AVALANCHE_NOEXCEPT {
+            return m_entries.end();
+        }
+
+    private:
+        /**
+         * @brief Branchless binary search, returns the first entry for which `is_before(entry, key)` is false.
+         *
+         * The halving step compiles to a conditional move, lookups with unpredictable keys don't pay for mispredicted
+         * branches, which is what makes `std::lower_bound` slower than a tree on small maps.
+         */
+        template <typename K, typename Predicate>
+        const_iterator search(const K& key, Predicate is_before) const {
+            const_iterator base = begin();
+            size_type count = size();
+            if (count == 0) {
+                return base;
+            }
+            while (count > 1) {
+                const size_type half = count / 2;
+                base = is_before(base[half], key) ? base + half : base;
+                count -= half;
+            }
+            return base + static_cast<size_type>(is_before(*base, key));
+        }
+    };
+
+}
@@ -1,15 +1,31 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "container/allocator.hpp"
 #include "container/vector.hpp"
 #include "container/utility.hpp"
-#include "container/optional.hpp"
+#include "container/impl/swiss_table_group.hpp"
 
 namespace avalanche {
 
-    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    /**
+     * @brief Open addressing hash map in the Swiss table design.
+     *
+     * Every slot has a 1-byte control next to the others, holding 7 bits of the hash if it is full. A lookup matches 16
+     * controls at once with SIMD and only compares the keys of matching slots, probing group by group until a group
+     * with an empty slot. Entries are stored inline, so pointers to them are invalidated by rehashing.
+     *
+     * Lookup is heterogeneous if both `Hash` and `KeyEqual` declare `is_transparent`.
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
     class hash_map {
     public:
         using key_type = Key;
@@ -22,95 +38,239 @@ namespace avalanche {
         using value_reference_type = value_type&;
         using value_const_reference_type = const value_type&;
         using hash_impl = Hash;
+        using key_equal = KeyEqual;
         using hash_key_size = size_t;
-        using node_type = optional<pair<key_type, value_type>>;
-        using bucket_type = vector<node_type>;
-        using bucket_iterator = typename bucket_type::iterator_type;
+        // The key of an entry must not be modified through iterators
+        using entry_type = pair<key_type, value_type>;
         using load_factor_type = float;
 
     private:
-        hash_impl m_hasher {};
-        bucket_type m_buckets{};
-        size_type m_size = 0;
-        load_factor_type m_load_factor_to_scale = 0.75;
-        static constexpr size_type default_size = 8;
-
-        size_type index_of_key(key_const_reference_type key) const {
-            return m_hasher(key) % m_buckets.size();
-        }
-
-        void rehash() {
-            size_type new_size = m_buckets.size() * 2;
-            bucket_type new_buckets(new_size);
-            new_buckets.set_size_defaulted(new_size);
-            for (const node_type& node : m_buckets) {
-                if (node) {
-                    size_type index = m_hasher(node->first) % new_size;
-                    while (new_buckets[index]) {
-                        index = (index + 1) % new_size;
-                    }
-                    new_buckets[index] = node;
+        using control_type = detail::swiss_table::control_type;
+        using control_group = detail::swiss_table::control_group;
+        static constexpr size_type group_width = detail::swiss_table::group_width;
+        static constexpr size_type npos = static_cast<size_type>(-1);
+        static constexpr load_factor_type max_load_factor = 0.875f;
+
+        static_assert(alignof(entry_type) <= alignof(std::max_align_t), "Over-aligned entries aren't supported by hash_map");
+
+        template <typename K>
+        static constexpr bool is_lookup_key = std::is_same_v<K, key_type>
+            || (requires { typename Hash::is_transparent; typename KeyEqual::is_transparent; });
+
+        template <bool IsConst>
+        class iterator_base {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::conditional_t<IsConst, const entry_type, entry_type>;
+            using pointer = value_type*;
+            using reference = value_type&;
+
+            iterator_base() = default;
+
+            iterator_base(const control_type* control, const control_type* control_end, pointer slot) AVALANCHE_NOEXCEPT
+                : m_control(control)
+                , m_control_end(control_end)
+                , m_slot(slot)
+            {
+                skip_non_full();
+            }
+
+            template <bool OtherIsConst>
+            requires (IsConst && !OtherIsConst)
+            iterator_base(const iterator_base<OtherIsConst>& other) AVALANCHE_NOEXCEPT
+                : m_control(other.m_control)
+                , m_control_end(other.m_control_end)
+                , m_slot(other.m_slot)
+            {}
+
+            reference operator*() const AVALANCHE_NOEXCEPT {
+                return *m_slot;
+            }
+
+            pointer operator->() const AVALANCHE_NOEXCEPT {
+                return m_slot;
+            }
+
+            iterator_base& operator++() AVALANCHE_NOEXCEPT {
+                ++m_control;
+                ++m_slot;
+                skip_non_full();
+                return *this;
+            }
+
+            iterator_base operator++(int) AVALANCHE_NOEXCEPT {
+                iterator_base previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const iterator_base& other) const AVALANCHE_NOEXCEPT {
+                return m_control == other.m_control;
+            }
+
+        private:
+            friend class hash_map;
+            template <bool> friend class iterator_base;
+
+            void skip_non_full() AVALANCHE_NOEXCEPT {
+                while (m_control != m_control_end && !detail::swiss_table::is_full(*m_control)) {
+                    ++m_control;
+                    ++m_slot;
                 }
             }
-            m_buckets.swap(new_buckets);
-        }
+
+            const control_type* m_control = nullptr;
+            const control_type* m_control_end = nullptr;
+            pointer m_slot = nullptr;
+        };
 
     public:
-        hash_map() : m_buckets(default_size) {
-            m_buckets.set_size_defaulted(default_size);
+        using iterator = iterator_base<false>;
+        using const_iterator = iterator_base<true>;
+
+        hash_map() = default;
+
+        hash_map(const std::initializer_list<entry_type> entries) {
+            reserve(entries.size());
+            for (const entry_type& entry : entries) {
+                insert_or_assign(entry.first, entry.second);
+            }
+        }
+
+        // Delegating makes the map fully constructed before copying, so a throwing copy of an entry still runs the
+        // destructor and frees the entries copied so far
+        hash_map(const hash_map& other) : hash_map() {
+            m_hasher = other.m_hasher;
+            m_key_equal = other.m_key_equal;
+            m_load_factor_to_scale = other.m_load_factor_to_scale;
+            reserve(other.m_size);
+            for (const entry_type& entry : other) {
+                emplace_new(hash_of(entry.first), entry.first, entry.second);
+            }
+        }
+
+        hash_map(hash_map&& other) AVALANCHE_NOEXCEPT
+            : m_hasher(std::move(other.m_hasher))
+            , m_key_equal(std::move(other.m_key_equal))
+            , m_controls(std::exchange(other.m_controls, nullptr))
+            , m_slots(std::exchange(other.m_slots, nullptr))
+            , m_capacity(std::exchange(other.m_capacity, 0))
+            , m_size(std::exchange(other.m_size, 0))
+            , m_growth_left(std::exchange(other.m_growth_left, 0))
+            , m_load_factor_to_scale(other.m_load_factor_to_scale)
+        {}
+
+        hash_map& operator=(const hash_map& other) {
+            if (this != &other) {
+                hash_map copy(other);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        hash_map& operator=(hash_map&& other) AVALANCHE_NOEXCEPT {
+            if (this != &other) {
+                hash_map moved(std::move(other));
+                swap(moved);
+            }
+            return *this;
+        }
+
+        ~hash_map() {
+            destroy_and_deallocate();
+        }
+
+        void swap(hash_map& other) AVALANCHE_NOEXCEPT {
+            std::swap(m_hasher, other.m_hasher);
+            std::swap(m_key_equal, other.m_key_equal);
+            std::swap(m_controls, other.m_controls);
+            std::swap(m_slots, other.m_slots);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_size, other.m_size);
+            std::swap(m_growth_left, other.m_growth_left);
+            std::swap(m_load_factor_to_scale, other.m_load_factor_to_scale);
         }
 
         template <typename U = value_type>
         requires std::is_default_constructible_v<U> && std::convertible_to<U, value_type>
         bool insert_defaulted_if_absent(key_const_reference_type key) {
-            if (!contains(key)) {
-                insert_or_assign(key, U{});
-                return true;
-            }
-            return false;
+            return try_emplace(key).second;
         }
 
-        void insert_or_assign(key_const_reference_type key, value_const_reference_type value) {
-            if (m_size >= m_buckets.size() * m_load_factor_to_scale) { // Scale while load coefficient >= 0.75
-                rehash();
+        /**
+         * @return true if inserted, false if an existing value was assigned
+         */
+        template <typename V>
+        requires std::is_assignable_v<value_reference_type, V&&> && std::is_constructible_v<value_type, V&&>
+        bool insert_or_assign(key_const_reference_type key, V&& value) {
+            auto [slot, is_inserted] = find_or_insert(key, [&](const size_type new_slot) {
+                construct_at(new_slot, key, std::forward<V>(value));
+            });
+            if (!is_inserted) {
+                m_slots[slot].second = std::forward<V>(value);
             }
+            return is_inserted;
+        }
 
-            size_type index = index_of_key(key);
-            while (m_buckets[index]) {
-                if (m_buckets[index]->first == key) {
-                    m_buckets[index]->second = value; // update
-                    return;
-                }
-                index = (index + 1) % m_buckets.size();
+        template <typename V>
+        requires std::is_assignable_v<value_reference_type, V&&> && std::is_constructible_v<value_type, V&&>
+        bool insert_or_assign(key_type&& key, V&& value) {
+            auto [slot, is_inserted] = find_or_insert(key, [&](const size_type new_slot) {
+                construct_at(new_slot, std::move(key), std::forward<V>(value));
+            });
+            if (!is_inserted) {
+                m_slots[slot].second = std::forward<V>(value);
             }
-            m_buckets[index] = make_pair(key, value); // insert
-            ++m_size;
+            return is_inserted;
+        }
+
+        /**
+         * @brief Construct the value from `args` if `key` is absent, otherwise nothing is touched.
+         * @return The entry of `key`, and whether it was inserted
+         */
+        template <typename... Args>
+        pair<iterator, bool> try_emplace(key_const_reference_type key, Args&&... args) {
+            auto [slot, is_inserted] = find_or_insert(key, [&](const size_type new_slot) {
+                construct_at(new_slot, key, value_type(std::forward<Args>(args)...));
+            });
+            return { iterator_at(slot), is_inserted };
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        value_pointer_type find(const K& key) {
+            const size_type slot = find_slot(key);
+            return slot != npos ? &m_slots[slot].second : nullptr;
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        value_const_pointer_type find(const K& key) const {
+            const size_type slot = find_slot(key);
+            return slot != npos ? &m_slots[slot].second : nullptr;
         }
 
         value_pointer_type find(key_const_reference_type key) {
-            size_type index = index_of_key(key);
-            size_type count = 0;
-            while (m_buckets[index] && count < m_buckets.size()) {
-                if (m_buckets[index]->first == key) {
-                    return &m_buckets[index]->second;
-                }
-                index = (index + 1) % m_buckets.size();
-                ++count;
-            }
-            return nullptr;
+            return find<key_type>(key);
         }
 
         value_const_pointer_type find(key_const_reference_type key) const {
-            size_type index = index_of_key(key);
-            size_type count = 0;
-            while (m_buckets[index] && count < m_buckets.size()) {
-                if (m_buckets[index]->first == key) {
-                    return &m_buckets[index]->second;
-                }
-                index = (index + 1) % m_buckets.size();
-                ++count;
-            }
-            return nullptr;
+            return find<key_type>(key);
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        iterator find_entry(const K& key) {
+            const size_type slot = find_slot(key);
+            return slot != npos ? iterator_at(slot) : end();
+        }
+
+        template <typename K>
+        requires is_lookup_key<K>
+        const_iterator find_entry(const K& key) const {
+            const size_type slot = find_slot(key);
+            return slot != npos ? const_iterator(m_controls + slot, m_controls + m_capacity, m_slots + slot) : end();
         }
 
         value_reference_type get(key_const_reference_type key) {
@@ -120,18 +280,76 @@ namespace avalanche {
         }
 
         value_const_reference_type get(key_const_reference_type key) const {
-            value_pointer_type ptr = find(key);
+            value_const_pointer_type ptr = find(key);
             AVALANCHE_CHECK(nullptr != ptr, "Trying visit a non-exist item in HashMap");
             return *ptr;
         }
 
+        template <typename K>
+        requires is_lookup_key<K>
+        bool contains(const K& key) const {
+            return find_slot(key) != npos;
+        }
+
         bool contains(key_const_reference_type key) const {
-            return find(key);
+            return find_slot(key) != npos;
+        }
+
+        /**
+         * @return true if `key` was present
+         */
+        template <typename K>
+        requires is_lookup_key<K>
+        bool erase(const K& key) {
+            const size_type slot = find_slot(key);
+            if (slot == npos) {
+                return false;
+            }
+            erase_slot(slot);
+            return true;
+        }
+
+        bool erase(key_const_reference_type key) {
+            return erase<key_type>(key);
+        }
+
+        /**
+         * @return Iterator to the entry following the erased one
+         */
+        iterator erase(const_iterator position) {
+            const auto slot = static_cast<size_type>(position.m_control - m_controls);
+            erase_slot(slot);
+            return iterator(m_controls + slot + 1, m_controls + m_capacity, m_slots + slot + 1);
         }
 
+        void clear() {
+            if (m_capacity == 0) {
+                return;
+            }
+            destroy_entries();
+            std::memset(m_controls, detail::swiss_table::empty_control, m_capacity);
+            m_size = 0;
+            m_growth_left = max_size_of_capacity(m_capacity);
+        }
+
+        /**
+         * @brief Make room for `count` entries in total without rehashing.
+         */
+        void reserve(const size_type count) {
+            if (count > m_size + m_growth_left) {
+                resize(capacity_for(count));
+            }
+        }
+
+        /**
+         * @brief Rehashed when the load factor exceeds it, capped to 0.875 so that probing always meets empty slots.
+         */
         void set_load_factor(load_factor_type new_factor) {
             AVALANCHE_CHECK(new_factor < 0.9 && new_factor > 0.05, "Load factor must only set to less than 0.9 and lager than 0.05");
-            m_load_factor_to_scale = new_factor;
+            m_load_factor_to_scale = std::min(new_factor, max_load_factor);
+            if (m_capacity > 0) {
+                resize(capacity_for(m_size));
+            }
         }
 
         value_reference_type operator[](key_const_reference_type key) {
@@ -141,6 +359,251 @@ namespace avalanche {
         value_const_reference_type operator[](key_const_reference_type key) const {
             return get(key);
         }
+
+        AVALANCHE_NO_DISCARD size_type size() const AVALANCHE_NOEXCEPT {
+            return m_size;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_empty() const AVALANCHE_NOEXCEPT {
+            return m_size == 0;
+        }
+
+        AVALANCHE_NO_DISCARD size_type capacity() const AVALANCHE_NOEXCEPT {
+            return m_capacity;
+        }
+
+        iterator begin() AVALANCHE_NOEXCEPT {
+            return iterator(m_controls, m_controls + m_capacity, m_slots);
+        }
+
+        iterator end() AVALANCHE_NOEXCEPT {
+            return iterator(m_controls + m_capacity, m_controls + m_capacity, m_slots + m_capacity);
+        }
+
+        const_iterator begin() const AVALANCHE_NOEXCEPT {
+            return const_iterator(m_controls, m_controls + m_capacity, m_slots);
+        }
+
+        const_iterator end() const AVALANCHE_NOEXCEPT {
+            return const_iterator(m_controls + m_capacity, m_controls + m_capacity, m_slots + m_capacity);
+        }
+
+    private:
+        /**
+         * @brief Groups visited by a lookup, triangular steps visit every group once since their number is power of two.
+         */
+        class probe_sequence {
+        public:
+            probe_sequence(const size_t hash, const size_type group_mask) AVALANCHE_NOEXCEPT
+                : m_group_mask(group_mask)
+                , m_group(detail::swiss_table::h1(hash) & group_mask)
+            {}
+
+            AVALANCHE_NO_DISCARD size_type offset() const AVALANCHE_NOEXCEPT {
+                return m_group * group_width;
+            }
+
+            void next() AVALANCHE_NOEXCEPT {
+                ++m_step;
+                m_group = (m_group + m_step) & m_group_mask;
+            }
+
+        private:
+            size_type m_group_mask;
+            size_type m_group;
+            size_type m_step = 0;
+        };
+
+        template <typename K>
+        AVALANCHE_NO_DISCARD size_t hash_of(const K& key) const {
+            return detail::swiss_table::mix_hash(m_hasher(key));
+        }
+
+        AVALANCHE_NO_DISCARD size_type group_mask() const AVALANCHE_NOEXCEPT {
+            return m_capacity / group_width - 1;
+        }
+
+        template <typename K>
+        AVALANCHE_NO_DISCARD size_type find_slot(const K& key) const {
+            if (m_size == 0) {
+                return npos;
+            }
+            const size_t hash = hash_of(key);
+            const control_type h2 = detail::swiss_table::h2(hash);
+            for (probe_sequence probe(hash, group_mask());; probe.next()) {
+                const control_group group(m_controls + probe.offset());
+                for (const uint32_t index : group.match(h2)) {
+                    const size_type slot = probe.offset() + index;
+                    if (m_key_equal(m_slots[slot].first, key)) AVALANCHE_LIKELY_BRANCH {
+                        return slot;
+                    }
+                }
+                if (group.match_empty().has_any()) AVALANCHE_LIKELY_BRANCH {
+                    return npos;
+                }
+            }
+        }
+
+        /**
+         * @brief First empty or deleted slot on the probe sequence of `hash`.
+         */
+        AVALANCHE_NO_DISCARD size_type find_free_slot(const size_t hash) const AVALANCHE_NOEXCEPT {
+            for (probe_sequence probe(hash, group_mask());; probe.next()) {
+                const control_group group(m_controls + probe.offset());
+                if (const auto free_slots = group.match_empty_or_deleted(); free_slots.has_any()) {
+                    return probe.offset() + free_slots.lowest();
+                }
+            }
+        }
+
+        /**
+         * @brief Find `key`, or call `construct(slot)` to construct its entry in a free slot.
+         *
+         * The slot is only marked as full once constructed, if `construct` throws the map is left without the entry.
+         * @return The slot of `key`, and whether it was inserted
+         */
+        template <typename Constructor>
+        pair<size_type, bool> find_or_insert(key_const_reference_type key, Constructor&& construct) {
+            if (const size_type slot = find_slot(key); slot != npos) {
+                return { slot, false };
+            }
+            const size_t hash = hash_of(key);
+            size_type slot = m_capacity > 0 ? find_free_slot(hash) : npos;
+            // A deleted slot is reused for free, only an empty one consumes the growth
+            if (slot == npos || (m_growth_left == 0 && m_controls[slot] == detail::swiss_table::empty_control)) {
+                grow_or_purge();
+                slot = find_free_slot(hash);
+            }
+            construct(slot);
+            publish_slot(slot, hash);
+            return { slot, true };
+        }
+
+        /**
+         * @brief For copying from a map known to have no duplicates and enough room.
+         */
+        template <typename... Args>
+        void emplace_new(const size_t hash, Args&&... args) {
+            const size_type slot = find_free_slot(hash);
+            construct_at(slot, std::forward<Args>(args)...);
+            publish_slot(slot, hash);
+        }
+
+        /**
+         * @brief Mark a free slot as full once its entry has been constructed.
+         */
+        void publish_slot(const size_type slot, const size_t hash) AVALANCHE_NOEXCEPT {
+            if (m_controls[slot] == detail::swiss_table::empty_control) {
+                --m_growth_left;
+            }
+            m_controls[slot] = detail::swiss_table::h2(hash);
+            ++m_size;
+        }
+
+        template <typename... Args>
+        void construct_at(const size_type slot, Args&&... args) {
+            new (static_cast<void*>(m_slots + slot)) entry_type(std::forward<Args>(args)...);
+        }
+
+        void erase_slot(const size_type slot) {
+            m_slots[slot].~entry_type();
+            --m_size;
+            // A group which has an empty slot was never full, so no probe sequence went past it and the slot could be
+            // emptied again. Otherwise it is a tombstone, which keeps lookups probing further.
+            const size_type group_offset = slot - slot % group_width;
+            if (control_group(m_controls + group_offset).match_empty().has_any()) {
+                m_controls[slot] = detail::swiss_table::empty_control;
+                ++m_growth_left;
+            } else {
+                m_controls[slot] = detail::swiss_table::deleted_control;
+            }
+        }
+
+        iterator iterator_at(const size_type slot) AVALANCHE_NOEXCEPT {
+            return iterator(m_controls + slot, m_controls + m_capacity, m_slots + slot);
+        }
+
+        AVALANCHE_NO_DISCARD size_type max_size_of_capacity(const size_type capacity) const AVALANCHE_NOEXCEPT {
+            const auto max_size = static_cast<size_type>(static_cast<load_factor_type>(capacity) * m_load_factor_to_scale);
+            // Probing needs at least one empty slot
+            return std::min(max_size, capacity - 1);
+        }
+
+        AVALANCHE_NO_DISCARD size_type capacity_for(const size_type count) const AVALANCHE_NOEXCEPT {
+            size_type capacity = group_width;
+            while (max_size_of_capacity(capacity) < count) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        /**
+         * @brief Out of empty slots, either double the capacity or rehash in place if most of the used ones are tombstones.
+         */
+        void grow_or_purge() {
+            if (m_capacity > 0 && m_size + 1 <= max_size_of_capacity(m_capacity) / 2) {
+                resize(m_capacity);
+            } else {
+                resize(capacity_for(m_size + 1));
+            }
+        }
+
+        void resize(const size_type new_capacity) {
+            control_type* old_controls = m_controls;
+            entry_type* old_slots = m_slots;
+            const size_type old_capacity = m_capacity;
+
+            // Controls and slots share one allocation, slots begin at a multiple of 16 bytes
+            auto* memory = static_cast<std::byte*>(allocate_memory(new_capacity + new_capacity * sizeof(entry_type)));
+            m_controls = reinterpret_cast<control_type*>(memory);
+            m_slots = reinterpret_cast<entry_type*>(memory + new_capacity);
+            m_capacity = new_capacity;
+            std::memset(m_controls, detail::swiss_table::empty_control, new_capacity);
+            m_size = 0;
+            m_growth_left = max_size_of_capacity(new_capacity);
+
+            for (size_type i = 0; i < old_capacity; ++i) {
+                if (detail::swiss_table::is_full(old_controls[i])) {
+                    emplace_new(hash_of(old_slots[i].first), std::move(old_slots[i]));
+                    old_slots[i].~entry_type();
+                }
+            }
+
+            if (old_controls != nullptr) {
+                deallocate_memory(old_controls, old_capacity + old_capacity * sizeof(entry_type));
+            }
+        }
+
+        void destroy_entries() {
+            if constexpr (!std::is_trivially_destructible_v<entry_type>) {
+                for (size_type i = 0; i < m_capacity; ++i) {
+                    if (detail::swiss_table::is_full(m_controls[i])) {
+                        m_slots[i].~entry_type();
+                    }
+                }
+            }
+        }
+
+        void destroy_and_deallocate() {
+            if (m_controls != nullptr) {
+                destroy_entries();
+                deallocate_memory(m_controls, m_capacity + m_capacity * sizeof(entry_type));
+                m_controls = nullptr;
+                m_slots = nullptr;
+                m_capacity = 0;
+                m_size = 0;
+                m_growth_left = 0;
+            }
+        }
+
+        AVALANCHE_NO_UNIQUE_ADDRESS hash_impl m_hasher {};
+        AVALANCHE_NO_UNIQUE_ADDRESS key_equal m_key_equal {};
+        control_type* m_controls = nullptr;
+        entry_type* m_slots = nullptr;
+        size_type m_capacity = 0;
+        size_type m_size = 0;
+        size_type m_growth_left = 0;
+        load_factor_type m_load_factor_to_scale = max_load_factor;
     };
 
 }
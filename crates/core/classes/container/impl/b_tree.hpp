@@ -0,0 +1,783 @@
+#pragma once
+
+/**
+ * Ordered map backed by a B+ tree, an alternative to `RBTreeMap` where ordered iteration and lookups dominate.
+ *
+ * Every entry lives in a leaf, keys and values in separate arrays so that searching a node only touches its keys.
+ * Inner nodes hold copies of keys as separators, and leaves are chained for iteration. A node holds up to `MaxKeys`
+ * keys, which keeps a node within a few cache lines for small keys.
+ *
+ * Unlike `RBTreeMap`, entries move between nodes on insertion and removal, which invalidates iterators.
+ */
+
+#include "container/exception.hpp"
+#include "container/impl/node_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace avalanche {
+    template<typename Key, typename Value, typename Compare = std::less<Key>, size_t MaxKeys = 16>
+    class BTreeMap {
+        static_assert(MaxKeys >= 4 && MaxKeys <= UINT16_MAX, "Unsupported node size");
+        static_assert(std::is_copy_constructible_v<Key>, "Separators in inner nodes are copies of keys");
+
+    private:
+        using USize = size_t;
+        using K = const Key &;
+        using V = const Value &;
+
+        // Both a merge and a borrow keep nodes within [MIN_KEYS, MaxKeys]
+        static constexpr USize MIN_KEYS = (MaxKeys - 1) / 2;
+        // Enough for any tree addressable in memory, even with every node at MIN_KEYS
+        static constexpr USize MAX_DEPTH = 64;
+
+        AVALANCHE_NO_UNIQUE_ADDRESS Compare compare = Compare();
+
+        struct NodeBase {
+            uint16_t count = 0;
+            bool isLeaf;
+
+            explicit NodeBase(bool leaf) noexcept : isLeaf(leaf) {
+            }
+        };
+
+        struct LeafNode : NodeBase {
+            LeafNode *prev = nullptr;
+            LeafNode *next = nullptr;
+
+            // Constructed and destroyed one by one, only the first `count` are alive
+            union { Key keys[MaxKeys]; };
+            union { Value values[MaxKeys]; };
+
+            LeafNode() noexcept : NodeBase(true) {
+            }
+
+            ~LeafNode() {
+                std::destroy_n(this->keys, this->count);
+                std::destroy_n(this->values, this->count);
+            }
+        };
+
+        struct InnerNode : NodeBase {
+            // Keys of `children[i]` are less than `keys[i]`, keys of `children[i + 1]` are not
+            union { Key keys[MaxKeys]; };
+            NodeBase *children[MaxKeys + 1];
+
+            InnerNode() noexcept : NodeBase(false) {
+            }
+
+            ~InnerNode() {
+                std::destroy_n(this->keys, this->count);
+            }
+        };
+
+        struct PathStep {
+            InnerNode *node;
+            USize childIndex;
+        };
+
+        NodeBase *root = nullptr;
+        LeafNode *head = nullptr;
+        LeafNode *tail = nullptr;
+        USize count = 0;
+        node_pool<LeafNode> leafPool;
+        node_pool<InnerNode, 64> innerPool;
+
+    public:
+        class NoSuchMappingException : protected exception_base {
+        private:
+            const char *message;
+
+        public:
+            explicit NoSuchMappingException(const char *msg) : message(msg) {
+            }
+
+            AVALANCHE_NO_DISCARD const char *what() const noexcept override { return message; }
+        };
+
+        /**
+         * In-order bidirectional iterator over the leaf chain, `end()` is represented by a null leaf.
+         */
+        template<bool IsConst>
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() noexcept = default;
+
+            template<bool OtherIsConst> requires (IsConst && !OtherIsConst)
+            Iterator(const Iterator<OtherIsConst> &other) noexcept
+                : leaf(other.leaf), index(other.index), tree(other.tree) {
+            }
+
+            K key() const noexcept { return this->leaf->keys[this->index]; }
+
+            std::conditional_t<IsConst, V, Value &> value() const noexcept { return this->leaf->values[this->index]; }
+
+            Iterator &operator++() noexcept {
+                if (++this->index == this->leaf->count) {
+                    this->leaf = this->leaf->next;
+                    this->index = 0;
+                }
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept {
+                Iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            Iterator &operator--() noexcept {
+                if (this->leaf == nullptr) {
+                    this->leaf = this->tree->tail;
+                    this->index = this->leaf->count;
+                } else if (this->index == 0) {
+                    this->leaf = this->leaf->prev;
+                    this->index = this->leaf->count;
+                }
+                --this->index;
+                return *this;
+            }
+
+            Iterator operator--(int) noexcept {
+                Iterator previous = *this;
+                --*this;
+                return previous;
+            }
+
+            bool operator==(const Iterator &rhs) const noexcept {
+                return this->leaf == rhs.leaf && this->index == rhs.index;
+            }
+
+            bool operator!=(const Iterator &rhs) const noexcept { return !(*this == rhs); }
+
+        private:
+            friend class BTreeMap;
+            template<bool> friend class Iterator;
+
+            Iterator(LeafNode *l, USize i, const BTreeMap *t) noexcept : leaf(l), index(i), tree(t) {
+            }
+
+            LeafNode *leaf = nullptr;
+            USize index = 0;
+            const BTreeMap *tree = nullptr;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        BTreeMap() noexcept = default;
+
+        explicit BTreeMap(Compare comp) noexcept(std::is_nothrow_move_constructible_v<Compare>)
+            : compare(std::move(comp)) {
+        }
+
+        BTreeMap(const BTreeMap &other) : compare(other.compare), count(other.count) {
+            if (other.root != nullptr) {
+                this->root = this->cloneSubtree(other.root);
+            }
+        }
+
+        BTreeMap(BTreeMap &&other) noexcept
+            : compare(std::move(other.compare))
+            , root(std::exchange(other.root, nullptr))
+            , head(std::exchange(other.head, nullptr))
+            , tail(std::exchange(other.tail, nullptr))
+            , count(std::exchange(other.count, 0))
+            , leafPool(std::move(other.leafPool))
+            , innerPool(std::move(other.innerPool)) {
+        }
+
+        BTreeMap &operator=(const BTreeMap &other) {
+            if (this != &other) {
+                BTreeMap copy(other);
+                this->swap(copy);
+            }
+            return *this;
+        }
+
+        BTreeMap &operator=(BTreeMap &&other) noexcept {
+            if (this != &other) {
+                this->clear();
+                this->swap(other);
+            }
+            return *this;
+        }
+
+        ~BTreeMap() noexcept {
+            this->clear();
+        }
+
+        void swap(BTreeMap &other) noexcept {
+            std::swap(this->compare, other.compare);
+            std::swap(this->root, other.root);
+            std::swap(this->head, other.head);
+            std::swap(this->tail, other.tail);
+            std::swap(this->count, other.count);
+            this->leafPool.swap(other.leafPool);
+            this->innerPool.swap(other.innerPool);
+        }
+
+        inline USize size() const noexcept { return this->count; }
+
+        inline bool empty() const noexcept { return this->count == 0; }
+
+        void clear() noexcept {
+            if constexpr (!std::is_trivially_destructible_v<Key> || !std::is_trivially_destructible_v<Value>) {
+                if (this->root != nullptr) {
+                    this->destroySubtree(this->root);
+                }
+            }
+            this->leafPool.release();
+            this->innerPool.release();
+            this->root = nullptr;
+            this->head = nullptr;
+            this->tail = nullptr;
+            this->count = 0;
+        }
+
+        iterator begin() noexcept { return iterator(this->head, 0, this); }
+
+        const_iterator begin() const noexcept { return const_iterator(this->head, 0, this); }
+
+        iterator end() noexcept { return iterator(nullptr, 0, this); }
+
+        const_iterator end() const noexcept { return const_iterator(nullptr, 0, this); }
+
+        iterator find(K key) noexcept {
+            iterator it = this->lowerBound(key);
+            return it != this->end() && !compare(key, it.key()) ? it : this->end();
+        }
+
+        const_iterator find(K key) const noexcept { return const_cast<BTreeMap *>(this)->find(key); }
+
+        /**
+         * Returns an iterator to the first entry whose key is not less than the specified key.
+         */
+        iterator lowerBound(K key) noexcept {
+            if (this->root == nullptr) {
+                return this->end();
+            }
+            LeafNode *leaf = this->findLeaf(key, nullptr, nullptr);
+            return this->makeIterator(leaf, this->lowerIndex(leaf->keys, leaf->count, key));
+        }
+
+        const_iterator lowerBound(K key) const noexcept { return const_cast<BTreeMap *>(this)->lowerBound(key); }
+
+        /**
+         * Returns an iterator to the first entry whose key is greater than the specified key.
+         */
+        iterator upperBound(K key) noexcept {
+            if (this->root == nullptr) {
+                return this->end();
+            }
+            LeafNode *leaf = this->findLeaf(key, nullptr, nullptr);
+            return this->makeIterator(leaf, this->upperIndex(leaf->keys, leaf->count, key));
+        }
+
+        const_iterator upperBound(K key) const noexcept { return const_cast<BTreeMap *>(this)->upperBound(key); }
+
+        /**
+         * Returns the value to which the specified key is mapped, or throws a {@code NoSuchMappingException}.
+         */
+        Value &get(K key) {
+            iterator it = this->find(key);
+            if (it == this->end()) {
+                raise_exception(NoSuchMappingException("Invalid key"));
+            }
+            return it.value();
+        }
+
+        const Value &get(K key) const {
+            return const_cast<BTreeMap *>(this)->get(key);
+        }
+
+        bool contains(K key) const {
+            return this->find(key) != this->end();
+        }
+
+        Value &getOrDefault(K key) {
+            return this->tryEmplace(key).first.value();
+        }
+
+        void insert(K key, V value) {
+            auto [it, inserted] = this->tryEmplace(key, value);
+            if (!inserted) {
+                it.value() = value;
+            }
+        }
+
+        void insert(K key, Value &&value) {
+            auto [it, inserted] = this->tryEmplace(key, std::move(value));
+            if (!inserted) {
+                it.value() = std::move(value);
+            }
+        }
+
+        bool insertIfAbsent(K key, V value) {
+            return this->tryEmplace(key, value).second;
+        }
+
+        Value &getOrInsert(K key, V value) {
+            return this->tryEmplace(key, value).first.value();
+        }
+
+        const Value &operator[](K key) const { return this->get(key); }
+
+        Value &operator[](K key) { return this->getOrDefault(key); }
+
+        /**
+         * If the specified key is absent, inserts a value constructed from the arguments.
+         * @return the entry of the key, and whether it has been inserted
+         */
+        template<typename... Args>
+        std::pair<iterator, bool> tryEmplace(K key, Args &&... args) {
+            if (this->root == nullptr) {
+                LeafNode *leaf = this->leafPool.create();
+                this->root = leaf;
+                this->head = leaf;
+                this->tail = leaf;
+            }
+
+            PathStep path[MAX_DEPTH];
+            USize depth = 0;
+            LeafNode *leaf = this->findLeaf(key, path, &depth);
+            USize index = this->lowerIndex(leaf->keys, leaf->count, key);
+            if (index < leaf->count && !compare(key, leaf->keys[index])) {
+                return {iterator(leaf, index, this), false};
+            }
+
+            if (leaf->count == MaxKeys) {
+                // The right half starts at `split`, a new entry right at the boundary stays left of the separator
+                const USize split = (MaxKeys + 1) / 2;
+                LeafNode *right = this->splitLeaf(leaf, split);
+                this->insertIntoParent(path, depth, leaf, right->keys[0], right);
+                if (index > split) {
+                    leaf = right;
+                    index -= split;
+                }
+            }
+
+            shiftRight(leaf->keys, index, leaf->count);
+            shiftRight(leaf->values, index, leaf->count);
+            std::construct_at(&leaf->keys[index], key);
+            std::construct_at(&leaf->values[index], std::forward<Args>(args)...);
+            leaf->count += 1;
+            this->count += 1;
+            return {iterator(leaf, index, this), true};
+        }
+
+        /**
+         * Removes the mapping for a key from this map if it is present.
+         * @return true if the mapping was present
+         */
+        bool remove(K key) {
+            return this->removeKey(key, nullptr);
+        }
+
+        /**
+         * Removes the mapping for a key and returns its value, or throws a {@code NoSuchMappingException}.
+         */
+        Value getAndRemove(K key) {
+            union Removed {
+                Value value;
+
+                Removed() noexcept {
+                }
+
+                ~Removed() {
+                }
+            } removed;
+            if (!this->removeKey(key, &removed.value)) {
+                raise_exception(NoSuchMappingException("Invalid key"));
+            }
+            Value result = std::move(removed.value);
+            std::destroy_at(&removed.value);
+            return result;
+        }
+
+        void forEach(const std::function<void(K, V)> &action) const {
+            for (const LeafNode *leaf = this->head; leaf != nullptr; leaf = leaf->next) {
+                for (USize i = 0; i < leaf->count; ++i) {
+                    action(leaf->keys[i], leaf->values[i]);
+                }
+            }
+        }
+
+        void forEachMut(const std::function<void(K, Value &)> &action) {
+            for (LeafNode *leaf = this->head; leaf != nullptr; leaf = leaf->next) {
+                for (USize i = 0; i < leaf->count; ++i) {
+                    action(leaf->keys[i], leaf->values[i]);
+                }
+            }
+        }
+
+    private:
+        // Nodes are small, a linear scan beats a binary search on branch prediction
+        USize lowerIndex(const Key *keys, USize n, K key) const noexcept {
+            USize i = 0;
+            while (i < n && compare(keys[i], key)) {
+                ++i;
+            }
+            return i;
+        }
+
+        USize upperIndex(const Key *keys, USize n, K key) const noexcept {
+            USize i = 0;
+            while (i < n && !compare(key, keys[i])) {
+                ++i;
+            }
+            return i;
+        }
+
+        iterator makeIterator(LeafNode *leaf, USize index) noexcept {
+            // Past the last key of a leaf, the position belongs to the next one
+            if (index == leaf->count) {
+                return iterator(leaf->next, 0, this);
+            }
+            return iterator(leaf, index, this);
+        }
+
+        /**
+         * Descends to the leaf which should hold the key, recording the inner nodes on the way if `path` is provided.
+         */
+        LeafNode *findLeaf(K key, PathStep *path, USize *depth) const noexcept {
+            NodeBase *node = this->root;
+            while (!node->isLeaf) {
+                auto *inner = static_cast<InnerNode *>(node);
+                const USize childIndex = this->upperIndex(inner->keys, inner->count, key);
+                if (path != nullptr) {
+                    path[(*depth)++] = PathStep{inner, childIndex};
+                }
+                node = inner->children[childIndex];
+            }
+            return static_cast<LeafNode *>(node);
+        }
+
+        /**
+         * Moves `items[from, n)` one slot to the right, leaving `items[from]` uninitialized.
+         */
+        template<typename T>
+        static void shiftRight(T *items, USize from, USize n) noexcept {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                std::memmove(static_cast<void *>(items + from + 1), items + from, (n - from) * sizeof(T));
+            } else {
+                for (USize i = n; i > from; --i) {
+                    std::construct_at(&items[i], std::move(items[i - 1]));
+                    std::destroy_at(&items[i - 1]);
+                }
+            }
+        }
+
+        /**
+         * Moves `items[from + 1, n)` one slot to the left, `items[from]` must be uninitialized.
+         */
+        template<typename T>
+        static void shiftLeft(T *items, USize from, USize n) noexcept {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                std::memmove(static_cast<void *>(items + from), items + from + 1, (n - from - 1) * sizeof(T));
+            } else {
+                for (USize i = from; i + 1 < n; ++i) {
+                    std::construct_at(&items[i], std::move(items[i + 1]));
+                    std::destroy_at(&items[i + 1]);
+                }
+            }
+        }
+
+        /**
+         * Moves `n` items into uninitialized `destination`, leaving `source` uninitialized.
+         */
+        template<typename T>
+        static void relocate(T *destination, T *source, USize n) noexcept {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                std::memcpy(static_cast<void *>(destination), source, n * sizeof(T));
+            } else {
+                for (USize i = 0; i < n; ++i) {
+                    std::construct_at(&destination[i], std::move(source[i]));
+                    std::destroy_at(&source[i]);
+                }
+            }
+        }
+
+        LeafNode *splitLeaf(LeafNode *leaf, USize split) {
+            LeafNode *right = this->leafPool.create();
+            relocate(right->keys, leaf->keys + split, leaf->count - split);
+            relocate(right->values, leaf->values + split, leaf->count - split);
+            right->count = static_cast<uint16_t>(leaf->count - split);
+            leaf->count = static_cast<uint16_t>(split);
+
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next != nullptr) {
+                leaf->next->prev = right;
+            } else {
+                this->tail = right;
+            }
+            leaf->next = right;
+            return right;
+        }
+
+        /**
+         * Links `right`, split from `left`, into the parent recorded at `path[depth - 1]`, splitting ancestors as needed.
+         */
+        void insertIntoParent(PathStep *path, USize depth, NodeBase *left, K separator, NodeBase *right) {
+            if (depth == 0) {
+                InnerNode *newRoot = this->innerPool.create();
+                std::construct_at(&newRoot->keys[0], separator);
+                newRoot->children[0] = left;
+                newRoot->children[1] = right;
+                newRoot->count = 1;
+                this->root = newRoot;
+                return;
+            }
+
+            InnerNode *parent = path[depth - 1].node;
+            USize index = path[depth - 1].childIndex;
+            if (parent->count < MaxKeys) {
+                this->insertIntoInner(parent, index, separator, right);
+                return;
+            }
+
+            // Promote the middle key, then place the new separator into the half it belongs to
+            const USize middle = MaxKeys / 2;
+            InnerNode *sibling = this->innerPool.create();
+            relocate(sibling->keys, parent->keys + middle + 1, MaxKeys - middle - 1);
+            std::memcpy(sibling->children, parent->children + middle + 1, (MaxKeys - middle) * sizeof(NodeBase *));
+            sibling->count = static_cast<uint16_t>(MaxKeys - middle - 1);
+
+            Key promoted = std::move(parent->keys[middle]);
+            std::destroy_at(&parent->keys[middle]);
+            parent->count = static_cast<uint16_t>(middle);
+
+            if (index <= middle) {
+                this->insertIntoInner(parent, index, separator, right);
+            } else {
+                this->insertIntoInner(sibling, index - middle - 1, separator, right);
+            }
+            this->insertIntoParent(path, depth - 1, parent, promoted, sibling);
+        }
+
+        static void insertIntoInner(InnerNode *node, USize index, K separator, NodeBase *right) {
+            shiftRight(node->keys, index, node->count);
+            std::memmove(node->children + index + 2, node->children + index + 1,
+                         (node->count - index) * sizeof(NodeBase *));
+            std::construct_at(&node->keys[index], separator);
+            node->children[index + 1] = right;
+            node->count += 1;
+        }
+
+        static void removeFromInner(InnerNode *node, USize keyIndex) noexcept {
+            // Drops `keys[keyIndex]` and the child right of it
+            std::destroy_at(&node->keys[keyIndex]);
+            shiftLeft(node->keys, keyIndex, node->count);
+            std::memmove(node->children + keyIndex + 1, node->children + keyIndex + 2,
+                         (node->count - keyIndex - 1) * sizeof(NodeBase *));
+            node->count -= 1;
+        }
+
+        bool removeKey(K key, Value *removedValue) {
+            if (this->root == nullptr) {
+                return false;
+            }
+
+            PathStep path[MAX_DEPTH];
+            USize depth = 0;
+            LeafNode *leaf = this->findLeaf(key, path, &depth);
+            const USize index = this->lowerIndex(leaf->keys, leaf->count, key);
+            if (index == leaf->count || compare(key, leaf->keys[index])) {
+                return false;
+            }
+
+            if (removedValue != nullptr) {
+                std::construct_at(removedValue, std::move(leaf->values[index]));
+            }
+            std::destroy_at(&leaf->keys[index]);
+            std::destroy_at(&leaf->values[index]);
+            shiftLeft(leaf->keys, index, leaf->count);
+            shiftLeft(leaf->values, index, leaf->count);
+            leaf->count -= 1;
+            this->count -= 1;
+
+            // Stale separators are fine, they still split the key ranges of their children correctly
+            NodeBase *node = leaf;
+            while (depth > 0 && node->count < MIN_KEYS) {
+                const PathStep step = path[--depth];
+                if (!this->rebalance(step.node, step.childIndex)) {
+                    break;
+                }
+                node = step.node;
+            }
+
+            if (this->root->count == 0) {
+                if (this->root->isLeaf) {
+                    this->leafPool.destroy(static_cast<LeafNode *>(this->root));
+                    this->root = nullptr;
+                    this->head = nullptr;
+                    this->tail = nullptr;
+                } else {
+                    auto *oldRoot = static_cast<InnerNode *>(this->root);
+                    this->root = oldRoot->children[0];
+                    this->innerPool.destroy(oldRoot);
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Refills the underflowing child of `parent`, borrowing from a sibling or merging with one.
+         * @return true if merged, in which case `parent` lost a key and may underflow in turn
+         */
+        bool rebalance(InnerNode *parent, USize childIndex) {
+            NodeBase *left = childIndex > 0 ? parent->children[childIndex - 1] : nullptr;
+            NodeBase *right = childIndex < parent->count ? parent->children[childIndex + 1] : nullptr;
+
+            if (left != nullptr && left->count > MIN_KEYS) {
+                this->borrowFromLeft(parent, childIndex);
+                return false;
+            }
+            if (right != nullptr && right->count > MIN_KEYS) {
+                this->borrowFromRight(parent, childIndex);
+                return false;
+            }
+            this->merge(parent, left != nullptr ? childIndex - 1 : childIndex);
+            return true;
+        }
+
+        void borrowFromLeft(InnerNode *parent, USize childIndex) {
+            const USize separatorIndex = childIndex - 1;
+            if (parent->children[childIndex]->isLeaf) {
+                auto *leaf = static_cast<LeafNode *>(parent->children[childIndex]);
+                auto *left = static_cast<LeafNode *>(parent->children[separatorIndex]);
+                shiftRight(leaf->keys, 0, leaf->count);
+                shiftRight(leaf->values, 0, leaf->count);
+                relocate(leaf->keys, left->keys + left->count - 1, 1);
+                relocate(leaf->values, left->values + left->count - 1, 1);
+                leaf->count += 1;
+                left->count -= 1;
+                parent->keys[separatorIndex] = leaf->keys[0];
+            } else {
+                auto *inner = static_cast<InnerNode *>(parent->children[childIndex]);
+                auto *left = static_cast<InnerNode *>(parent->children[separatorIndex]);
+                // Rotate through the parent: its separator comes down, the last key of the left sibling goes up
+                shiftRight(inner->keys, 0, inner->count);
+                std::memmove(inner->children + 1, inner->children, (inner->count + 1) * sizeof(NodeBase *));
+                relocate(inner->keys, parent->keys + separatorIndex, 1);
+                inner->children[0] = left->children[left->count];
+                inner->count += 1;
+                relocate(parent->keys + separatorIndex, left->keys + left->count - 1, 1);
+                left->count -= 1;
+            }
+        }
+
+        void borrowFromRight(InnerNode *parent, USize childIndex) {
+            const USize separatorIndex = childIndex;
+            if (parent->children[childIndex]->isLeaf) {
+                auto *leaf = static_cast<LeafNode *>(parent->children[childIndex]);
+                auto *right = static_cast<LeafNode *>(parent->children[separatorIndex + 1]);
+                relocate(leaf->keys + leaf->count, right->keys, 1);
+                relocate(leaf->values + leaf->count, right->values, 1);
+                shiftLeft(right->keys, 0, right->count);
+                shiftLeft(right->values, 0, right->count);
+                leaf->count += 1;
+                right->count -= 1;
+                parent->keys[separatorIndex] = right->keys[0];
+            } else {
+                auto *inner = static_cast<InnerNode *>(parent->children[childIndex]);
+                auto *right = static_cast<InnerNode *>(parent->children[separatorIndex + 1]);
+                relocate(inner->keys + inner->count, parent->keys + separatorIndex, 1);
+                inner->children[inner->count + 1] = right->children[0];
+                inner->count += 1;
+                relocate(parent->keys + separatorIndex, right->keys, 1);
+                shiftLeft(right->keys, 0, right->count);
+                std::memmove(right->children, right->children + 1, right->count * sizeof(NodeBase *));
+                right->count -= 1;
+            }
+        }
+
+        /**
+         * Merges `children[separatorIndex + 1]` into `children[separatorIndex]`.
+         */
+        void merge(InnerNode *parent, USize separatorIndex) {
+            NodeBase *leftBase = parent->children[separatorIndex];
+            NodeBase *rightBase = parent->children[separatorIndex + 1];
+            if (leftBase->isLeaf) {
+                auto *left = static_cast<LeafNode *>(leftBase);
+                auto *right = static_cast<LeafNode *>(rightBase);
+                relocate(left->keys + left->count, right->keys, right->count);
+                relocate(left->values + left->count, right->values, right->count);
+                left->count += right->count;
+                right->count = 0;
+
+                left->next = right->next;
+                if (right->next != nullptr) {
+                    right->next->prev = left;
+                } else {
+                    this->tail = left;
+                }
+                this->leafPool.destroy(right);
+            } else {
+                auto *left = static_cast<InnerNode *>(leftBase);
+                auto *right = static_cast<InnerNode *>(rightBase);
+                // The separator comes down between both halves
+                std::construct_at(&left->keys[left->count], parent->keys[separatorIndex]);
+                relocate(left->keys + left->count + 1, right->keys, right->count);
+                std::memcpy(left->children + left->count + 1, right->children, (right->count + 1) * sizeof(NodeBase *));
+                left->count += right->count + 1;
+                right->count = 0;
+                this->innerPool.destroy(right);
+            }
+            removeFromInner(parent, separatorIndex);
+        }
+
+        NodeBase *cloneSubtree(const NodeBase *source) {
+            if (source->isLeaf) {
+                const auto *sourceLeaf = static_cast<const LeafNode *>(source);
+                LeafNode *leaf = this->leafPool.create();
+                for (USize i = 0; i < sourceLeaf->count; ++i) {
+                    std::construct_at(&leaf->keys[i], sourceLeaf->keys[i]);
+                    std::construct_at(&leaf->values[i], sourceLeaf->values[i]);
+                    leaf->count += 1;
+                }
+                // Leaves are cloned in order, append to the chain
+                leaf->prev = this->tail;
+                if (this->tail != nullptr) {
+                    this->tail->next = leaf;
+                } else {
+                    this->head = leaf;
+                }
+                this->tail = leaf;
+                return leaf;
+            }
+
+            const auto *sourceInner = static_cast<const InnerNode *>(source);
+            InnerNode *inner = this->innerPool.create();
+            inner->children[0] = this->cloneSubtree(sourceInner->children[0]);
+            for (USize i = 0; i < sourceInner->count; ++i) {
+                std::construct_at(&inner->keys[i], sourceInner->keys[i]);
+                inner->children[i + 1] = this->cloneSubtree(sourceInner->children[i + 1]);
+                inner->count += 1;
+            }
+            return inner;
+        }
+
+        void destroySubtree(NodeBase *node) noexcept {
+            if (node->isLeaf) {
+                this->leafPool.destroy(static_cast<LeafNode *>(node));
+                return;
+            }
+            auto *inner = static_cast<InnerNode *>(node);
+            for (USize i = 0; i <= inner->count; ++i) {
+                this->destroySubtree(inner->children[i]);
+            }
+            this->innerPool.destroy(inner);
+        }
+    };
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "polyfill.h"
+#include "container/allocator.hpp"
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace avalanche {
+
+    /**
+     * @brief Allocator of fixed size nodes for node based containers, not thread safe.
+     *
+     * Nodes are carved from chunks which grow geometrically, freed nodes are recycled through an intrusive free list.
+     * Chunks are only returned to the system when the pool is destroyed or `release()` is called.
+     */
+    template <typename T, size_t MaxNodesPerChunk = 256>
+    class node_pool {
+    public:
+        using value_type = T;
+        using size_type = size_t;
+
+        node_pool() = default;
+
+        node_pool(const node_pool&) = delete;
+        node_pool& operator=(const node_pool&) = delete;
+
+        node_pool(node_pool&& other) AVALANCHE_NOEXCEPT
+            : m_chunks(std::exchange(other.m_chunks, nullptr))
+            , m_free_list(std::exchange(other.m_free_list, nullptr))
+            , m_next_chunk_size(std::exchange(other.m_next_chunk_size, min_nodes_per_chunk))
+        {}
+
+        node_pool& operator=(node_pool&& other) AVALANCHE_NOEXCEPT {
+            if (this != &other) {
+                release();
+                m_chunks = std::exchange(other.m_chunks, nullptr);
+                m_free_list = std::exchange(other.m_free_list, nullptr);
+                m_next_chunk_size = std::exchange(other.m_next_chunk_size, min_nodes_per_chunk);
+            }
+            return *this;
+        }
+
+        ~node_pool() {
+            release();
+        }
+
+        void swap(node_pool& other) AVALANCHE_NOEXCEPT {
+            std::swap(m_chunks, other.m_chunks);
+            std::swap(m_free_list, other.m_free_list);
+            std::swap(m_next_chunk_size, other.m_next_chunk_size);
+        }
+
+        template <typename... Args>
+        T* create(Args&&... args) {
+            if (m_free_list == nullptr) AVALANCHE_UNLIKELY_BRANCH {
+                grow();
+            }
+            slot* node = m_free_list;
+            m_free_list = node->next;
+            return new (static_cast<void*>(node->storage)) T(std::forward<Args>(args)...);
+        }
+
+        void destroy(T* node) AVALANCHE_NOEXCEPT {
+            node->~T();
+            auto* freed = reinterpret_cast<slot*>(node);
+            freed->next = m_free_list;
+            m_free_list = freed;
+        }
+
+        /**
+         * @brief Return every chunk to the system, nodes still alive are dropped without being destroyed.
+         */
+        void release() AVALANCHE_NOEXCEPT {
+            while (m_chunks != nullptr) {
+                chunk_header* next = m_chunks->next;
+                deallocate_memory(m_chunks, chunk_bytes(m_chunks->num_slots));
+                m_chunks = next;
+            }
+            m_free_list = nullptr;
+            m_next_chunk_size = min_nodes_per_chunk;
+        }
+
+    private:
+        static constexpr size_type min_nodes_per_chunk = MaxNodesPerChunk < 8 ? MaxNodesPerChunk : 8;
+
+        union slot {
+            slot* next;
+            alignas(T) std::byte storage[sizeof(T)];
+        };
+
+        struct chunk_header {
+            chunk_header* next;
+            size_type num_slots;
+        };
+
+        static_assert(alignof(slot) <= alignof(std::max_align_t), "Over-aligned nodes aren't supported by node_pool");
+
+        // Slots begin right after the header, rounded up to their alignment
+        static constexpr size_type slots_offset = (sizeof(chunk_header) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+
+        static constexpr size_type chunk_bytes(const size_type num_slots) AVALANCHE_NOEXCEPT {
+            return slots_offset + num_slots * sizeof(slot);
+        }
+
+        void grow() {
+            const size_type num_slots = m_next_chunk_size;
+            auto* memory = static_cast<std::byte*>(allocate_memory(chunk_bytes(num_slots)));
+            auto* header = new (memory) chunk_header{ m_chunks, num_slots };
+            m_chunks = header;
+
+            auto* slots = reinterpret_cast<slot*>(memory + slots_offset);
+            // Thread the free list in address order, so consecutive allocations are adjacent in memory
+            for (size_type i = 0; i + 1 < num_slots; ++i) {
+                slots[i].next = &slots[i + 1];
+            }
+            slots[num_slots - 1].next = m_free_list;
+            m_free_list = slots;
+
+            m_next_chunk_size = num_slots * 2 < MaxNodesPerChunk ? num_slots * 2 : MaxNodesPerChunk;
+        }
+
+        chunk_header* m_chunks = nullptr;
+        slot* m_free_list = nullptr;
+        size_type m_next_chunk_size = min_nodes_per_chunk;
+    };
+
+}
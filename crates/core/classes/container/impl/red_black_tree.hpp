@@ -1,17 +1,21 @@
 #pragma once
 
 /**
- * Most part of this file is copied from https://oi-wiki.org/ds/rbtree
+ * Intrusive red-black tree, rebalancing follows CLRS (Introduction to Algorithms, chapter 13).
+ *
+ * Nodes are allocated from a `node_pool` and linked with raw pointers, the colour lives in the lowest bit of the
+ * parent pointer. Nodes never move once linked, erasing or rebalancing only relinks them, so node addresses and
+ * iterators stay valid until their own entry is removed.
  */
 
 #include "container/vector.hpp"
 #include "container/exception.hpp"
-#include <cassert>
+#include "container/impl/node_pool.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <memory>
-#include <stack>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 
 namespace avalanche {
@@ -20,7 +24,7 @@ namespace avalanche {
     private:
         using USize = size_t;
 
-        Compare compare = Compare();
+        AVALANCHE_NO_UNIQUE_ADDRESS Compare compare = Compare();
 
     public:
         struct Entry {
@@ -38,110 +42,47 @@ namespace avalanche {
 
     private:
         struct Node {
-            using Ptr = std::shared_ptr<Node>;
-            using Provider = const std::function<Ptr(void)> &;
-            using Consumer = const std::function<void(const Ptr &)> &;
+            static constexpr uintptr_t BLACK_BIT = 1;
 
-            enum { RED, BLACK } color = RED;
+            Node *left = nullptr;
+            Node *right = nullptr;
+            uintptr_t parentAndColor = 0;
+            Entry entry;
 
-            enum Direction { LEFT = -1, ROOT = 0, RIGHT = 1 };
-
-            Key key;
-            Value value{};
-
-            Ptr parent = nullptr;
-            Ptr left = nullptr;
-            Ptr right = nullptr;
-
-            explicit Node(Key k) : key(std::move(k)) {
-            }
-
-            explicit Node(Key k, Value v) : key(std::move(k)), value(std::move(v)) {
-            }
-
-            ~Node() = default;
-
-            inline bool isLeaf() const noexcept {
-                return this->left == nullptr && this->right == nullptr;
-            }
-
-            inline bool isRoot() const noexcept { return this->parent == nullptr; }
-
-            inline bool isRed() const noexcept { return this->color == RED; }
-
-            inline bool isBlack() const noexcept { return this->color == BLACK; }
-
-            inline Direction direction() const noexcept {
-                if (this->parent != nullptr) {
-                    if (this == this->parent->left.get()) {
-                        return Direction::LEFT;
-                    } else {
-                        return Direction::RIGHT;
-                    }
-                } else {
-                    return Direction::ROOT;
-                }
-            }
-
-            inline Ptr &sibling() const noexcept {
-                assert(!this->isRoot());
-                if (this->direction() == LEFT) {
-                    return this->parent->right;
-                } else {
-                    return this->parent->left;
-                }
-            }
-
-            inline bool hasSibling() const noexcept {
-                return !this->isRoot() && this->sibling() != nullptr;
-            }
-
-            inline Ptr &uncle() const noexcept {
-                assert(this->parent != nullptr);
-                return parent->sibling();
+            template<typename KeyArg, typename... ValueArgs>
+            explicit Node(KeyArg &&k, ValueArgs &&... v)
+                : entry{Key(std::forward<KeyArg>(k)), Value(std::forward<ValueArgs>(v)...)} {
             }
 
-            inline bool hasUncle() const noexcept {
-                return !this->isRoot() && this->parent->hasSibling();
+            inline Node *parent() const noexcept {
+                return reinterpret_cast<Node *>(this->parentAndColor & ~BLACK_BIT);
             }
 
-            inline Ptr &grandParent() const noexcept {
-                assert(this->parent != nullptr);
-                return this->parent->parent;
+            inline void setParent(Node *p) noexcept {
+                this->parentAndColor = reinterpret_cast<uintptr_t>(p) | (this->parentAndColor & BLACK_BIT);
             }
 
-            inline bool hasGrandParent() const noexcept {
-                return !this->isRoot() && this->parent->parent != nullptr;
-            }
+            inline bool isBlack() const noexcept { return (this->parentAndColor & BLACK_BIT) != 0; }
 
-            inline void release() noexcept {
-                // avoid memory leak caused by circular reference
-                this->parent = nullptr;
-                if (this->left != nullptr) {
-                    this->left->release();
-                }
-                if (this->right != nullptr) {
-                    this->right->release();
-                }
-            }
+            inline bool isRed() const noexcept { return !this->isBlack(); }
 
-            inline Entry entry() const { return Entry{key, value}; }
+            inline void setBlack() noexcept { this->parentAndColor |= BLACK_BIT; }
 
-            static Ptr from(const Key &k) { return std::make_shared<Node>(Node(k)); }
+            inline void setRed() noexcept { this->parentAndColor &= ~BLACK_BIT; }
 
-            static Ptr from(const Key &k, const Value &v) {
-                return std::make_shared<Node>(Node(k, v));
+            inline void setBlack(bool black) noexcept {
+                this->parentAndColor = (this->parentAndColor & ~BLACK_BIT) | static_cast<uintptr_t>(black);
             }
         };
 
-        using NodePtr = typename Node::Ptr;
-        using ConstNodePtr = const NodePtr &;
-        using Direction = typename Node::Direction;
-        using NodeProvider = typename Node::Provider;
-        using NodeConsumer = typename Node::Consumer;
+        static_assert(alignof(Node) >= 2, "Colour bit requires nodes aligned to at least 2 bytes");
 
-        NodePtr root = nullptr;
+        // Absent children count as black leaves
+        static inline bool isBlack(const Node *node) noexcept { return node == nullptr || node->isBlack(); }
+
+        Node *root = nullptr;
         USize count = 0;
+        node_pool<Node> pool;
 
         using K = const Key &;
         using V = const Value &;
@@ -163,13 +104,120 @@ namespace avalanche {
             AVALANCHE_NO_DISCARD const char *what() const noexcept override { return message; }
         };
 
+        /**
+         * In-order bidirectional iterator, `end()` is represented by a null node.
+         * The key of an entry must not be modified through an iterator.
+         */
+        template<bool IsConst>
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = Entry;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<IsConst, const Entry &, Entry &>;
+            using pointer = std::conditional_t<IsConst, const Entry *, Entry *>;
+
+            Iterator() noexcept = default;
+
+            // Mutable iterators are convertible to const ones
+            template<bool OtherIsConst> requires (IsConst && !OtherIsConst)
+            Iterator(const Iterator<OtherIsConst> &other) noexcept : node(other.node), tree(other.tree) {
+            }
+
+            reference operator*() const noexcept { return this->node->entry; }
+
+            pointer operator->() const noexcept { return &this->node->entry; }
+
+            K key() const noexcept { return this->node->entry.key; }
+
+            std::conditional_t<IsConst, V, Value &> value() const noexcept { return this->node->entry.value; }
+
+            Iterator &operator++() noexcept {
+                this->node = successor(this->node);
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept {
+                Iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            Iterator &operator--() noexcept {
+                this->node = this->node == nullptr ? maximum(this->tree->root) : predecessor(this->node);
+                return *this;
+            }
+
+            Iterator operator--(int) noexcept {
+                Iterator previous = *this;
+                --*this;
+                return previous;
+            }
+
+            bool operator==(const Iterator &rhs) const noexcept { return this->node == rhs.node; }
+
+            bool operator!=(const Iterator &rhs) const noexcept { return this->node != rhs.node; }
+
+        private:
+            friend class RBTreeMap;
+            template<bool> friend class Iterator;
+
+            Iterator(Node *n, const RBTreeMap *t) noexcept : node(n), tree(t) {
+            }
+
+            Node *node = nullptr;
+            const RBTreeMap *tree = nullptr;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
         RBTreeMap() noexcept = default;
 
+        explicit RBTreeMap(Compare comp) noexcept(std::is_nothrow_move_constructible_v<Compare>)
+            : compare(std::move(comp)) {
+        }
+
+        RBTreeMap(const RBTreeMap &other) : compare(other.compare), count(other.count) {
+            this->root = this->cloneSubtree(other.root, nullptr);
+        }
+
+        RBTreeMap(RBTreeMap &&other) noexcept
+            : compare(std::move(other.compare))
+            , root(std::exchange(other.root, nullptr))
+            , count(std::exchange(other.count, 0))
+            , pool(std::move(other.pool)) {
+        }
+
+        RBTreeMap &operator=(const RBTreeMap &other) {
+            if (this != &other) {
+                RBTreeMap copy(other);
+                this->swap(copy);
+            }
+            return *this;
+        }
+
+        RBTreeMap &operator=(RBTreeMap &&other) noexcept {
+            if (this != &other) {
+                this->clear();
+                this->swap(other);
+            }
+            return *this;
+        }
+
         ~RBTreeMap() noexcept {
-            // Unlinking circular references to avoid memory leak
             this->clear();
         }
 
+        void swap(RBTreeMap &other) noexcept {
+            std::swap(this->compare, other.compare);
+            std::swap(this->root, other.root);
+            std::swap(this->count, other.count);
+            this->pool.swap(other.pool);
+        }
+
+        const Compare &keyCompare() const noexcept { return this->compare; }
+
         /**
          * Returns the number of entries in this map.
          * @return size_t
@@ -186,14 +234,58 @@ namespace avalanche {
          * Removes all of the elements from this map.
          */
         void clear() noexcept {
-            // Unlinking circular references to avoid memory leak
-            if (this->root != nullptr) {
-                this->root->release();
-                this->root = nullptr;
+            if constexpr (!std::is_trivially_destructible_v<Entry>) {
+                // Post-order teardown through parent links, no recursion and no extra memory
+                Node *node = this->root;
+                while (node != nullptr) {
+                    if (node->left != nullptr) {
+                        node = node->left;
+                    } else if (node->right != nullptr) {
+                        node = node->right;
+                    } else {
+                        Node *parent = node->parent();
+                        if (parent != nullptr) {
+                            (parent->left == node ? parent->left : parent->right) = nullptr;
+                        }
+                        this->pool.destroy(node);
+                        node = parent;
+                    }
+                }
             }
+            this->pool.release();
+            this->root = nullptr;
             this->count = 0;
         }
 
+        iterator begin() noexcept { return iterator(minimum(this->root), this); }
+
+        const_iterator begin() const noexcept { return const_iterator(minimum(this->root), this); }
+
+        iterator end() noexcept { return iterator(nullptr, this); }
+
+        const_iterator end() const noexcept { return const_iterator(nullptr, this); }
+
+        /**
+         * Returns an iterator to the entry of the specified key, or `end()` if absent.
+         */
+        iterator find(K key) noexcept { return iterator(this->getNode(key), this); }
+
+        const_iterator find(K key) const noexcept { return const_iterator(this->getNode(key), this); }
+
+        /**
+         * Returns an iterator to the first entry whose key is not less than the specified key.
+         */
+        iterator lowerBound(K key) noexcept { return iterator(this->lowerBoundNode(key), this); }
+
+        const_iterator lowerBound(K key) const noexcept { return const_iterator(this->lowerBoundNode(key), this); }
+
+        /**
+         * Returns an iterator to the first entry whose key is greater than the specified key.
+         */
+        iterator upperBound(K key) noexcept { return iterator(this->upperBoundNode(key), this); }
+
+        const_iterator upperBound(K key) const noexcept { return const_iterator(this->upperBoundNode(key), this); }
+
         /**
          * Returns the value to which the specified key is mapped; If this map
          * contains no mapping for the key, a {@code NoSuchMappingException} will
@@ -202,17 +294,16 @@ namespace avalanche {
          * @return RBTreeMap<Key, Value>::Value
          * @throws NoSuchMappingException
          */
-        Value& get(K key) const {
-            if (this->root == nullptr) {
+        Value &get(K key) {
+            Node *node = this->getNode(key);
+            if (node == nullptr) {
                 raise_exception(NoSuchMappingException("Invalid key"));
-            } else {
-                NodePtr node = this->getNode(this->root, key);
-                if (node != nullptr) {
-                    return node->value;
-                } else {
-                    raise_exception(NoSuchMappingException("Invalid key"));
-                }
             }
+            return node->entry.value;
+        }
+
+        const Value &get(K key) const {
+            return const_cast<RBTreeMap *>(this)->get(key);
         }
 
         /**
@@ -223,17 +314,7 @@ namespace avalanche {
          * @return RBTreeMap<Key, Value>::Value &
          */
         Value &getOrDefault(K key) {
-            if (this->root == nullptr) {
-                this->root = Node::from(key);
-                this->root->color = Node::BLACK;
-                this->count += 1;
-                return this->root->value;
-            } else {
-                return this
-                        ->getNodeOrProvide(this->root, key,
-                                           [&key]() { return Node::from(key); })
-                        ->value;
-            }
+            return this->tryEmplace(key).first.value();
         }
 
         /**
@@ -242,7 +323,7 @@ namespace avalanche {
          * @return bool
          */
         bool contains(K key) const {
-            return this->getNode(this->root, key) != nullptr;
+            return this->getNode(key) != nullptr;
         }
 
         /**
@@ -251,12 +332,16 @@ namespace avalanche {
          * @param value
          */
         void insert(K key, V value) {
-            if (this->root == nullptr) {
-                this->root = Node::from(key, value);
-                this->root->color = Node::BLACK;
-                this->count += 1;
-            } else {
-                this->insert(this->root, key, value);
+            auto [it, inserted] = this->tryEmplace(key, value);
+            if (!inserted) {
+                it.value() = value;
+            }
+        }
+
+        void insert(K key, Value &&value) {
+            auto [it, inserted] = this->tryEmplace(key, std::move(value));
+            if (!inserted) {
+                it.value() = std::move(value);
             }
         }
 
@@ -268,15 +353,7 @@ namespace avalanche {
          * @return bool
          */
         bool insertIfAbsent(K key, V value) {
-            USize sizeBeforeInsertion = this->size();
-            if (this->root == nullptr) {
-                this->root = Node::from(key, value);
-                this->root->color = Node::BLACK;
-                this->count += 1;
-            } else {
-                this->insert(this->root, key, value, false);
-            }
-            return this->size() > sizeBeforeInsertion;
+            return this->tryEmplace(key, value).second;
         }
 
         /**
@@ -288,19 +365,38 @@ namespace avalanche {
          * @return RBTreeMap<Key, Value>::Value &
          */
         Value &getOrInsert(K key, V value) {
-            if (this->root == nullptr) {
-                this->root = Node::from(key, value);
-                this->root->color = Node::BLACK;
-                this->count += 1;
-                return root->value;
-            } else {
-                NodePtr node = getNodeOrProvide(this->root, key,
-                                                [&]() { return Node::from(key, value); });
-                return node->value;
+            return this->tryEmplace(key, value).first.value();
+        }
+
+        /**
+         * If the specified key is absent, inserts a value constructed from the arguments.
+         * Arguments are left untouched if the key is present.
+         * @return the entry of the key, and whether it has been inserted
+         */
+        template<typename... Args>
+        std::pair<iterator, bool> tryEmplace(K key, Args &&... args) {
+            Node *parent = nullptr;
+            Node **link = &this->root;
+            while (*link != nullptr) {
+                parent = *link;
+                if (compare(key, parent->entry.key)) {
+                    link = &parent->left;
+                } else if (compare(parent->entry.key, key)) {
+                    link = &parent->right;
+                } else {
+                    return {iterator(parent, this), false};
+                }
             }
+
+            Node *node = this->pool.create(key, std::forward<Args>(args)...);
+            node->parentAndColor = reinterpret_cast<uintptr_t>(parent);
+            *link = node;
+            this->maintainAfterInsert(node);
+            this->count += 1;
+            return {iterator(node, this), true};
         }
 
-        Value operator[](K key) const { return this->get(key); }
+        const Value &operator[](K key) const { return this->get(key); }
 
         Value &operator[](K key) { return this->getOrDefault(key); }
 
@@ -311,12 +407,22 @@ namespace avalanche {
          * @return bool
          */
         bool remove(K key) {
-            if (this->root == nullptr) {
+            Node *node = this->getNode(key);
+            if (node == nullptr) {
                 return false;
-            } else {
-                return this->remove(this->root, key, [](ConstNodePtr) {
-                });
             }
+            this->removeNode(node);
+            return true;
+        }
+
+        /**
+         * Removes the entry pointed by the iterator.
+         * @return iterator to the entry following the removed one
+         */
+        iterator remove(const_iterator position) noexcept {
+            Node *next = successor(position.node);
+            this->removeNode(position.node);
+            return iterator(next, this);
         }
 
         /**
@@ -328,18 +434,13 @@ namespace avalanche {
          * @throws NoSuchMappingException
          */
         Value getAndRemove(K key) {
-            Value result;
-            NodeConsumer action = [&](ConstNodePtr node) { result = node->value; };
-
-            if (root == nullptr) {
+            Node *node = this->getNode(key);
+            if (node == nullptr) {
                 raise_exception(NoSuchMappingException("Invalid key"));
-            } else {
-                if (remove(this->root, key, action)) {
-                    return result;
-                } else {
-                    raise_exception(NoSuchMappingException("Invalid key"));
-                }
             }
+            Value result = std::move(node->entry.value);
+            this->removeNode(node);
+            return result;
         }
 
         /**
@@ -352,46 +453,11 @@ namespace avalanche {
          * @throws NoSuchMappingException
          */
         Entry getCeilingEntry(K key) const {
-            if (this->root == nullptr) {
-                raise_exception(NoSuchMappingException("No ceiling entry in this map"));
-            }
-
-            NodePtr node = this->root;
-
-            while (node != nullptr) {
-                if (key == node->key) {
-                    return node->entry();
-                }
-
-                if (compare(key, node->key)) {
-                    /* key < node->key */
-                    if (node->left != nullptr) {
-                        node = node->left;
-                    } else {
-                        return node->entry();
-                    }
-                } else {
-                    /* key > node->key */
-                    if (node->right != nullptr) {
-                        node = node->right;
-                    } else {
-                        while (node->direction() == Direction::RIGHT) {
-                            if (node != nullptr) {
-                                node = node->parent;
-                            } else {
-                                raise_exception(NoSuchMappingException(
-                                    "No ceiling entry exists in this map"));
-                            }
-                        }
-                        if (node->parent == nullptr) {
-                            raise_exception(NoSuchMappingException("No ceiling entry exists in this map"));
-                        }
-                        return node->parent->entry();
-                    }
-                }
+            const Node *node = this->lowerBoundNode(key);
+            if (node == nullptr) {
+                raise_exception(NoSuchMappingException("No ceiling entry exists in this map"));
             }
-
-            raise_exception(NoSuchMappingException("No ceiling entry in this map"));
+            return node->entry;
         }
 
         /**
@@ -403,93 +469,27 @@ namespace avalanche {
          * @throws NoSuchMappingException
          */
         Entry getFloorEntry(K key) const {
-            if (this->root == nullptr) {
+            const Node *node = this->upperBoundNode(key);
+            node = node == nullptr ? maximum(this->root) : predecessor(node);
+            if (node == nullptr) {
                 raise_exception(NoSuchMappingException("No floor entry exists in this map"));
             }
-
-            NodePtr node = this->root;
-
-            while (node != nullptr) {
-                if (key == node->key) {
-                    return node->entry();
-                }
-
-                if (compare(key, node->key)) {
-                    /* key < node->key */
-                    if (node->left != nullptr) {
-                        node = node->left;
-                    } else {
-                        while (node->direction() == Direction::LEFT) {
-                            if (node != nullptr) {
-                                node = node->parent;
-                            } else {
-                                raise_exception(NoSuchMappingException("No floor entry exists in this map"));
-                            }
-                        }
-                        if (node->parent == nullptr) {
-                            raise_exception(NoSuchMappingException("No floor entry exists in this map"));
-                        }
-                        return node->parent->entry();
-                    }
-                } else {
-                    /* key > node->key */
-                    if (node->right != nullptr) {
-                        node = node->right;
-                    } else {
-                        return node->entry();
-                    }
-                }
-            }
-
-            raise_exception(NoSuchMappingException("No floor entry exists in this map"));
+            return node->entry;
         }
 
         /**
          * Gets the entry for the least key greater than the specified
-         * key; if no such entry exists, returns the entry for the least
-         * key greater than the specified key; if no such entry exists,
-         * a {@code NoSuchMappingException} will be thrown.
+         * key; if no such entry exists, a {@code NoSuchMappingException} will be thrown.
          * @param key
          * @return RBTreeMap<Key, Value>::Entry
          * @throws NoSuchMappingException
          */
-        Entry getHigherEntry(K key) {
-            if (this->root == nullptr) {
+        Entry getHigherEntry(K key) const {
+            const Node *node = this->upperBoundNode(key);
+            if (node == nullptr) {
                 raise_exception(NoSuchMappingException("No higher entry exists in this map"));
             }
-
-            NodePtr node = this->root;
-
-            while (node != nullptr) {
-                if (compare(key, node->key)) {
-                    /* key < node->key */
-                    if (node->left != nullptr) {
-                        node = node->left;
-                    } else {
-                        return node->entry();
-                    }
-                } else {
-                    /* key >= node->key */
-                    if (node->right != nullptr) {
-                        node = node->right;
-                    } else {
-                        while (node->direction() == Direction::RIGHT) {
-                            if (node != nullptr) {
-                                node = node->parent;
-                            } else {
-                                raise_exception(NoSuchMappingException(
-                                    "No higher entry exists in this map"));
-                            }
-                        }
-                        if (node->parent == nullptr) {
-                            raise_exception(NoSuchMappingException("No higher entry exists in this map"));
-                        }
-                        return node->parent->entry();
-                    }
-                }
-            }
-
-            raise_exception(NoSuchMappingException("No higher entry exists in this map"));
+            return node->entry;
         }
 
         /**
@@ -501,41 +501,12 @@ namespace avalanche {
          * @throws NoSuchMappingException
          */
         Entry getLowerEntry(K key) const {
-            if (this->root == nullptr) {
+            const Node *node = this->lowerBoundNode(key);
+            node = node == nullptr ? maximum(this->root) : predecessor(node);
+            if (node == nullptr) {
                 raise_exception(NoSuchMappingException("No lower entry exists in this map"));
             }
-
-            NodePtr node = this->root;
-
-            while (node != nullptr) {
-                if (compare(key, node->key) || key == node->key) {
-                    /* key <= node->key */
-                    if (node->left != nullptr) {
-                        node = node->left;
-                    } else {
-                        while (node->direction() == Direction::LEFT) {
-                            if (node != nullptr) {
-                                node = node->parent;
-                            } else {
-                                raise_exception(NoSuchMappingException("No lower entry exists in this map"));
-                            }
-                        }
-                        if (node->parent == nullptr) {
-                            raise_exception(NoSuchMappingException("No lower entry exists in this map"));
-                        }
-                        return node->parent->entry();
-                    }
-                } else {
-                    /* key > node->key */
-                    if (node->right != nullptr) {
-                        node = node->right;
-                    } else {
-                        return node->entry();
-                    }
-                }
-            }
-
-            raise_exception(NoSuchMappingException("No lower entry exists in this map"));
+            return node->entry;
         }
 
         /**
@@ -543,14 +514,14 @@ namespace avalanche {
          * @param filter
          */
         void removeAll(KeyValueFilter filter) {
-            vector<Key> keys;
-            this->inorderTraversal([&](ConstNodePtr node) {
-                if (filter(node->key, node->value)) {
-                    keys.push_back(node->key);
+            Node *node = minimum(this->root);
+            while (node != nullptr) {
+                // Removal relinks nodes without moving them, the successor stays valid
+                Node *next = successor(node);
+                if (filter(node->entry.key, node->entry.value)) {
+                    this->removeNode(node);
                 }
-            });
-            for (const Key &key: keys) {
-                this->remove(key);
+                node = next;
             }
         }
 
@@ -560,8 +531,9 @@ namespace avalanche {
          * @param action
          */
         void forEach(KeyValueConsumer action) const {
-            this->inorderTraversal(
-                [&](ConstNodePtr node) { action(node->key, node->value); });
+            for (const Node *node = minimum(this->root); node != nullptr; node = successor(node)) {
+                action(node->entry.key, node->entry.value);
+            }
         }
 
         /**
@@ -570,8 +542,9 @@ namespace avalanche {
          * @param action
          */
         void forEachMut(MutKeyValueConsumer action) {
-            this->inorderTraversal(
-                [&](ConstNodePtr node) { action(node->key, node->value); });
+            for (Node *node = minimum(this->root); node != nullptr; node = successor(node)) {
+                action(node->entry.key, node->entry.value);
+            }
         }
 
         /**
@@ -580,587 +553,288 @@ namespace avalanche {
          */
         EntryList toEntryList() const {
             EntryList entryList;
-            this->inorderTraversal(
-                [&](ConstNodePtr node) { entryList.push_back(node->entry()); });
+            this->forEach([&](K key, V value) { entryList.push_back(Entry{key, value}); });
             return entryList;
         }
 
     private:
-        static void maintainRelationship(ConstNodePtr node) {
-            if (node->left != nullptr) {
-                node->left->parent = node;
-            }
-            if (node->right != nullptr) {
-                node->right->parent = node;
-            }
-        }
-
-        static void swapNode(NodePtr &lhs, NodePtr &rhs) {
-            std::swap(lhs->key, rhs->key);
-            std::swap(lhs->value, rhs->value);
-            std::swap(lhs, rhs);
-        }
-
-        void rotateLeft(ConstNodePtr node) {
-            // clang-format off
-            //     |                       |
-            //     N                       S
-            //    / \     l-rotate(N)     / \
-            //   L   S    ==========>    N   R
-            //      / \                 / \
-            //     M   R               L   M
-            assert(node != nullptr && node->right != nullptr);
-            // clang-format on
-            NodePtr parent = node->parent;
-            Direction direction = node->direction();
-
-            NodePtr successor = node->right;
-            node->right = successor->left;
-            successor->left = node;
-
-            maintainRelationship(node);
-            maintainRelationship(successor);
-
-            switch (direction) {
-                case Direction::ROOT:
-                    this->root = successor;
-                    break;
-                case Direction::LEFT:
-                    parent->left = successor;
-                    break;
-                case Direction::RIGHT:
-                    parent->right = successor;
-                    break;
+        template<typename NodeType>
+        static NodeType *minimum(NodeType *node) noexcept {
+            if (node != nullptr) {
+                while (node->left != nullptr) {
+                    node = node->left;
+                }
             }
-
-            successor->parent = parent;
+            return node;
         }
 
-        void rotateRight(ConstNodePtr node) {
-            // clang-format off
-            //       |                   |
-            //       N                   S
-            //      / \   r-rotate(N)   / \
-            //     S   R  ==========>  L   N
-            //    / \                     / \
-            //   L   M                   M   R
-            assert(node != nullptr && node->left != nullptr);
-            // clang-format on
-
-            NodePtr parent = node->parent;
-            Direction direction = node->direction();
-
-            NodePtr successor = node->left;
-            node->left = successor->right;
-            successor->right = node;
-
-            maintainRelationship(node);
-            maintainRelationship(successor);
-
-            switch (direction) {
-                case Direction::ROOT:
-                    this->root = successor;
-                    break;
-                case Direction::LEFT:
-                    parent->left = successor;
-                    break;
-                case Direction::RIGHT:
-                    parent->right = successor;
-                    break;
+        template<typename NodeType>
+        static NodeType *maximum(NodeType *node) noexcept {
+            if (node != nullptr) {
+                while (node->right != nullptr) {
+                    node = node->right;
+                }
             }
-
-            successor->parent = parent;
+            return node;
         }
 
-        inline void rotateSameDirection(ConstNodePtr node, Direction direction) {
-            assert(direction != Direction::ROOT);
-            if (direction == Direction::LEFT) {
-                rotateLeft(node);
-            } else {
-                rotateRight(node);
+        template<typename NodeType>
+        static NodeType *successor(NodeType *node) noexcept {
+            if (node->right != nullptr) {
+                return minimum(node->right);
             }
-        }
-
-        inline void rotateOppositeDirection(ConstNodePtr node, Direction direction) {
-            assert(direction != Direction::ROOT);
-            if (direction == Direction::LEFT) {
-                rotateRight(node);
-            } else {
-                rotateLeft(node);
+            NodeType *parent = node->parent();
+            while (parent != nullptr && node == parent->right) {
+                node = parent;
+                parent = parent->parent();
             }
+            return parent;
         }
 
-        void maintainAfterInsert(NodePtr node) {
-            assert(node != nullptr);
-
-            if (node->isRoot()) {
-                // Case 1: Current node is root (RED)
-                //  No need to fix.
-                assert(node->isRed());
-                return;
-            }
-
-            if (node->parent->isBlack()) {
-                // Case 2: Parent is BLACK
-                //  No need to fix.
-                return;
-            }
-
-            if (node->parent->isRoot()) {
-                // clang-format off
-                // Case 3: Parent is root and is RED
-                //   Paint parent to BLACK.
-                //    <P>         [P]
-                //     |   ====>   |
-                //    <N>         <N>
-                //   p.s.
-                //    `<X>` is a RED node;
-                //    `[X]` is a BLACK node (or NIL);
-                //    `{X}` is either a RED node or a BLACK node;
-                // clang-format on
-                assert(node->parent->isRed());
-                node->parent->color = Node::BLACK;
-                return;
+        template<typename NodeType>
+        static NodeType *predecessor(NodeType *node) noexcept {
+            if (node->left != nullptr) {
+                return maximum(node->left);
             }
-
-            if (node->hasUncle() && node->uncle()->isRed()) {
-                // clang-format off
-                // Case 4: Both parent and uncle are RED
-                //   Paint parent and uncle to BLACK;
-                //   Paint grandparent to RED.
-                //        [G]             <G>
-                //        / \             / \
-                //      <P> <U>  ====>  [P] [U]
-                //      /               /
-                //    <N>             <N>
-                // clang-format on
-                assert(node->parent->isRed());
-                node->parent->color = Node::BLACK;
-                node->uncle()->color = Node::BLACK;
-                node->grandParent()->color = Node::RED;
-                maintainAfterInsert(node->grandParent());
-                return;
+            NodeType *parent = node->parent();
+            while (parent != nullptr && node == parent->left) {
+                node = parent;
+                parent = parent->parent();
             }
+            return parent;
+        }
 
-            if (!node->hasUncle() || node->uncle()->isBlack()) {
-                // Case 5 & 6: Parent is RED and Uncle is BLACK
-                //   p.s. NIL nodes are also considered BLACK
-                assert(!node->isRoot());
-
-                if (node->direction() != node->parent->direction()) {
-                    // clang-format off
-                    // Case 5: Current node is the opposite direction as parent
-                    //   Step 1. If node is a LEFT child, perform l-rotate to parent;
-                    //           If node is a RIGHT child, perform r-rotate to parent.
-                    //   Step 2. Goto Case 6.
-                    //      [G]                 [G]
-                    //      / \    rotate(P)    / \
-                    //    <P> [U]  ========>  <N> [U]
-                    //      \                 /
-                    //      <N>             <P>
-                    // clang-format on
-
-                    // Step 1: Rotation
-                    NodePtr parent = node->parent;
-                    if (node->direction() == Direction::LEFT) {
-                        rotateRight(node->parent);
-                    } else /* node->direction() == Direction::RIGHT */ {
-                        rotateLeft(node->parent);
-                    }
-                    node = parent;
-                    // Step 2: vvv
-                }
-
-                // clang-format off
-                // Case 6: Current node is the same direction as parent
-                //   Step 1. If node is a LEFT child, perform r-rotate to grandparent;
-                //           If node is a RIGHT child, perform l-rotate to grandparent.
-                //   Step 2. Paint parent (before rotate) to BLACK;
-                //           Paint grandparent (before rotate) to RED.
-                //        [G]                 <P>               [P]
-                //        / \    rotate(G)    / \    repaint    / \
-                //      <P> [U]  ========>  <N> [G]  ======>  <N> <G>
-                //      /                         \                 \
-                //    <N>                         [U]               [U]
-                // clang-format on
-
-                assert(node->grandParent() != nullptr);
-
-                // Step 1
-                if (node->parent->direction() == Direction::LEFT) {
-                    rotateRight(node->grandParent());
+        Node *getNode(K key) const noexcept {
+            Node *node = this->root;
+            while (node != nullptr) {
+                if (compare(key, node->entry.key)) {
+                    node = node->left;
+                } else if (compare(node->entry.key, key)) {
+                    node = node->right;
                 } else {
-                    rotateLeft(node->grandParent());
+                    return node;
                 }
-
-                // Step 2
-                node->parent->color = Node::BLACK;
-                node->sibling()->color = Node::RED;
-
-                return;
             }
+            return nullptr;
         }
 
-        NodePtr getNodeOrProvide(NodePtr &node, K key, NodeProvider provide) {
-            assert(node != nullptr);
-
-            if (key == node->key) {
-                return node;
-            }
-
-            assert(key != node->key);
-
-            NodePtr result;
-
-            if (compare(key, node->key)) {
-                /* key < node->key */
-                if (node->left == nullptr) {
-                    result = node->left = provide();
-                    node->left->parent = node;
-                    maintainAfterInsert(node->left);
-                    this->count += 1;
-                } else {
-                    result = getNodeOrProvide(node->left, key, provide);
-                }
-            } else {
-                /* key > node->key */
-                if (node->right == nullptr) {
-                    result = node->right = provide();
-                    node->right->parent = node;
-                    maintainAfterInsert(node->right);
-                    this->count += 1;
+        Node *lowerBoundNode(K key) const noexcept {
+            Node *result = nullptr;
+            Node *node = this->root;
+            while (node != nullptr) {
+                if (!compare(node->entry.key, key)) {
+                    result = node;
+                    node = node->left;
                 } else {
-                    result = getNodeOrProvide(node->right, key, provide);
+                    node = node->right;
                 }
             }
-
             return result;
         }
 
-        NodePtr getNode(ConstNodePtr node, K key) const {
-            assert(node != nullptr);
-
-            if (key == node->key) {
-                return node;
-            }
-
-            if (compare(key, node->key)) {
-                /* key < node->key */
-                return node->left == nullptr ? nullptr : getNode(node->left, key);
-            } else {
-                /* key > node->key */
-                return node->right == nullptr ? nullptr : getNode(node->right, key);
+        Node *upperBoundNode(K key) const noexcept {
+            Node *result = nullptr;
+            Node *node = this->root;
+            while (node != nullptr) {
+                if (compare(key, node->entry.key)) {
+                    result = node;
+                    node = node->left;
+                } else {
+                    node = node->right;
+                }
             }
+            return result;
         }
 
-        void insert(NodePtr &node, K key, V value, bool replace = true) {
-            assert(node != nullptr);
-
-            if (key == node->key) {
-                if (replace) {
-                    node->value = value;
-                }
-                return;
+        Node *cloneSubtree(const Node *source, Node *parent) {
+            if (source == nullptr) {
+                return nullptr;
             }
+            // Depth is bounded by 2 * log2(n), recursion is fine here
+            Node *node = this->pool.create(source->entry.key, source->entry.value);
+            node->parentAndColor = reinterpret_cast<uintptr_t>(parent) | (source->parentAndColor & Node::BLACK_BIT);
+            node->left = this->cloneSubtree(source->left, node);
+            node->right = this->cloneSubtree(source->right, node);
+            return node;
+        }
 
-            assert(key != node->key);
-
-            if (compare(key, node->key)) {
-                /* key < node->key */
-                if (node->left == nullptr) {
-                    node->left = Node::from(key, value);
-                    node->left->parent = node;
-                    maintainAfterInsert(node->left);
-                    this->count += 1;
-                } else {
-                    insert(node->left, key, value, replace);
-                }
+        /**
+         * Replaces the link from `node`'s parent to `node` with `replacement`.
+         */
+        void replaceChild(Node *node, Node *replacement) noexcept {
+            Node *parent = node->parent();
+            if (parent == nullptr) {
+                this->root = replacement;
+            } else if (node == parent->left) {
+                parent->left = replacement;
             } else {
-                /* key > node->key */
-                if (node->right == nullptr) {
-                    node->right = Node::from(key, value);
-                    node->right->parent = node;
-                    maintainAfterInsert(node->right);
-                    this->count += 1;
-                } else {
-                    insert(node->right, key, value, replace);
-                }
+                parent->right = replacement;
             }
-        }
-
-        void maintainAfterRemove(ConstNodePtr node) {
-            if (node->isRoot()) {
-                return;
+            if (replacement != nullptr) {
+                replacement->setParent(parent);
             }
+        }
 
-            assert(node->isBlack() && node->hasSibling());
-
-            Direction direction = node->direction();
-
-            NodePtr sibling = node->sibling();
-            if (sibling->isRed()) {
-                // clang-format off
-                // Case 1: Sibling is RED, parent and nephews must be BLACK
-                //   Step 1. If N is a left child, left rotate P;
-                //           If N is a right child, right rotate P.
-                //   Step 2. Paint S to BLACK, P to RED
-                //   Step 3. Goto Case 2, 3, 4, 5
-                //      [P]                   <S>               [S]
-                //      / \    l-rotate(P)    / \    repaint    / \
-                //    [N] <S>  ==========>  [P] [D]  ======>  <P> [D]
-                //        / \               / \               / \
-                //      [C] [D]           [N] [C]           [N] [C]
-                // clang-format on
-                ConstNodePtr parent = node->parent;
-                assert(parent != nullptr && parent->isBlack());
-                assert(sibling->left != nullptr && sibling->left->isBlack());
-                assert(sibling->right != nullptr && sibling->right->isBlack());
-                // Step 1
-                rotateSameDirection(node->parent, direction);
-                // Step 2
-                sibling->color = Node::BLACK;
-                parent->color = Node::RED;
-                // Update sibling after rotation
-                sibling = node->sibling();
-                // Step 3: vvv
+        void rotateLeft(Node *node) noexcept {
+            Node *pivot = node->right;
+            node->right = pivot->left;
+            if (pivot->left != nullptr) {
+                pivot->left->setParent(node);
             }
+            this->replaceChild(node, pivot);
+            pivot->left = node;
+            node->setParent(pivot);
+        }
 
-            NodePtr closeNephew =
-                    direction == Direction::LEFT ? sibling->left : sibling->right;
-            NodePtr distantNephew =
-                    direction == Direction::LEFT ? sibling->right : sibling->left;
-
-            bool closeNephewIsBlack = closeNephew == nullptr || closeNephew->isBlack();
-            bool distantNephewIsBlack =
-                    distantNephew == nullptr || distantNephew->isBlack();
-
-            assert(sibling->isBlack());
-
-            if (closeNephewIsBlack && distantNephewIsBlack) {
-                if (node->parent->isRed()) {
-                    // clang-format off
-                    // Case 2: Sibling and nephews are BLACK, parent is RED
-                    //   Swap the color of P and S
-                    //      <P>             [P]
-                    //      / \             / \
-                    //    [N] [S]  ====>  [N] <S>
-                    //        / \             / \
-                    //      [C] [D]         [C] [D]
-                    // clang-format on
-                    sibling->color = Node::RED;
-                    node->parent->color = Node::BLACK;
-                    return;
-                } else {
-                    // clang-format off
-                    // Case 3: Sibling, parent and nephews are all black
-                    //   Step 1. Paint S to RED
-                    //   Step 2. Recursively maintain P
-                    //      [P]             [P]
-                    //      / \             / \
-                    //    [N] [S]  ====>  [N] <S>
-                    //        / \             / \
-                    //      [C] [D]         [C] [D]
-                    // clang-format on
-                    sibling->color = Node::RED;
-                    maintainAfterRemove(node->parent);
-                    return;
-                }
-            } else {
-                if (closeNephew != nullptr && closeNephew->isRed()) {
-                    // clang-format off
-                    // Case 4: Sibling is BLACK, close nephew is RED,
-                    //         distant nephew is BLACK
-                    //   Step 1. If N is a left child, right rotate S;
-                    //           If N is a right child, left rotate S.
-                    //   Step 2. Swap the color of close nephew and sibling
-                    //   Step 3. Goto case 5
-                    //                            {P}                {P}
-                    //      {P}                   / \                / \
-                    //      / \    r-rotate(S)  [N] <C>   repaint  [N] [C]
-                    //    [N] [S]  ==========>        \   ======>        \
-                    //        / \                     [S]                <S>
-                    //      <C> [D]                     \                  \
-                    //                                  [D]                [D]
-                    // clang-format on
-
-                    // Step 1
-                    rotateOppositeDirection(sibling, direction);
-                    // Step 2
-                    closeNephew->color = Node::BLACK;
-                    sibling->color = Node::RED;
-                    // Update sibling and nephews after rotation
-                    sibling = node->sibling();
-                    closeNephew =
-                            direction == Direction::LEFT ? sibling->left : sibling->right;
-                    distantNephew =
-                            direction == Direction::LEFT ? sibling->right : sibling->left;
-                    // Step 3: vvv
-                }
-
-                // clang-format off
-                // Case 5: Sibling is BLACK, distant nephew is RED
-                //   Step 1. If N is a left child, left rotate P;
-                //           If N is a right child, right rotate P.
-                //   Step 2. Swap the color of parent and sibling.
-                //   Step 3. Paint distant nephew D to BLACK.
-                //      {P}                   [S]               {S}
-                //      / \    l-rotate(P)    / \    repaint    / \
-                //    [N] [S]  ==========>  {P} <D>  ======>  [P] [D]
-                //        / \               / \               / \
-                //      {C} <D>           [N] {C}           [N] {C}
-                // clang-format on
-                assert(distantNephew->isRed());
-                // Step 1
-                rotateSameDirection(node->parent, direction);
-                // Step 2
-                sibling->color = node->parent->color;
-                node->parent->color = Node::BLACK;
-                if (distantNephew != nullptr) {
-                    distantNephew->color = Node::BLACK;
-                }
-                return;
+        void rotateRight(Node *node) noexcept {
+            Node *pivot = node->left;
+            node->left = pivot->right;
+            if (pivot->right != nullptr) {
+                pivot->right->setParent(node);
             }
+            this->replaceChild(node, pivot);
+            pivot->right = node;
+            node->setParent(pivot);
         }
 
-        bool remove(NodePtr node, K key, NodeConsumer action) {
-            assert(node != nullptr);
-
-            if (key != node->key) {
-                if (compare(key, node->key)) {
-                    /* key < node->key */
-                    NodePtr &left = node->left;
-                    if (left != nullptr && remove(left, key, action)) {
-                        maintainRelationship(node);
-                        return true;
-                    } else {
-                        return false;
+        void maintainAfterInsert(Node *node) noexcept {
+            Node *parent;
+            while ((parent = node->parent()) != nullptr && parent->isRed()) {
+                // A red parent is never the root, so the grandparent exists
+                Node *grandParent = parent->parent();
+                if (parent == grandParent->left) {
+                    Node *uncle = grandParent->right;
+                    if (!isBlack(uncle)) {
+                        parent->setBlack();
+                        uncle->setBlack();
+                        grandParent->setRed();
+                        node = grandParent;
+                        continue;
+                    }
+                    if (node == parent->right) {
+                        this->rotateLeft(parent);
+                        parent = node;
                     }
+                    parent->setBlack();
+                    grandParent->setRed();
+                    this->rotateRight(grandParent);
                 } else {
-                    /* key > node->key */
-                    NodePtr &right = node->right;
-                    if (right != nullptr && remove(right, key, action)) {
-                        maintainRelationship(node);
-                        return true;
-                    } else {
-                        return false;
+                    Node *uncle = grandParent->left;
+                    if (!isBlack(uncle)) {
+                        parent->setBlack();
+                        uncle->setBlack();
+                        grandParent->setRed();
+                        node = grandParent;
+                        continue;
                     }
+                    if (node == parent->left) {
+                        this->rotateRight(parent);
+                        parent = node;
+                    }
+                    parent->setBlack();
+                    grandParent->setRed();
+                    this->rotateLeft(grandParent);
                 }
+                break;
             }
+            this->root->setBlack();
+        }
 
-            assert(key == node->key);
-            action(node);
-
-            if (this->size() == 1) {
-                // Current node is the only node of the tree
-                this->clear();
-                return true;
-            }
-
-            if (node->left != nullptr && node->right != nullptr) {
-                // clang-format off
-                // Case 1: If the node is strictly internal
-                //   Step 1. Find the successor S with the smallest key
-                //           and its parent P on the right subtree.
-                //   Step 2. Swap the data (key and value) of S and N,
-                //           S is the node that will be deleted in place of N.
-                //   Step 3. N = S, goto Case 2, 3
-                //     |                    |
-                //     N                    S
-                //    / \                  / \
-                //   L  ..   swap(N, S)   L  ..
-                //       |   =========>       |
-                //       P                    P
-                //      / \                  / \
-                //     S  ..                N  ..
-                // clang-format on
-
-                // Step 1
-                NodePtr successor = node->right;
-                NodePtr parent = node;
-                while (successor->left != nullptr) {
-                    parent = successor;
-                    successor = parent->left;
+        void removeNode(Node *node) noexcept {
+            // `child` replaces the removed position, it may be null so its parent is tracked separately
+            Node *child;
+            Node *childParent;
+            bool removedBlack = node->isBlack();
+
+            if (node->left == nullptr) {
+                child = node->right;
+                childParent = node->parent();
+                this->replaceChild(node, child);
+            } else if (node->right == nullptr) {
+                child = node->left;
+                childParent = node->parent();
+                this->replaceChild(node, child);
+            } else {
+                // Relink the successor in place of the node instead of swapping entries
+                Node *next = minimum(node->right);
+                removedBlack = next->isBlack();
+                child = next->right;
+                if (next->parent() == node) {
+                    childParent = next;
+                } else {
+                    childParent = next->parent();
+                    this->replaceChild(next, child);
+                    next->right = node->right;
+                    next->right->setParent(next);
                 }
-                // Step 2
-                swapNode(node, successor);
-                maintainRelationship(parent);
-                // Step 3: vvv
+                this->replaceChild(node, next);
+                next->left = node->left;
+                next->left->setParent(next);
+                next->setBlack(node->isBlack());
             }
 
-            if (node->isLeaf()) {
-                // Current node must not be the root
-                assert(node->parent != nullptr);
-
-                // Case 2: Current node is a leaf
-                //   Step 1. Unlink and remove it.
-                //   Step 2. If N is BLACK, maintain N;
-                //           If N is RED, do nothing.
-
-                // The maintain operation won't change the node itself,
-                //  so we can perform maintain operation before unlink the node.
-                if (node->isBlack()) {
-                    maintainAfterRemove(node);
-                }
-                if (node->direction() == Direction::LEFT) {
-                    node->parent->left = nullptr;
-                } else /* node->direction() == Direction::RIGHT */ {
-                    node->parent->right = nullptr;
-                }
-            } else /* !node->isLeaf() */ {
-                assert(node->left == nullptr || node->right == nullptr);
-                // Case 3: Current node has a single left or right child
-                //   Step 1. Replace N with its child
-                //   Step 2. If N is BLACK, maintain N
-                NodePtr parent = node->parent;
-                NodePtr replacement = (node->left != nullptr ? node->left : node->right);
-                switch (node->direction()) {
-                    case Direction::ROOT:
-                        this->root = replacement;
-                        break;
-                    case Direction::LEFT:
-                        parent->left = replacement;
-                        break;
-                    case Direction::RIGHT:
-                        parent->right = replacement;
-                        break;
-                }
-
-                if (!node->isRoot()) {
-                    replacement->parent = parent;
-                }
-
-                if (node->isBlack()) {
-                    if (replacement->isRed()) {
-                        replacement->color = Node::BLACK;
-                    } else {
-                        maintainAfterRemove(replacement);
-                    }
-                }
+            if (removedBlack) {
+                this->maintainAfterRemove(child, childParent);
             }
-
+            this->pool.destroy(node);
             this->count -= 1;
-            return true;
         }
 
-        void inorderTraversal(NodeConsumer action) const {
-            if (this->root == nullptr) {
-                return;
-            }
-
-            std::stack<NodePtr> stack;
-            NodePtr node = this->root;
-
-            while (node != nullptr || !stack.empty()) {
-                while (node != nullptr) {
-                    stack.push(node);
-                    node = node->left;
-                }
-                if (!stack.empty()) {
-                    node = stack.top();
-                    stack.pop();
-                    action(node);
-                    node = node->right;
+        void maintainAfterRemove(Node *node, Node *parent) noexcept {
+            while (node != this->root && isBlack(node)) {
+                if (node == parent->left) {
+                    Node *sibling = parent->right;
+                    if (sibling->isRed()) {
+                        sibling->setBlack();
+                        parent->setRed();
+                        this->rotateLeft(parent);
+                        sibling = parent->right;
+                    }
+                    if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                        sibling->setRed();
+                        node = parent;
+                        parent = node->parent();
+                        continue;
+                    }
+                    if (isBlack(sibling->right)) {
+                        sibling->left->setBlack();
+                        sibling->setRed();
+                        this->rotateRight(sibling);
+                        sibling = parent->right;
+                    }
+                    sibling->setBlack(parent->isBlack());
+                    parent->setBlack();
+                    sibling->right->setBlack();
+                    this->rotateLeft(parent);
+                } else {
+                    Node *sibling = parent->left;
+                    if (sibling->isRed()) {
+                        sibling->setBlack();
+                        parent->setRed();
+                        this->rotateRight(parent);
+                        sibling = parent->left;
+                    }
+                    if (isBlack(sibling->left) && isBlack(sibling->right)) {
+                        sibling->setRed();
+                        node = parent;
+                        parent = node->parent();
+                        continue;
+                    }
+                    if (isBlack(sibling->left)) {
+                        sibling->right->setBlack();
+                        sibling->setRed();
+                        this->rotateLeft(sibling);
+                        sibling = parent->left;
+                    }
+                    sibling->setBlack(parent->isBlack());
+                    parent->setBlack();
+                    sibling->left->setBlack();
+                    this->rotateRight(parent);
                 }
+                node = this->root;
+            }
+            if (node != nullptr) {
+                node->setBlack();
             }
         }
     };
@@ -0,0 +1,184 @@
+#pragma once
+
+/**
+ * Control bytes of the Swiss table behind `hash_map`, following the design of abseil's flat_hash_map.
+ */
+
+#include "polyfill.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define AVALANCHE_SWISS_TABLE_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#   include <arm_neon.h>
+#   define AVALANCHE_SWISS_TABLE_NEON 1
+#endif
+
+namespace avalanche::detail::swiss_table {
+
+    /**
+     * @brief A full slot stores the low 7 bits of its hash, so the sign bit tells empty and deleted slots apart.
+     */
+    using control_type = int8_t;
+
+    constexpr control_type empty_control = -128;
+    constexpr control_type deleted_control = -2;
+
+    constexpr size_t group_width = 16;
+
+    FORCEINLINE constexpr bool is_full(const control_type control) AVALANCHE_NOEXCEPT {
+        return control >= 0;
+    }
+
+    /**
+     * @brief Mixes hashes of poor quality (e.g. the identity hash of integers), every bit matters when splitting into
+     * the group index and the control byte.
+     */
+    FORCEINLINE constexpr size_t mix_hash(size_t hash) AVALANCHE_NOEXCEPT {
+        auto x = static_cast<uint64_t>(hash);
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+
+    FORCEINLINE constexpr size_t h1(const size_t hash) AVALANCHE_NOEXCEPT {
+        return hash >> 7;
+    }
+
+    FORCEINLINE constexpr control_type h2(const size_t hash) AVALANCHE_NOEXCEPT {
+        return static_cast<control_type>(hash & 0x7F);
+    }
+
+    /**
+     * @brief Slots of a group matching a predicate, iterated from the lowest index.
+     */
+    class bit_mask {
+    public:
+#if AVALANCHE_SWISS_TABLE_NEON
+        // One bit at the top of a nibble per slot
+        static constexpr uint32_t index_shift = 2;
+#else
+        static constexpr uint32_t index_shift = 0;
+#endif
+
+        explicit constexpr bit_mask(const uint64_t mask) AVALANCHE_NOEXCEPT : m_mask(mask) {}
+
+        AVALANCHE_NO_DISCARD constexpr bool has_any() const AVALANCHE_NOEXCEPT {
+            return m_mask != 0;
+        }
+
+        AVALANCHE_NO_DISCARD constexpr uint32_t lowest() const AVALANCHE_NOEXCEPT {
+            return static_cast<uint32_t>(std::countr_zero(m_mask)) >> index_shift;
+        }
+
+        constexpr bit_mask& operator++() AVALANCHE_NOEXCEPT {
+            m_mask &= m_mask - 1;
+            return *this;
+        }
+
+        AVALANCHE_NO_DISCARD constexpr uint32_t operator*() const AVALANCHE_NOEXCEPT {
+            return lowest();
+        }
+
+        constexpr bit_mask begin() const AVALANCHE_NOEXCEPT {
+            return *this;
+        }
+
+        constexpr bit_mask end() const AVALANCHE_NOEXCEPT {
+            return bit_mask(0);
+        }
+
+        constexpr bool operator!=(const bit_mask& other) const AVALANCHE_NOEXCEPT {
+            return m_mask != other.m_mask;
+        }
+
+    private:
+        uint64_t m_mask;
+    };
+
+    /**
+     * @brief 16 control bytes loaded at once, matched in a few instructions with SSE2 or NEON.
+     */
+    class control_group {
+    public:
+        explicit control_group(const control_type* controls) AVALANCHE_NOEXCEPT {
+#if AVALANCHE_SWISS_TABLE_SSE2
+            m_controls = _mm_loadu_si128(reinterpret_cast<const __m128i*>(controls));
+#elif AVALANCHE_SWISS_TABLE_NEON
+            m_controls = vld1q_s8(controls);
+#else
+            std::memcpy(m_controls, controls, group_width);
+#endif
+        }
+
+        AVALANCHE_NO_DISCARD bit_mask match(const control_type hash) const AVALANCHE_NOEXCEPT {
+#if AVALANCHE_SWISS_TABLE_SSE2
+            return bit_mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), m_controls))));
+#elif AVALANCHE_SWISS_TABLE_NEON
+            return to_bit_mask(vceqq_s8(vdupq_n_s8(hash), m_controls));
+#else
+            uint64_t mask = 0;
+            for (size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<uint64_t>(m_controls[i] == hash) << i;
+            }
+            return bit_mask(mask);
+#endif
+        }
+
+        AVALANCHE_NO_DISCARD bit_mask match_empty() const AVALANCHE_NOEXCEPT {
+            return match(empty_control);
+        }
+
+        AVALANCHE_NO_DISCARD bit_mask match_empty_or_deleted() const AVALANCHE_NOEXCEPT {
+            // Both have the sign bit set, while full slots don't
+#if AVALANCHE_SWISS_TABLE_SSE2
+            return bit_mask(static_cast<uint32_t>(_mm_movemask_epi8(m_controls)));
+#elif AVALANCHE_SWISS_TABLE_NEON
+            return to_bit_mask(vcltq_s8(m_controls, vdupq_n_s8(0)));
+#else
+            uint64_t mask = 0;
+            for (size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<uint64_t>(m_controls[i] < 0) << i;
+            }
+            return bit_mask(mask);
+#endif
+        }
+
+        AVALANCHE_NO_DISCARD bit_mask match_full() const AVALANCHE_NOEXCEPT {
+#if AVALANCHE_SWISS_TABLE_SSE2
+            return bit_mask(static_cast<uint32_t>(~_mm_movemask_epi8(m_controls)) & 0xFFFFu);
+#elif AVALANCHE_SWISS_TABLE_NEON
+            return to_bit_mask(vcgeq_s8(m_controls, vdupq_n_s8(0)));
+#else
+            uint64_t mask = 0;
+            for (size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<uint64_t>(m_controls[i] >= 0) << i;
+            }
+            return bit_mask(mask);
+#endif
+        }
+
+    private:
+#if AVALANCHE_SWISS_TABLE_SSE2
+        __m128i m_controls;
+#elif AVALANCHE_SWISS_TABLE_NEON
+        static bit_mask to_bit_mask(const uint8x16_t matched) AVALANCHE_NOEXCEPT {
+            // Narrow every byte to a nibble, then keep a single bit of each
+            const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matched), 4);
+            return bit_mask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull);
+        }
+
+        int8x16_t m_controls;
+#else
+        control_type m_controls[group_width];
+#endif
+    };
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "container/vector.hpp"
+
+namespace avalanche {
+
+    /**
+     * @brief Allocator that never provides any memory, vectors using it are limited to their inline capacity.
+     */
+    template <typename T>
+    class inplace_allocator {
+    public:
+        using value_type = T;
+        using pointer_type = T*;
+        using const_pointer_type = const T*;
+        using reference_type = T&;
+        using const_reference_type = const T&;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        inplace_allocator() noexcept = default;
+
+        template <typename U>
+        inplace_allocator(const inplace_allocator<U>&) AVALANCHE_NOEXCEPT {}
+
+        pointer_type allocate(size_type, const void* = nullptr) {
+            raise_exception(bad_alloc());
+            return nullptr;
+        }
+
+        void deallocate(pointer_type, size_type) AVALANCHE_NOEXCEPT {}
+
+        template <typename U, typename... Args>
+        void construct(U* p, Args&&... args) {
+            new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template <typename U>
+        void destroy(U* p) {
+            p->~U();
+        }
+
+        size_type max_size() const noexcept {
+            return 0;
+        }
+    };
+
+    /**
+     * @brief Vector of at most `N` elements stored inside itself, it never allocates.
+     *
+     * Growing past `N` raises `bad_alloc`, and leaves the vector untouched.
+     */
+    template <typename T, size_t N>
+    using inplace_vector = vector_base<T, inplace_allocator<T>, N>;
+
+}
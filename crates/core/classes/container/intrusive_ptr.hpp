@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include "polyfill.h"
+
+namespace avalanche {
+
+    /**
+     * @brief Smart pointer for objects carrying their own reference count.
+     *
+     * `T` must provide `add_reference()` and `release_reference()`, the latter is responsible for destroying the object
+     * when the last reference dropped. No control block is allocated, so the pointer is as cheap as a raw pointer to copy
+     * into lock-free queues (see `detach()` and `adopt()`).
+     */
+    template <typename T>
+    class intrusive_ptr {
+    public:
+        using value_type = T;
+        using value_pointer = value_type*;
+
+        intrusive_ptr() = default;
+        intrusive_ptr(std::nullptr_t) : intrusive_ptr() {}
+        explicit intrusive_ptr(value_pointer ptr) : m_value(ptr) {
+            if (m_value) {
+                m_value->add_reference();
+            }
+        }
+
+        intrusive_ptr(const intrusive_ptr& other) : intrusive_ptr(other.m_value) {}
+        intrusive_ptr(intrusive_ptr&& other) AVALANCHE_NOEXCEPT : m_value(std::exchange(other.m_value, nullptr)) {}
+
+        template <typename U>
+        requires std::is_convertible_v<U*, T*>
+        intrusive_ptr(const intrusive_ptr<U>& other) : intrusive_ptr(static_cast<value_pointer>(other.get())) {}
+
+        template <typename U>
+        requires std::is_convertible_v<U*, T*>
+        intrusive_ptr(intrusive_ptr<U>&& other) AVALANCHE_NOEXCEPT : m_value(other.detach()) {}
+
+        intrusive_ptr& operator=(const intrusive_ptr& other) {
+            if (this != &other) {
+                intrusive_ptr temp(other);
+                swap(temp);
+            }
+            return *this;
+        }
+
+        intrusive_ptr& operator=(intrusive_ptr&& other) AVALANCHE_NOEXCEPT {
+            if (this != &other) {
+                intrusive_ptr temp(std::move(other));
+                swap(temp);
+            }
+            return *this;
+        }
+
+        ~intrusive_ptr() {
+            reset();
+        }
+
+        void reset() {
+            if (value_pointer old = std::exchange(m_value, nullptr)) {
+                old->release_reference();
+            }
+        }
+
+        void swap(intrusive_ptr& other) AVALANCHE_NOEXCEPT {
+            std::swap(m_value, other.m_value);
+        }
+
+        /**
+         * @brief Give up the ownership without decreasing reference count.
+         */
+        AVALANCHE_NO_DISCARD value_pointer detach() AVALANCHE_NOEXCEPT {
+            return std::exchange(m_value, nullptr);
+        }
+
+        /**
+         * @brief Take the ownership of a pointer previously `detach()`ed without increasing reference count.
+         */
+        AVALANCHE_NO_DISCARD static intrusive_ptr adopt(value_pointer ptr) AVALANCHE_NOEXCEPT {
+            intrusive_ptr result{};
+            result.m_value = ptr;
+            return result;
+        }
+
+        value_pointer get() const {
+            return m_value;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_valid() const {
+            return m_value != nullptr;
+        }
+
+        explicit operator bool() const {
+            return is_valid();
+        }
+
+        value_pointer operator->() const {
+            return m_value;
+        }
+
+        value_type& operator*() const {
+            return *m_value;
+        }
+
+        template <typename U>
+        bool operator==(const intrusive_ptr<U>& other) const {
+            return static_cast<const void*>(m_value) == static_cast<const void*>(other.get());
+        }
+
+    private:
+        value_pointer m_value = nullptr;
+    };
+
+}
@@ -1,14 +1,22 @@
 #pragma once
 
-#include <memory>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
+#include <ranges>
 #include <utility>
+#include "container/utility.hpp"
 #include "container/impl/red_black_tree.hpp"
 
 namespace avalanche {
 
-    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    /**
+     * @brief Ordered map keyed by `Key` itself, iterated in key order.
+     *
+     * Backed by a red-black tree with pooled nodes, entries never move so iterators stay valid until their entry is
+     * removed. For small maps that are rarely modified, `flat_map` is faster.
+     */
+    template <typename Key, typename Value, typename Compare = std::less<Key>>
     class map_base {
     public:
         using key_type = Key;
@@ -18,20 +26,25 @@ namespace avalanche {
         using size_type = size_t;
         using value_reference_type = value_type&;
         using value_const_reference_type = const value_type&;
-        using hash_impl = Hash;
-        using hash_key_size = size_t;
-        using rb_tree_impl = RBTreeMap<hash_key_size, Value>;
+        using value_pointer_type = value_type*;
+        using value_const_pointer_type = const value_type*;
+        using key_compare = Compare;
+        using rb_tree_impl = RBTreeMap<key_type, value_type, key_compare>;
+        using entry_type = typename rb_tree_impl::Entry;
+        using iterator = typename rb_tree_impl::iterator;
+        using const_iterator = typename rb_tree_impl::const_iterator;
+        using range_type = std::ranges::subrange<iterator>;
+        using const_range_type = std::ranges::subrange<const_iterator>;
 
     private:
-        hash_impl m_hasher {};
         rb_tree_impl m_rb_tree{};
 
     public:
-        map_base() : m_hasher(hash_impl{}), m_rb_tree(rb_tree_impl{}) {}
-        explicit map_base(hash_impl impl) : m_hasher(std::move(impl)) {}
-        map_base(std::initializer_list<std::pair<key_type, value_type>> initializers) : map_base() {
+        map_base() = default;
+        explicit map_base(key_compare compare) : m_rb_tree(std::move(compare)) {}
+        map_base(std::initializer_list<pair<key_type, value_type>> initializers) : map_base() {
             for (auto& [key, value] : initializers) {
-                m_rb_tree.insert(m_hasher(key), value);
+                m_rb_tree.insert(key, value);
             }
         }
 
@@ -51,12 +64,16 @@ namespace avalanche {
             clear();
         }
 
+        void swap(map_base& other) AVALANCHE_NOEXCEPT {
+            m_rb_tree.swap(other.m_rb_tree);
+        }
+
         value_const_reference_type get(const key_type& key) const {
-            return m_rb_tree.get(m_hasher(key));
+            return m_rb_tree.get(key);
         }
 
         value_reference_type get(const key_type& key) {
-            return m_rb_tree.get(m_hasher(key));
+            return m_rb_tree.get(key);
         }
 
         value_reference_type operator[](key_const_reference_type key) {
@@ -68,38 +85,129 @@ namespace avalanche {
         }
 
         bool contains(const key_type& key) const {
-            return m_rb_tree.contains(m_hasher(key));
+            return m_rb_tree.contains(key);
+        }
+
+        value_pointer_type find(key_const_reference_type key) {
+            iterator it = m_rb_tree.find(key);
+            return it != m_rb_tree.end() ? &it.value() : nullptr;
+        }
+
+        value_const_pointer_type find(key_const_reference_type key) const {
+            const_iterator it = m_rb_tree.find(key);
+            return it != m_rb_tree.end() ? &it.value() : nullptr;
+        }
+
+        iterator find_entry(key_const_reference_type key) {
+            return m_rb_tree.find(key);
+        }
+
+        const_iterator find_entry(key_const_reference_type key) const {
+            return m_rb_tree.find(key);
         }
 
         value_type get_or_default(key_const_reference_type key, value_const_reference_type default_value) const {
-            return contains(key) ? get(key) : default_value;
+            value_const_pointer_type value = find(key);
+            return value != nullptr ? *value : default_value;
         }
 
         template <typename X = key_type, typename Y = value_type>
         requires std::convertible_to<const X&, key_const_reference_type> && std::convertible_to<Y, value_type>
         void insert(const X& key, Y&& value) {
-            m_rb_tree.insert(m_hasher(static_cast<key_const_reference_type>(key)), std::forward<Y>(value));
+            m_rb_tree.insert(static_cast<key_const_reference_type>(key), value_type(std::forward<Y>(value)));
         }
 
         template <typename X = key_type, typename Y = value_type>
         requires std::convertible_to<const X&, key_const_reference_type> && std::convertible_to<const Y&, value_type >
         bool insert_if_not_exist(const X& key, Y&& value) {
-            return m_rb_tree.insertIfAbsent(m_hasher(static_cast<key_const_reference_type>(key)), std::forward<Y>(value));
+            return m_rb_tree.tryEmplace(static_cast<key_const_reference_type>(key), std::forward<Y>(value)).second;
+        }
+
+        /**
+         * @brief Construct the value from `args` if `key` is absent, otherwise nothing is touched.
+         * @return The entry of `key`, and whether it was inserted
+         */
+        template <typename... Args>
+        pair<iterator, bool> try_emplace(key_const_reference_type key, Args&&... args) {
+            auto [it, is_inserted] = m_rb_tree.tryEmplace(key, std::forward<Args>(args)...);
+            return { it, is_inserted };
         }
 
         template <typename X = key_type, typename Y = value_type>
         requires std::convertible_to<const X&, const key_type&>
         bool remove(const X& key) {
-            return m_rb_tree.remove(key);
+            return m_rb_tree.remove(static_cast<key_const_reference_type>(key));
         }
 
         template <typename X = key_type, typename Y = value_type>
         requires std::convertible_to<const X&, const key_type&>
         value_type pop(const X& key) {
-            return m_rb_tree.getAndRemove(key);
+            return m_rb_tree.getAndRemove(static_cast<key_const_reference_type>(key));
+        }
+
+        /**
+         * @return Iterator to the entry following the erased one
+         */
+        iterator erase(const_iterator position) {
+            return m_rb_tree.remove(position);
+        }
+
+        /**
+         * @return Iterator to the first entry whose key is not less than `key`
+         */
+        iterator lower_bound(key_const_reference_type key) {
+            return m_rb_tree.lowerBound(key);
+        }
+
+        const_iterator lower_bound(key_const_reference_type key) const {
+            return m_rb_tree.lowerBound(key);
+        }
+
+        /**
+         * @return Iterator to the first entry whose key is greater than `key`
+         */
+        iterator upper_bound(key_const_reference_type key) {
+            return m_rb_tree.upperBound(key);
+        }
+
+        const_iterator upper_bound(key_const_reference_type key) const {
+            return m_rb_tree.upperBound(key);
+        }
+
+        /**
+         * @brief Entries whose key is in [from, to), in key order. Empty if `to` is less than `from`.
+         */
+        range_type range(key_const_reference_type from, key_const_reference_type to) {
+            if (m_rb_tree.keyCompare()(to, from)) {
+                return { end(), end() };
+            }
+            return { lower_bound(from), lower_bound(to) };
+        }
+
+        const_range_type range(key_const_reference_type from, key_const_reference_type to) const {
+            if (m_rb_tree.keyCompare()(to, from)) {
+                return { end(), end() };
+            }
+            return { lower_bound(from), lower_bound(to) };
+        }
+
+        iterator begin() AVALANCHE_NOEXCEPT {
+            return m_rb_tree.begin();
+        }
+
+        iterator end() AVALANCHE_NOEXCEPT {
+            return m_rb_tree.end();
+        }
+
+        const_iterator begin() const AVALANCHE_NOEXCEPT {
+            return m_rb_tree.begin();
+        }
+
+        const_iterator end() const AVALANCHE_NOEXCEPT {
+            return m_rb_tree.end();
         }
     };
 
-    template <typename Key, typename Value, typename Hash = std::hash<Key>>
-    using map = map_base<Key, Value, Hash>;
+    template <typename Key, typename Value, typename Compare = std::less<Key>>
+    using map = map_base<Key, Value, Compare>;
 }
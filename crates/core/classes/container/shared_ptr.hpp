@@ -30,7 +30,7 @@ namespace avalanche {
 
         inner_type decrease() {
             if AVALANCHE_CONSTEXPR (IsAtomic) {
-                return m_count.fetch_sub(1, std::memory_order_release) - 1;
+                return m_count.fetch_sub(1, std::memory_order_acq_rel) - 1;
             } else {
                 return --m_count;
             }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "container/vector.hpp"
+
+namespace avalanche {
+
+    /**
+     * @brief Vector storing up to `N` elements inside itself, the allocator is only used past them.
+     *
+     * Meant for lists that are short in the common case, such as adjacency lists or per-draw parameters. Moving it
+     * moves the inline elements one by one, unlike `vector` which only hands over its pointer.
+     */
+    template <typename T, size_t N, typename Allocator = default_allocator<T>>
+    using small_vector = vector_base<T, Allocator, N>;
+
+}
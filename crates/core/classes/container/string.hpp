@@ -2,6 +2,7 @@
 
 #include "polyfill.h"
 #include "container/allocator.hpp"
+#include "container/utility.hpp"
 #include <string_view>
 #include <format>
 
@@ -65,6 +66,10 @@ namespace avalanche
 
     };
 
+    // Nothing points into the object itself, `data()` picks the SSO buffer or the heap by `m_is_heap`
+    template <>
+    struct is_trivially_relocatable<simple_string> : std::true_type {};
+
     using string = simple_string;
 }
 
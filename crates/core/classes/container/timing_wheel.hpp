@@ -0,0 +1,179 @@
+#pragma once
+
+#include "container/vector.hpp"
+#include "polyfill.h"
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace avalanche {
+
+    /**
+     * @brief Hierarchical timing wheel, values are scheduled to expire at a tick (time unit chosen by the user).
+     *
+     * Level `k` has `NumSlots` slots spanning `NumSlots^k` ticks each, a value is placed on the lowest level whose slot
+     * is still ahead of the current tick, and moves down a level when the wheel reaches its slot. Scheduling is O(1),
+     * each value is moved at most once per level before expiring, and occupied slots are found with bit scans, so
+     * advancing over idle time and querying the next deadline are O(number of levels) as well.
+     */
+    template <typename T, size_t NumSlots = 64>
+    class timing_wheel {
+        static_assert(NumSlots > 1 && NumSlots <= 64 && (NumSlots & (NumSlots - 1)) == 0, "Number of slots in timing_wheel must be a power of two, up to 64");
+
+    public:
+        using value_type = T;
+        using tick_type = uint64_t;
+        using size_type = size_t;
+
+        static constexpr tick_type no_deadline = ~tick_type{0};
+
+        explicit timing_wheel(const tick_type current_tick = 0) : m_current_tick(current_tick) {}
+
+        /**
+         * @brief Expire `value` on the first advance reaching `deadline`, or on the next advance if it already passed.
+         */
+        void schedule(value_type value, tick_type deadline) {
+            if (deadline <= m_current_tick) {
+                deadline = m_current_tick + 1;
+            }
+            insert(entry{ deadline, std::move(value) });
+            ++m_size;
+        }
+
+        /**
+         * @brief Move the wheel to `now`, invoking `on_expired(value)` for every expired value.
+         *
+         * `on_expired` is allowed to schedule again, those are never expired by the same advance.
+         */
+        template <typename Function>
+        void advance(const tick_type now, Function&& on_expired) {
+            if (now <= m_current_tick) {
+                return;
+            }
+            m_expired.clear();
+            // Jump from an occupied slot to the next one, the ticks in between are never visited
+            for (slot_position next = next_occupied_slot(); next.tick != no_deadline && next.tick <= now; next = next_occupied_slot()) {
+                m_current_tick = next.tick;
+                m_cascading.swap(m_slots[next.level][next.index]);
+                m_occupied[next.level] &= ~(occupancy_type{1} << next.index);
+                for (entry& scheduled : m_cascading) {
+                    if (scheduled.deadline <= m_current_tick) {
+                        m_expired.push_back(std::move(scheduled));
+                    } else {
+                        insert(std::move(scheduled));
+                    }
+                }
+                m_cascading.clear();
+            }
+            m_current_tick = now;
+            m_size -= m_expired.size();
+
+            for (entry& expired : m_expired) {
+                on_expired(std::move(expired.value));
+            }
+            m_expired.clear();
+        }
+
+        /**
+         * @return The tick the wheel must be advanced to next, `no_deadline` if nothing is scheduled
+         *
+         * It is the earliest deadline if that is within the next `NumSlots` ticks. Otherwise it is the tick where the
+         * values of a higher level are moved down, which is never later than the earliest deadline.
+         */
+        AVALANCHE_NO_DISCARD tick_type earliest_deadline() const {
+            return next_occupied_slot().tick;
+        }
+
+        void clear() {
+            for (auto& level : m_slots) {
+                for (auto& slot : level) {
+                    slot.clear();
+                }
+            }
+            for (occupancy_type& occupied : m_occupied) {
+                occupied = 0;
+            }
+            m_size = 0;
+        }
+
+        AVALANCHE_NO_DISCARD tick_type current_tick() const AVALANCHE_NOEXCEPT {
+            return m_current_tick;
+        }
+
+        AVALANCHE_NO_DISCARD size_type size() const AVALANCHE_NOEXCEPT {
+            return m_size;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_empty() const AVALANCHE_NOEXCEPT {
+            return m_size == 0;
+        }
+
+    private:
+        using occupancy_type = uint64_t;
+
+        static constexpr size_type slot_bits = std::countr_zero(NumSlots);
+        static constexpr tick_type slot_mask = NumSlots - 1;
+        static constexpr size_type tick_bits = sizeof(tick_type) * 8;
+        static constexpr size_type num_levels = (tick_bits + slot_bits - 1) / slot_bits;
+
+        struct entry {
+            tick_type deadline;
+            value_type value;
+        };
+
+        struct slot_position {
+            tick_type tick;
+            size_type level;
+            size_type index;
+        };
+
+        static size_type slot_index(const tick_type tick, const size_type level) AVALANCHE_NOEXCEPT {
+            return static_cast<size_type>((tick >> (level * slot_bits)) & slot_mask);
+        }
+
+        /**
+         * @brief Place an entry due after the current tick on the level of the highest slot bits it differs in.
+         *
+         * The slot is then always ahead of the current slot of that level, in the same revolution.
+         */
+        void insert(entry&& scheduled) {
+            const tick_type differing_bits = scheduled.deadline ^ m_current_tick;
+            const size_type level = (static_cast<size_type>(std::bit_width(differing_bits)) - 1) / slot_bits;
+            const size_type index = slot_index(scheduled.deadline, level);
+            m_slots[level][index].push_back(std::move(scheduled));
+            m_occupied[level] |= occupancy_type{1} << index;
+        }
+
+        /**
+         * @brief First occupied slot after the current tick, and the tick it begins at.
+         *
+         * Every slot of a level ahead of the current one begins before any slot of the levels above.
+         */
+        AVALANCHE_NO_DISCARD slot_position next_occupied_slot() const AVALANCHE_NOEXCEPT {
+            for (size_type level = 0; level < num_levels; ++level) {
+                const size_type current_index = slot_index(m_current_tick, level);
+                if (current_index + 1 >= NumSlots) {
+                    continue;
+                }
+                const occupancy_type ahead = m_occupied[level] & (~occupancy_type{0} << (current_index + 1));
+                if (ahead == 0) {
+                    continue;
+                }
+                const auto index = static_cast<size_type>(std::countr_zero(ahead));
+                const size_type shift = level * slot_bits;
+                const size_type revolution_shift = shift + slot_bits;
+                const tick_type revolution_begin = revolution_shift < tick_bits ? m_current_tick >> revolution_shift << revolution_shift : 0;
+                return { revolution_begin | (static_cast<tick_type>(index) << shift), level, index };
+            }
+            return { no_deadline, 0, 0 };
+        }
+
+        vector<entry> m_slots[num_levels][NumSlots]{};
+        occupancy_type m_occupied[num_levels]{};
+        vector<entry> m_cascading{};
+        vector<entry> m_expired{};
+        tick_type m_current_tick;
+        size_type m_size = 0;
+    };
+
+}
@@ -1,8 +1,23 @@
 #pragma once
 
 #include <concepts>
+#include <type_traits>
+#include <utility>
 
 namespace avalanche {
+
+    /**
+     * @brief Whether moving a `T` then destroying the source is equivalent to copying its bytes.
+     *
+     * Containers relocate such elements with `memcpy`/`memmove` and may grow their storage with `realloc`. Trivially
+     * copyable types are relocatable, specialize it for types which don't point into themselves to opt them in.
+     */
+    template <typename T>
+    struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+    template <typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
     template <typename TyFirst, typename TySecond>
     class pair {
     public:
@@ -20,22 +35,24 @@ namespace avalanche {
         pair(const pair<U, V>& other) : first(other.first), second(other.second) {}
 
         template <typename T = TyFirst, typename U = TySecond>
-        requires std::convertible_to<T, TyFirst> && std::convertible_to<U, TySecond>
-        pair(const T& val1, const U& val2)
-            : first(static_cast<const TyFirst&>(val1))
-            , second(static_cast<const TySecond&>(val2))
+        requires std::constructible_from<TyFirst, T&&> && std::constructible_from<TySecond, U&&>
+        pair(T&& val1, U&& val2)
+            : first(std::forward<T>(val1))
+            , second(std::forward<U>(val2))
         {}
 
-        pair& operator=(const pair& other) {
-            if (this != &other) {
-                first = other.first();
-                second = other.second();
-            }
-            return *this;
-        }
+        pair(const pair& other) = default;
+        pair(pair&& other) = default;
+
+        pair& operator=(const pair& other) = default;
+        pair& operator=(pair&& other) = default;
 
     };
 
+    template <typename TyFirst, typename TySecond>
+    struct is_trivially_relocatable<pair<TyFirst, TySecond>>
+        : std::bool_constant<is_trivially_relocatable_v<TyFirst> && is_trivially_relocatable_v<TySecond>> {};
+
     template <typename TyFirst, typename TySecond>
     pair<TyFirst, TySecond> make_pair(TyFirst&& first, TySecond& second) {
         return pair<TyFirst, TySecond>(std::forward<TyFirst>(first), std::forward<TySecond>(second));
@@ -4,16 +4,55 @@
 #include <cstddef>
 #include <algorithm>
 #include <initializer_list>
+#include <memory>
 #include <functional>
 #include <concepts>
+#include <cstring>
 #include <span>
+#include <type_traits>
 #include "polyfill.h"
 #include "container/allocator.hpp"
 #include "container/exception.hpp"
+#include "container/utility.hpp"
 
 namespace avalanche {
 
-    template <typename T, AllocatorType Allocator = default_allocator<T>>
+    namespace detail {
+        /**
+         * @brief Uninitialized storage for the first `N` elements of a vector, takes no space if `N` is zero.
+         */
+        template <typename T, size_t N>
+        struct vector_inline_storage {
+            alignas(T) std::byte bytes[N * sizeof(T)];
+
+            T* data() AVALANCHE_NOEXCEPT {
+                return reinterpret_cast<T*>(bytes);
+            }
+
+            const T* data() const AVALANCHE_NOEXCEPT {
+                return reinterpret_cast<const T*>(bytes);
+            }
+        };
+
+        template <typename T>
+        struct vector_inline_storage<T, 0> {
+            T* data() AVALANCHE_NOEXCEPT {
+                return nullptr;
+            }
+
+            const T* data() const AVALANCHE_NOEXCEPT {
+                return nullptr;
+            }
+        };
+    }
+
+    /**
+     * @brief Contiguous growable array.
+     *
+     * The first `InlineCapacity` elements are stored inside the vector itself, the allocator is only used once it
+     * grows past them. See `small_vector` and `inplace_vector`.
+     */
+    template <typename T, AllocatorType Allocator = default_allocator<T>, size_t InlineCapacity = 0>
     class vector_base {
     public:
         using value_type = T;
@@ -29,50 +68,197 @@ namespace avalanche {
         using reverse_iterator_type = std::reverse_iterator<iterator_type>;
         using const_reverse_iterator_type = std::reverse_iterator<const_iterator_type>;
         using span_type = std::span<value_type>;
+        using growth_factor_type = float;
 
         static constexpr size_type npos = static_cast<size_type>(-1);
+        static constexpr size_type min_capacity = 8;
+        static constexpr size_type inline_capacity = InlineCapacity;
 
     private:
-        allocator_type m_allocator{};
-        pointer_type m_data = nullptr;
-        size_type m_capacity = 0;
+        // Elements are moved around with memcpy/memmove instead of one by one
+        static constexpr bool is_relocatable = is_trivially_relocatable_v<value_type>;
+        // Storage grows with realloc, which may extend the block in place
+        static constexpr bool can_reallocate = is_relocatable && requires(allocator_type& allocator, pointer_type pointer, size_type n) {
+            { allocator.reallocate(pointer, n, n) } -> std::same_as<pointer_type>;
+        };
+
+        AVALANCHE_NO_UNIQUE_ADDRESS allocator_type m_allocator{};
+        pointer_type m_data = inline_data();
+        size_type m_capacity = inline_capacity;
         size_type m_length = 0;
+        growth_factor_type m_growth_factor = 2.0f;
+        AVALANCHE_NO_UNIQUE_ADDRESS detail::vector_inline_storage<value_type, inline_capacity> m_inline_storage;
+
+        pointer_type inline_data() AVALANCHE_NOEXCEPT {
+            return m_inline_storage.data();
+        }
+
+        AVALANCHE_NO_DISCARD bool is_inline() const AVALANCHE_NOEXCEPT {
+            if constexpr (inline_capacity > 0) {
+                return m_data == m_inline_storage.data();
+            } else {
+                return false;
+            }
+        }
+
+        /**
+         * @brief Give the heap storage back to the allocator, elements must have been destroyed or moved out.
+         */
+        void release_storage() AVALANCHE_NOEXCEPT {
+            if (m_data && !is_inline()) {
+                m_allocator.deallocate(m_data, m_capacity);
+            }
+            m_data = inline_data();
+            m_capacity = inline_capacity;
+        }
+
+        /**
+         * @brief Take the elements of `other`, which is left empty. Our storage must be released beforehand.
+         */
+        void steal_from(vector_base& other) AVALANCHE_NOEXCEPT {
+            if (other.is_inline()) {
+                // Inline elements can't change hands, move them one by one
+                relocate(m_data, other.m_data, other.m_length);
+            } else {
+                m_data = other.m_data;
+                m_capacity = other.m_capacity;
+                other.m_data = other.inline_data();
+                other.m_capacity = inline_capacity;
+            }
+            m_length = other.m_length;
+            other.m_length = 0;
+        }
 
         void check_index(size_type index) const {
             if (index >= m_length)
                 raise_exception(out_of_range());
         }
 
-        void resize_internal(size_type new_capacity = 0) {
-            if (new_capacity == 0) {
-                new_capacity = m_capacity ? m_capacity * 2 : 8;
+        /**
+         * @brief Move `count` elements into uninitialized `destination`, the source is left uninitialized.
+         */
+        void relocate(pointer_type destination, pointer_type source, size_type count) {
+            if constexpr (is_relocatable) {
+                if (count > 0) {
+                    std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), count * sizeof(value_type));
+                }
+            } else {
+                for (size_type i = 0; i < count; ++i) {
+                    m_allocator.construct(destination + i, std::move(source[i]));
+                    m_allocator.destroy(source + i);
+                }
             }
+        }
 
-            if (new_capacity < m_capacity) {
-                return;
+        /**
+         * @brief Open an uninitialized slot at `index` by moving the elements after it one slot right.
+         */
+        void shift_right(size_type index) {
+            if constexpr (is_relocatable) {
+                std::memmove(static_cast<void*>(m_data + index + 1), static_cast<const void*>(m_data + index), (m_length - index) * sizeof(value_type));
+            } else {
+                for (size_type i = m_length; i > index; --i) {
+                    m_allocator.construct(m_data + i, std::move(m_data[i - 1]));
+                    m_allocator.destroy(m_data + i - 1);
+                }
             }
+        }
 
-            pointer_type new_data = m_allocator.allocate(new_capacity);
-            AVALANCHE_CHECK(m_length <= m_capacity, "vector conatiner internal error: length > capacity");
-            for (size_type i = 0; i < m_length; ++i) {
-                AVALANCHE_CHECK(m_data != nullptr, "vector conatiner internal error: invalid memory access");
-                m_allocator.construct(new_data + i, std::move(m_data[i]));
-                m_allocator.destroy(m_data + i);
+        /**
+         * @brief Close the already destroyed slot at `index` by moving the elements after it one slot left.
+         */
+        void shift_left(size_type index) {
+            if constexpr (is_relocatable) {
+                std::memmove(static_cast<void*>(m_data + index), static_cast<const void*>(m_data + index + 1), (m_length - index - 1) * sizeof(value_type));
+            } else {
+                for (size_type i = index; i + 1 < m_length; ++i) {
+                    m_allocator.construct(m_data + i, std::move(m_data[i + 1]));
+                    m_allocator.destroy(m_data + i + 1);
+                }
             }
+        }
 
-            if (m_data) {
+        /**
+         * @brief Move the elements to storage of exactly `new_capacity`, which must hold all of them.
+         *
+         * Any capacity up to the inline one is served by the inline storage, the heap storage is freed then.
+         */
+        void reallocate_storage(size_type new_capacity) {
+            AVALANCHE_CHECK(m_length <= new_capacity, "vector conatiner internal error: length > capacity");
+            if (new_capacity <= inline_capacity) {
+                if (!is_inline()) {
+                    pointer_type old_data = m_data;
+                    const size_type old_capacity = m_capacity;
+                    relocate(inline_data(), old_data, m_length);
+                    if (old_data) {
+                        m_allocator.deallocate(old_data, old_capacity);
+                    }
+                    m_data = inline_data();
+                    m_capacity = inline_capacity;
+                }
+                return;
+            }
+            if constexpr (can_reallocate) {
+                if (m_data && !is_inline()) {
+                    m_data = m_allocator.reallocate(m_data, m_capacity, new_capacity);
+                    m_capacity = new_capacity;
+                    return;
+                }
+            }
+            pointer_type new_data = m_allocator.allocate(new_capacity);
+            relocate(new_data, m_data, m_length);
+            if (m_data && !is_inline()) {
                 m_allocator.deallocate(m_data, m_capacity);
             }
-
             m_data = new_data;
             m_capacity = new_capacity;
         }
 
+        AVALANCHE_NO_DISCARD size_type grown_capacity(size_type required) const {
+            size_type grown = m_capacity ? static_cast<size_type>(static_cast<growth_factor_type>(m_capacity) * m_growth_factor) : min_capacity;
+            grown = std::max(grown, m_capacity + 1);
+            return std::max(grown, required);
+        }
+
+        /**
+         * @brief Grow by the growth factor if the capacity is below `required`, keeping appends amortized O(1).
+         */
+        void resize_internal(size_type required = 0) {
+            if (required == 0 || required > m_capacity) {
+                reallocate_storage(grown_capacity(required));
+            }
+        }
+
+        void copy_from(const vector_base& other) {
+            if (other.m_length > m_capacity) {
+                reallocate_storage(other.m_length);
+            }
+            if constexpr (std::is_trivially_copyable_v<value_type>) {
+                if (other.m_length > 0) {
+                    std::memcpy(static_cast<void*>(m_data), static_cast<const void*>(other.m_data), other.m_length * sizeof(value_type));
+                }
+            } else {
+                for (size_type i = 0; i < other.m_length; ++i) {
+                    m_allocator.construct(m_data + i, other.m_data[i]);
+                }
+            }
+            m_length = other.m_length;
+        }
+
+        void truncate(size_type new_size) {
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (size_type i = new_size; i < m_length; ++i) {
+                    m_allocator.destroy(m_data + i);
+                }
+            }
+            m_length = new_size;
+        }
+
     public:
-        vector_base() : m_data(nullptr), m_capacity(0), m_length(0) {}
-        explicit vector_base(const allocator_type& allocator) : m_allocator(allocator), m_data(nullptr), m_capacity(0), m_length(0) {}
+        vector_base() = default;
+        explicit vector_base(const allocator_type& allocator) : m_allocator(allocator) {}
         explicit vector_base(size_type default_capacity) : vector_base() {
-            resize_internal(default_capacity);
+            reserve(default_capacity);
         }
 
         template <typename U = value_type>
@@ -93,38 +279,24 @@ namespace avalanche {
 
         ~vector_base() {
             clear();
-            if (m_data) {
-                m_allocator.deallocate(m_data, m_capacity);
-            }
+            release_storage();
         }
 
-        vector_base(const vector_base& other) {
-            resize_internal(m_capacity);
-            for (size_type i = 0; i < other.m_length; ++i) {
-                m_allocator.construct(m_data + i, other.m_data[i]);
-            }
-            m_length = other.m_length;
+        vector_base(const vector_base& other) : m_allocator(other.m_allocator), m_growth_factor(other.m_growth_factor) {
+            copy_from(other);
         }
 
         vector_base(vector_base&& other) AVALANCHE_NOEXCEPT
             : m_allocator(std::move(other.m_allocator))
-            , m_data(other.m_data)
-            , m_capacity(other.m_capacity)
-            , m_length(other.m_length)
+            , m_growth_factor(other.m_growth_factor)
         {
-            other.m_data = nullptr;
-            other.m_length = 0;
-            other.m_capacity = 0;
+            steal_from(other);
         }
 
         vector_base& operator=(const vector_base& other) {
             if (this != &other) {
                 clear();
-                resize_internal(other.m_capacity);
-                for (size_type i = 0; i < other.m_length; ++i) {
-                    m_allocator.construct(m_data + i, other.m_data[i]);
-                }
-                m_length = other.m_length;
+                copy_from(other);
             }
             return *this;
         }
@@ -132,13 +304,10 @@ namespace avalanche {
         vector_base& operator=(vector_base&& other) AVALANCHE_NOEXCEPT {
             if (this != &other) {
                 clear();
+                release_storage();
                 m_allocator = std::move(other.m_allocator);
-                m_data = other.m_data;
-                m_capacity = other.m_capacity;
-                m_length = other.m_length;
-                other.m_data = nullptr;
-                other.m_length = 0;
-                other.m_capacity = 0;
+                m_growth_factor = other.m_growth_factor;
+                steal_from(other);
             }
             return *this;
         }
@@ -146,21 +315,13 @@ namespace avalanche {
         template <typename U = value_type>
         requires std::convertible_to<const U&, value_type>
         size_type add_item(const U& value) {
-            if (m_length == m_capacity) {
-                resize_internal();
-            }
-            m_allocator.construct(m_data + m_length, value);
-            return m_length++;
+            return emplace_back(value);
         }
 
         template <typename U = value_type>
         requires std::convertible_to<U&&, value_type>
         size_type add_item(U&& value) {
-            if (m_length == m_capacity) {
-                resize_internal();
-            }
-            m_allocator.construct(m_data + m_length, std::forward<U>(value));
-            return m_length++;
+            return emplace_back(std::forward<U>(value));
         }
 
         template <typename U = value_type>
@@ -177,30 +338,40 @@ namespace avalanche {
 
         template <typename... Args>
         size_type emplace_back(Args&&... vals) {
-            if (m_length == m_capacity) {
+            if (m_length == m_capacity) AVALANCHE_UNLIKELY_BRANCH {
+                // Arguments might refer to our own elements, build the value before the storage moves
+                value_type value(std::forward<Args>(vals)...);
                 resize_internal();
+                m_allocator.construct(m_data + m_length, std::move(value));
+            } else {
+                m_allocator.construct(m_data + m_length, std::forward<Args>(vals)...);
             }
-            m_allocator.construct(m_data + m_length, std::forward<Args>(vals)...);
             return m_length++;
         }
 
+        /**
+         * @brief Insert before `index`, which may be `size()` to append.
+         */
         template <typename... Args>
         void emplace_at(size_type index, Args&&... vals) {
-            check_index(index);
+            if (index > m_length) {
+                raise_exception(out_of_range());
+            }
+            // Arguments might refer to our own elements, which are about to move
+            value_type value(std::forward<Args>(vals)...);
             if (m_length == m_capacity) {
                 resize_internal();
             }
-            for (size_type i = m_length; i > index; --i) {
-                m_allocator.construct(m_data + i, std::move(m_data[i - 1]));
-                m_allocator.destroy(m_data + i - 1);
-            }
-            m_allocator.construct(m_data + index, std::forward<Args>(vals)...);
+            shift_right(index);
+            m_allocator.construct(m_data + index, std::move(value));
             ++m_length;
         }
 
         void clear() {
-            for (size_type i = 0; i < m_length; ++i) {
-                m_allocator.destroy(m_data + i);
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (size_type i = 0; i < m_length; ++i) {
+                    m_allocator.destroy(m_data + i);
+                }
             }
             m_length = 0;
         }
@@ -227,26 +398,17 @@ namespace avalanche {
         void remove_at(size_type index) {
             check_index(index);
             m_allocator.destroy(m_data + index);
-            for (size_type i = index; i < m_length - 1; ++i) {
-                m_allocator.construct(m_data + i, std::move(m_data[i + 1]));
-                m_allocator.destroy(m_data + i + 1);
-            }
+            shift_left(index);
             --m_length;
         }
 
+        /**
+         * @brief Insert before `index`, which may be `size()` to append.
+         */
         template <typename U = value_type>
         requires(std::is_convertible_v<U, value_type>)
         void insert_at(size_type index, const U& value) {
-            check_index(index);
-            if (m_length == m_capacity) {
-                resize_internal();
-            }
-            for (size_type i = m_length; i > index; --i) {
-                m_allocator.construct(m_data + i, std::move(m_data[i - 1]));
-                m_allocator.destroy(m_data + i - 1);
-            }
-            m_allocator.construct(m_data + index, value);
-            ++m_length;
+            emplace_at(index, value);
         }
 
         iterator_type begin() {
@@ -330,11 +492,86 @@ namespace avalanche {
             }
         }
 
+        /**
+         * @brief Grow the storage to exactly `new_capacity` if it is smaller.
+         */
         void ensure_capacity(size_type new_capacity) {
             if (m_capacity >= new_capacity) {
                 return;
             }
-            resize_internal(new_capacity);
+            reallocate_storage(new_capacity);
+        }
+
+        void reserve(size_type new_capacity) {
+            ensure_capacity(new_capacity);
+        }
+
+        /**
+         * @brief Release the unused capacity, elements move back to the inline storage if they fit.
+         */
+        void shrink_to_fit() {
+            if (m_length < m_capacity) {
+                reallocate_storage(m_length);
+            }
+        }
+
+        /**
+         * @brief Set the factor the capacity is multiplied by when the vector is full, 2 by default.
+         *
+         * Smaller factors waste less memory, larger ones copy less often.
+         */
+        void set_growth_factor(growth_factor_type new_factor) {
+            AVALANCHE_CHECK(new_factor > 1.0f, "Growth factor of vector must be greater than 1");
+            m_growth_factor = new_factor;
+        }
+
+        AVALANCHE_NO_DISCARD growth_factor_type growth_factor() const AVALANCHE_NOEXCEPT {
+            return m_growth_factor;
+        }
+
+        /**
+         * @brief Change the size, new elements are value-initialized.
+         */
+        void resize(size_type new_size) {
+            if (new_size <= m_length) {
+                truncate(new_size);
+                return;
+            }
+            resize_internal(new_size);
+            for (size_type i = m_length; i < new_size; ++i) {
+                m_allocator.construct(m_data + i);
+            }
+            m_length = new_size;
+        }
+
+        /**
+         * @brief Change the size, new elements are copies of `value`.
+         */
+        void resize(size_type new_size, const_reference_type value) {
+            if (new_size <= m_length) {
+                truncate(new_size);
+                return;
+            }
+            if (new_size > m_capacity) {
+                // `value` might be one of our own elements, which are about to move
+                value_type copy(value);
+                resize_internal(new_size);
+                std::uninitialized_fill(m_data + m_length, m_data + new_size, copy);
+            } else {
+                std::uninitialized_fill(m_data + m_length, m_data + new_size, value);
+            }
+            m_length = new_size;
+        }
+
+        /**
+         * @brief Change the size without initializing new elements, for bulk I/O filling them right after.
+         */
+        void resize_uninitialized(size_type new_size)
+        requires std::is_trivially_default_constructible_v<value_type> && std::is_trivially_destructible_v<value_type> {
+            if (new_size > m_capacity) {
+                resize_internal(new_size);
+            }
+            m_length = new_size;
         }
 
         void sort(std::function<bool(const_reference_type,const_reference_type)> comparator) {
@@ -342,16 +579,26 @@ namespace avalanche {
         }
 
         void swap(vector_base& other) AVALANCHE_NOEXCEPT {
+            if (is_inline() || other.is_inline()) {
+                vector_base temp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(temp);
+                return;
+            }
             std::swap(m_length, other.m_length);
             std::swap(m_capacity, other.m_capacity);
             std::swap(m_data, other.m_data);
             std::swap(m_allocator, other.m_allocator);
+            std::swap(m_growth_factor, other.m_growth_factor);
         }
 
         AVALANCHE_NO_DISCARD bool is_valid_index(size_type index) const {
             return index < m_length;
         }
 
+        /**
+         * @brief Change the size without constructing or destroying anything, the caller manages element lifetimes.
+         */
         void set_size_uninitialized(size_type new_size) {
             if (new_size > m_capacity) {
                 resize_internal(new_size);
@@ -360,10 +607,7 @@ namespace avalanche {
         }
 
         void set_size_defaulted(size_type new_size) {
-            set_size_uninitialized(new_size);
-            for (size_type i = 0; i < m_length; ++i) {
-                m_allocator.construct(m_data + i);
-            }
+            resize(new_size);
         }
 
         AVALANCHE_NO_DISCARD bool is_empty() const {
@@ -392,6 +636,11 @@ namespace avalanche {
 
     };
 
+    // Only holds a pointer to its storage, unless elements are stored inline and the pointer refers to the vector itself
+    template <typename T, typename Allocator, size_t InlineCapacity>
+    struct is_trivially_relocatable<vector_base<T, Allocator, InlineCapacity>>
+        : std::bool_constant<InlineCapacity == 0 && is_trivially_relocatable_v<Allocator>> {};
+
     template <typename T, typename Allocator = default_allocator<T>>
     using vector = vector_base<T, Allocator>;
 
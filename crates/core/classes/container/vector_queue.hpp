@@ -1,45 +1,504 @@
 #pragma once
 
-#include "container/vector.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "polyfill.h"
+#include "container/allocator.hpp"
+#include "container/exception.hpp"
+#include "container/utility.hpp"
 
 namespace avalanche {
 
+    /**
+     * @brief What a bounded queue does with a new element when it is full.
+     */
+    enum class queue_overflow : uint8_t {
+        // Not bounded, the storage grows
+        grow,
+        // The new element is dropped, push returns false
+        reject,
+        // The element at the opposite end is dropped to make room
+        overwrite,
+    };
+
+    /**
+     * @brief Double-ended queue stored in a circular buffer of power of two capacity.
+     *
+     * Pushing and popping at both ends is O(1), growing is amortized O(1) and unwraps the elements to the beginning of
+     * the new storage. Slots are reused as soon as their element is popped, a long-lived queue only takes as much
+     * memory as its peak size.
+     *
+     * A queue constructed with `queue_overflow::reject` or `queue_overflow::overwrite` holds at most the given number
+     * of elements and never allocates after construction.
+     */
     template <typename T, AllocatorType Allocator = default_allocator<T>>
-    class vector_queue_base : public vector_base<T, Allocator> {
+    class vector_queue_base {
     public:
-        // Using constructor from vector_base
-        using vector_base<T, Allocator>::vector_base;
+        using value_type = T;
+        using allocator_type = Allocator;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+        using reference_type = value_type&;
+        using const_reference_type = const value_type&;
+        using pointer_type = typename std::allocator_traits<Allocator>::pointer;
+        using const_pointer_type = typename std::allocator_traits<Allocator>::const_pointer;
+
+        static constexpr size_type npos = static_cast<size_type>(-1);
+        static constexpr size_type min_capacity = 8;
+
+        template <bool IsConst>
+        class iterator_base {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = ptrdiff_t;
+            using pointer = std::conditional_t<IsConst, const T*, T*>;
+            using reference = std::conditional_t<IsConst, const T&, T&>;
+            using queue_pointer_type = std::conditional_t<IsConst, const vector_queue_base*, vector_queue_base*>;
+
+            iterator_base() = default;
+            iterator_base(queue_pointer_type queue, size_type index) : m_queue(queue), m_index(index) {}
+
+            // Mutable iterators convert to const ones
+            template <bool OtherIsConst>
+            requires (IsConst && !OtherIsConst)
+            iterator_base(const iterator_base<OtherIsConst>& other) : m_queue(other.m_queue), m_index(other.m_index) {}
+
+            reference operator*() const {
+                return m_queue->m_data[m_queue->physical_index(m_index)];
+            }
+
+            pointer operator->() const {
+                return &**this;
+            }
+
+            iterator_base& operator++() {
+                ++m_index;
+                return *this;
+            }
+
+            iterator_base operator++(int) {
+                iterator_base old = *this;
+                ++m_index;
+                return old;
+            }
+
+            iterator_base& operator--() {
+                --m_index;
+                return *this;
+            }
+
+            iterator_base operator--(int) {
+                iterator_base old = *this;
+                --m_index;
+                return old;
+            }
+
+            bool operator==(const iterator_base& other) const {
+                return m_index == other.m_index && m_queue == other.m_queue;
+            }
+
+        private:
+            queue_pointer_type m_queue = nullptr;
+            // Logical index, 0 is the front
+            size_type m_index = 0;
 
-        using Super = vector_base<T, Allocator>;
-        using size_type = typename Super::size_type;
-        using value_type = typename Super::value_type;
-        using reference_type = typename Super::reference_type;
-        using const_reference_type = typename Super::const_reference_type;
+            template <bool>
+            friend class iterator_base;
+        };
+
+        using iterator_type = iterator_base<false>;
+        using const_iterator_type = iterator_base<true>;
+
+    private:
+        static constexpr bool is_relocatable = is_trivially_relocatable_v<value_type>;
+
+        AVALANCHE_NO_UNIQUE_ADDRESS allocator_type m_allocator{};
+        pointer_type m_data = nullptr;
+        // Always zero or a power of two, so wrapping around is a mask
+        size_type m_capacity = 0;
+        // Physical index of the front element
+        size_type m_head = 0;
+        size_type m_length = 0;
+        size_type m_max_size = npos;
+        queue_overflow m_overflow = queue_overflow::grow;
+
+        AVALANCHE_NO_DISCARD size_type physical_index(size_type index) const AVALANCHE_NOEXCEPT {
+            return (m_head + index) & (m_capacity - 1);
+        }
+
+        static size_type round_up_capacity(size_type count) {
+            size_type capacity = min_capacity;
+            while (capacity < count) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        /**
+         * @brief Move the elements to storage of `new_capacity` slots, the front lands at the first slot.
+         */
+        void reallocate_storage(size_type new_capacity) {
+            AVALANCHE_CHECK(m_length <= new_capacity, "vector_queue internal error: length > capacity");
+            pointer_type new_data = m_allocator.allocate(new_capacity);
+            if (m_data) {
+                // Elements are split in two runs if they wrap around the end of the storage
+                const size_type first_run = std::min(m_length, m_capacity - m_head);
+                relocate(new_data, m_data + m_head, first_run);
+                relocate(new_data + first_run, m_data, m_length - first_run);
+                m_allocator.deallocate(m_data, m_capacity);
+            }
+            m_data = new_data;
+            m_capacity = new_capacity;
+            m_head = 0;
+        }
+
+        void relocate(pointer_type destination, pointer_type source, size_type count) {
+            if constexpr (is_relocatable) {
+                if (count > 0) {
+                    std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), count * sizeof(value_type));
+                }
+            } else {
+                for (size_type i = 0; i < count; ++i) {
+                    m_allocator.construct(destination + i, std::move(source[i]));
+                    m_allocator.destroy(source + i);
+                }
+            }
+        }
+
+        /**
+         * @brief Make room for one more element once the queue is full.
+         * @return false if the element must be dropped
+         */
+        template <bool AtBack>
+        bool make_room() {
+            switch (m_overflow) {
+                case queue_overflow::grow:
+                    reallocate_storage(m_capacity ? m_capacity * 2 : min_capacity);
+                    return true;
+                case queue_overflow::reject:
+                    return false;
+                case queue_overflow::overwrite:
+                    if (m_length == 0) {
+                        return false;
+                    }
+                    if constexpr (AtBack) {
+                        pop_front_internal();
+                    } else {
+                        pop_back_internal();
+                    }
+                    return true;
+            }
+            return false;
+        }
+
+        void pop_front_internal() {
+            m_allocator.destroy(m_data + m_head);
+            m_head = physical_index(1);
+            --m_length;
+        }
+
+        void pop_back_internal() {
+            m_allocator.destroy(m_data + physical_index(m_length - 1));
+            --m_length;
+        }
+
+        /**
+         * @brief Copy the elements of `other` into this queue, which must be empty.
+         */
+        void copy_from(const vector_queue_base& other) {
+            // A bounded queue never grows later, it needs room for its bound up front
+            reserve(other.m_overflow != queue_overflow::grow ? other.m_max_size : other.m_length);
+            for (size_type i = 0; i < other.m_length; ++i) {
+                m_allocator.construct(m_data + i, other[i]);
+            }
+            m_length = other.m_length;
+            m_max_size = other.m_max_size;
+            m_overflow = other.m_overflow;
+        }
+
+        void check_index(size_type index) const {
+            if (index >= m_length)
+                raise_exception(out_of_range());
+        }
+
+    public:
+        vector_queue_base() = default;
+
+        explicit vector_queue_base(const allocator_type& allocator) : m_allocator(allocator) {}
+
+        /**
+         * @param capacity Number of elements to reserve room for, the maximum number of elements if bounded
+         * @param overflow Whether the queue is bounded, and what happens once it's full
+         */
+        explicit vector_queue_base(size_type capacity, queue_overflow overflow = queue_overflow::grow) : m_overflow(overflow) {
+            if (overflow != queue_overflow::grow) {
+                AVALANCHE_CHECK(capacity > 0, "Bounded vector_queue must be able to hold one element at least");
+                m_max_size = capacity;
+            }
+            reserve(capacity);
+        }
+
+        ~vector_queue_base() {
+            clear();
+            if (m_data) {
+                m_allocator.deallocate(m_data, m_capacity);
+            }
+        }
+
+        vector_queue_base(const vector_queue_base& other) : m_allocator(other.m_allocator) {
+            copy_from(other);
+        }
+
+        vector_queue_base(vector_queue_base&& other) AVALANCHE_NOEXCEPT
+            : m_allocator(std::move(other.m_allocator))
+            , m_data(std::exchange(other.m_data, nullptr))
+            , m_capacity(std::exchange(other.m_capacity, 0))
+            , m_head(std::exchange(other.m_head, 0))
+            , m_length(std::exchange(other.m_length, 0))
+            , m_max_size(std::exchange(other.m_max_size, npos))
+            , m_overflow(std::exchange(other.m_overflow, queue_overflow::grow))
+        {}
+
+        vector_queue_base& operator=(const vector_queue_base& other) {
+            if (this != &other) {
+                clear();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        vector_queue_base& operator=(vector_queue_base&& other) AVALANCHE_NOEXCEPT {
+            if (this != &other) {
+                clear();
+                if (m_data) {
+                    m_allocator.deallocate(m_data, m_capacity);
+                }
+                m_allocator = std::move(other.m_allocator);
+                m_data = std::exchange(other.m_data, nullptr);
+                m_capacity = std::exchange(other.m_capacity, 0);
+                m_head = std::exchange(other.m_head, 0);
+                m_length = std::exchange(other.m_length, 0);
+                // The moved-from queue has no storage left, it grows again like a default constructed one
+                m_max_size = std::exchange(other.m_max_size, npos);
+                m_overflow = std::exchange(other.m_overflow, queue_overflow::grow);
+            }
+            return *this;
+        }
+
+        void swap(vector_queue_base& other) AVALANCHE_NOEXCEPT {
+            std::swap(m_allocator, other.m_allocator);
+            std::swap(m_data, other.m_data);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_head, other.m_head);
+            std::swap(m_length, other.m_length);
+            std::swap(m_max_size, other.m_max_size);
+            std::swap(m_overflow, other.m_overflow);
+        }
+
+        /**
+         * @return false if the queue is bounded, full, and rejects new elements
+         */
+        template <typename... Args>
+        bool emplace_back(Args&&... vals) {
+            if (m_length == m_capacity || m_length == m_max_size) AVALANCHE_UNLIKELY_BRANCH {
+                // Arguments might refer to our own elements, build the value before they move or get dropped
+                value_type value(std::forward<Args>(vals)...);
+                if (!make_room<true>()) {
+                    return false;
+                }
+                m_allocator.construct(m_data + physical_index(m_length), std::move(value));
+            } else {
+                m_allocator.construct(m_data + physical_index(m_length), std::forward<Args>(vals)...);
+            }
+            ++m_length;
+            return true;
+        }
+
+        /**
+         * @return false if the queue is bounded, full, and rejects new elements
+         */
+        template <typename... Args>
+        bool emplace_front(Args&&... vals) {
+            if (m_length == m_capacity || m_length == m_max_size) AVALANCHE_UNLIKELY_BRANCH {
+                value_type value(std::forward<Args>(vals)...);
+                if (!make_room<false>()) {
+                    return false;
+                }
+                m_head = physical_index(m_capacity - 1);
+                m_allocator.construct(m_data + m_head, std::move(value));
+            } else {
+                m_head = physical_index(m_capacity - 1);
+                m_allocator.construct(m_data + m_head, std::forward<Args>(vals)...);
+            }
+            ++m_length;
+            return true;
+        }
+
+        bool push_back(const_reference_type value) {
+            return emplace_back(value);
+        }
+
+        bool push_back(value_type&& value) {
+            return emplace_back(std::move(value));
+        }
+
+        bool push_front(const_reference_type value) {
+            return emplace_front(value);
+        }
+
+        bool push_front(value_type&& value) {
+            return emplace_front(std::move(value));
+        }
+
+        value_type pop_front() {
+            AVALANCHE_CHECK(!is_empty(), "Function pop_front() is unavailable to use while vector_queue is empty");
+            value_type value = std::move(m_data[m_head]);
+            pop_front_internal();
+            return value;
+        }
+
+        value_type pop_back() {
+            AVALANCHE_CHECK(!is_empty(), "Function pop_back() is unavailable to use while vector_queue is empty");
+            value_type value = std::move(m_data[physical_index(m_length - 1)]);
+            pop_back_internal();
+            return value;
+        }
+
+        reference_type front() {
+            AVALANCHE_CHECK(!is_empty(), "Function front() is unavailable to use while vector_queue is empty");
+            return m_data[m_head];
+        }
+
+        const_reference_type front() const {
+            AVALANCHE_CHECK(!is_empty(), "Function front() is unavailable to use while vector_queue is empty");
+            return m_data[m_head];
+        }
+
+        reference_type back() {
+            AVALANCHE_CHECK(!is_empty(), "Function back() is unavailable to use while vector_queue is empty");
+            return m_data[physical_index(m_length - 1)];
+        }
+
+        const_reference_type back() const {
+            AVALANCHE_CHECK(!is_empty(), "Function back() is unavailable to use while vector_queue is empty");
+            return m_data[physical_index(m_length - 1)];
+        }
 
         reference_type queue_front() {
-            return this->at(m_queue_cursor);
+            return front();
         }
 
         const_reference_type queue_front() const {
-            return this->at(m_queue_cursor);
+            return front();
         }
 
         value_type queue_pop_front() {
-            return this->at(m_queue_cursor++);
+            return pop_front();
         }
 
         AVALANCHE_NO_DISCARD bool queue_is_empty() const {
-            return m_queue_cursor >= this->size();
+            return is_empty();
         }
 
-        void enqueue(const_reference_type value) {
-            this->push_back(value);
+        bool enqueue(const_reference_type value) {
+            return push_back(value);
         }
 
-    private:
-        size_type m_queue_cursor = 0;
+        /**
+         * @brief Element at `index` counting from the front.
+         */
+        reference_type at(size_type index) {
+            check_index(index);
+            return m_data[physical_index(index)];
+        }
+
+        const_reference_type at(size_type index) const {
+            check_index(index);
+            return m_data[physical_index(index)];
+        }
+
+        reference_type operator[](size_type index) {
+            return at(index);
+        }
+
+        const_reference_type operator[](size_type index) const {
+            return at(index);
+        }
+
+        void clear() {
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (size_type i = 0; i < m_length; ++i) {
+                    m_allocator.destroy(m_data + physical_index(i));
+                }
+            }
+            m_head = 0;
+            m_length = 0;
+        }
+
+        /**
+         * @brief Make room for `count` elements, the capacity is rounded up to a power of two.
+         */
+        void reserve(size_type count) {
+            if (count > m_capacity) {
+                reallocate_storage(round_up_capacity(count));
+            }
+        }
+
+        AVALANCHE_NO_DISCARD size_type size() const AVALANCHE_NOEXCEPT {
+            return m_length;
+        }
+
+        AVALANCHE_NO_DISCARD size_type capacity() const AVALANCHE_NOEXCEPT {
+            return m_capacity;
+        }
+
+        /**
+         * @return Maximum number of elements of a bounded queue, `npos` if it grows
+         */
+        AVALANCHE_NO_DISCARD size_type max_size() const AVALANCHE_NOEXCEPT {
+            return m_max_size;
+        }
+
+        AVALANCHE_NO_DISCARD queue_overflow overflow() const AVALANCHE_NOEXCEPT {
+            return m_overflow;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_empty() const AVALANCHE_NOEXCEPT {
+            return m_length == 0;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_full() const AVALANCHE_NOEXCEPT {
+            return m_length == m_max_size;
+        }
+
+        iterator_type begin() {
+            return { this, 0 };
+        }
+
+        iterator_type end() {
+            return { this, m_length };
+        }
+
+        const_iterator_type begin() const {
+            return { this, 0 };
+        }
+
+        const_iterator_type end() const {
+            return { this, m_length };
+        }
     };
 
+    // Only holds a pointer to its storage
+    template <typename T, typename Allocator>
+    struct is_trivially_relocatable<vector_queue_base<T, Allocator>> : is_trivially_relocatable<Allocator> {};
+
     template <typename T, AllocatorType Allocator = default_allocator<T>>
     using vector_queue = vector_queue_base<T, Allocator>;
 }
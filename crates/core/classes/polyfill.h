@@ -83,3 +83,13 @@
 #   define AVALANCHE_MAYBE_UNUSED [[maybe_unused]]
 #endif
 // === maybe_unused ===
+
+// === no_unique_address ===
+#if !defined(AVALANCHE_NO_UNIQUE_ADDRESS)
+#   if defined(_MSC_VER)
+#       define AVALANCHE_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#   else
+#       define AVALANCHE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#   endif
+#endif
+// === no_unique_address ===
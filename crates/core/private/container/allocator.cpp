@@ -17,3 +17,16 @@ void * avalanche::allocate_memory(const size_t bytes, const void *hint) {
 void avalanche::deallocate_memory(void *pointer, size_t bytes) {
     std::free(pointer);
 }
+
+void *avalanche::reallocate_memory(void *pointer, size_t old_bytes, size_t new_bytes) {
+    if (new_bytes == 0) {
+        deallocate_memory(pointer, old_bytes);
+        return nullptr;
+    }
+
+    if (void* p = std::realloc(pointer, new_bytes))
+        return p;
+
+    raise_exception(bad_alloc());
+    return nullptr; // mute control flow analyser
+}
@@ -1,18 +1,190 @@
 #include "execution/executor.h"
 #include "execution/generator.h"
+#include "execution/work_stealing_deque.h"
+#include "profiler.h"
+#include "logger.h"
 #include "container/vector.hpp"
+#include "container/unique_ptr.hpp"
+#include "container/timing_wheel.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <numeric>
 #include <queue>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 
+#if defined(_WIN32)
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <immintrin.h>
+#endif
+
 
 namespace avalanche::core::execution {
+    namespace {
+        thread_local task_priority t_current_priority = task_priority::normal;
+
+        FORCEINLINE void cpu_relax() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+            _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__arm__))
+            asm volatile("yield");
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        /**
+         * @brief Restrict calling thread to the given CPUs.
+         */
+        void set_current_thread_affinity(const vector<uint32_t>& cpus) {
+#if defined(_WIN32)
+            DWORD_PTR mask = 0;
+            for (const uint32_t cpu : cpus) {
+                if (cpu < sizeof(DWORD_PTR) * 8) {
+                    mask |= DWORD_PTR{1} << cpu;
+                }
+            }
+            if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+                AVALANCHE_LOGGER.warn("Failed to set affinity of worker thread");
+            }
+#elif defined(__linux__)
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for (const uint32_t cpu : cpus) {
+                if (cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &cpu_set);
+                }
+            }
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+                AVALANCHE_LOGGER.warn("Failed to set affinity of worker thread");
+            }
+#else
+            AVALANCHE_MAYBE_UNUSED const auto& unused = cpus;
+            AVALANCHE_LOGGER.warn("Thread affinity isn't supported on this platform");
+#endif
+        }
+    }
+
     struct threaded_coroutine_executor::impl {
-        explicit impl(const size_type num_threads) : m_threads(num_threads) {
-            for (AVALANCHE_MAYBE_UNUSED auto i : range<size_t>(0, num_threads)) {
-                m_threads.emplace_back([this]() {
-                    worker();
+        /**
+         * @brief Handles are detached into raw pointers while queued, the queue owns one reference of each task.
+         */
+        using task_type = promise_state_base*;
+
+        /**
+         * @brief Counters only written by the owning worker, read by anyone taking a snapshot.
+         */
+        struct worker_telemetry {
+            using counter_type = std::atomic<uint64_t>;
+            using histogram_counters = std::array<counter_type, latency_histogram::num_buckets>;
+
+            counter_type num_tasks_run{0};
+            counter_type num_steals{0};
+            counter_type num_wakeups{0};
+            counter_type idle_time{0};
+            counter_type busy_time{0};
+            histogram_counters schedule_latency{};
+            histogram_counters run_duration{};
+
+            static void add(counter_type& counter, const uint64_t value) {
+                // Single writer, a plain load and store is enough
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+
+            static void record(histogram_counters& histogram, const uint64_t value) {
+                add(histogram[latency_histogram::bucket_index_of(value)], 1);
+            }
+
+            static void snapshot(const histogram_counters& histogram, latency_histogram& out) {
+                for (size_t i = 0; i < latency_histogram::num_buckets; ++i) {
+                    if (const uint64_t count = histogram[i].load(std::memory_order_relaxed); count > 0) {
+                        out.record(latency_histogram::bucket_lower_bound(i), count);
+                    }
+                }
+            }
+
+            void reset() {
+                for (counter_type* counter : { &num_tasks_run, &num_steals, &num_wakeups, &idle_time, &busy_time }) {
+                    counter->store(0, std::memory_order_relaxed);
+                }
+                for (histogram_counters* histogram : { &schedule_latency, &run_duration }) {
+                    for (counter_type& counter : *histogram) {
+                        counter.store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+
+        static uint64_t now_in_nanoseconds() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        // Bounds of the spin before parking, in iterations of `cpu_relax()`
+        static constexpr size_type min_spin_count = 64;
+        static constexpr size_type max_spin_count = 4096;
+
+        struct worker_context {
+            explicit worker_context(impl* owner, const size_type index)
+                : owner(owner)
+                , index(index)
+                , random_state(static_cast<uint32_t>(index) * 0x9E3779B9u + 1u)
+            {}
+
+            impl* owner;
+            size_type index;
+            uint32_t random_state;
+            // Grows when spinning found work, shrinks when the worker had to park anyway
+            size_type spin_count = min_spin_count * 4;
+            vector<uint32_t> cpus{};
+            std::array<work_stealing_deque<task_type>, num_task_priorities> local_queues;
+            vector<task_type> expired_timers{};
+            worker_telemetry telemetry{};
+        };
+
+        static thread_local worker_context* current_worker;
+
+        static size_type lane_of(const task_type task) {
+            return static_cast<size_type>(task->get_priority());
+        }
+
+        impl(const size_type num_threads, const worker_affinity& affinity)
+            : m_max_background_workers(std::max<size_type>(num_threads, 2) - 1)
+            , m_workers(num_threads)
+            , m_threads(num_threads)
+        {
+            AVALANCHE_CHECK(num_threads > 0, "threaded_coroutine_executor requires at least one worker");
+            for (const auto i : range<size_t>(0, num_threads)) {
+                auto context = make_unique<worker_context>(this, i);
+                if (!affinity.cpu_set.is_empty()) {
+                    if (affinity.pin_each_worker) {
+                        context->cpus.push_back(affinity.cpu_set[i % affinity.cpu_set.size()]);
+                    } else {
+                        context->cpus = affinity.cpu_set;
+                    }
+                }
+                m_workers.emplace_back(std::move(context));
+            }
+            for (const auto i : range<size_t>(0, num_threads)) {
+                worker_context* context = m_workers[i].get();
+                m_threads.emplace_back([this, context]() {
+                    worker(*context);
                 });
             }
         }
@@ -21,69 +193,385 @@ namespace avalanche::core::execution {
             terminate();
         }
 
-        AVALANCHE_NO_DISCARD bool is_empty() {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            return m_threads.is_empty();
+        AVALANCHE_NO_DISCARD bool is_empty() const {
+            return m_num_in_flight.load(std::memory_order_acquire) == 0;
         }
 
         void terminate() {
-            m_is_running = false;
+            if (!m_is_running.exchange(false, std::memory_order_acq_rel)) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                m_cv.notify_all();
+            }
             m_threads.clear();
+
+            // Release handles never got the chance to run
+            for (const auto& context : m_workers) {
+                for (auto& local_queue : context->local_queues) {
+                    task_type task = nullptr;
+                    while (local_queue.pop(task)) {
+                        coroutine_handle::adopt(task).reset();
+                        m_num_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_timer_mutex);
+                m_timing_wheel.advance(timer_wheel_type::no_deadline, [](const task_type task) {
+                    coroutine_handle::adopt(task).reset();
+                });
+                m_next_timer_deadline.store(timer_wheel_type::no_deadline, std::memory_order_relaxed);
+            }
+            std::lock_guard<std::mutex> lock(m_injection_mutex);
+            for (auto& injection_queue : m_injection_queues) {
+                for (; !injection_queue.empty(); injection_queue.pop()) {
+                    coroutine_handle::adopt(injection_queue.front()).reset();
+                    m_num_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+                }
+            }
         }
 
         void push(coroutine_handle handle) {
+            handle->set_enqueue_timestamp(now_in_nanoseconds());
+            task_type task = handle.detach();
+            const size_type lane = lane_of(task);
+            m_num_in_flight.fetch_add(1, std::memory_order_acq_rel);
+            // Counted before the task is visible, otherwise a thief could run it and decrement first, wrapping the
+            // counters around. The total goes first and is decremented last, so it never reads below a lane's count
+            m_num_queued.fetch_add(1, std::memory_order_seq_cst);
+            m_num_queued_of_lane[lane].fetch_add(1, std::memory_order_seq_cst);
+
+            if (worker_context* context = current_worker; context != nullptr && context->owner == this) {
+                // Spawned from one of our workers, keep it hot in the local deque
+                context->local_queues[lane].push(task);
+            } else {
+                std::lock_guard<std::mutex> lock(m_injection_mutex);
+                m_injection_queues[lane].push(task);
+            }
+
+            // A spinning worker is about to pick it up, no need to pay for a wakeup
+            if (m_num_spinning.load(std::memory_order_seq_cst) == 0) {
+                wake_one();
+            }
+        }
+
+        AVALANCHE_NO_DISCARD uint64_t current_timer_tick() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - m_timer_epoch).count());
+        }
+
+        void push_at(coroutine_handle handle, const clock_type::time_point deadline) {
+            // Round up, a timer never expires early
+            const auto delay = std::chrono::ceil<std::chrono::milliseconds>(deadline - m_timer_epoch).count();
+            uint64_t tick = delay > 0 ? static_cast<uint64_t>(delay) : 0;
+            bool is_earliest = false;
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                m_queue.push(std::move(handle));
+                std::lock_guard<std::mutex> lock(m_timer_mutex);
+                tick = std::max(tick, m_timing_wheel.current_tick() + 1);
+                m_timing_wheel.schedule(handle.detach(), tick);
+                if (tick < m_next_timer_deadline.load(std::memory_order_relaxed)) {
+                    m_next_timer_deadline.store(tick, std::memory_order_seq_cst);
+                    is_earliest = true;
+                }
+            }
+            // Parked workers are waiting for a later deadline
+            if (is_earliest) {
+                wake_one();
             }
-            m_cv.notify_one();
         }
 
-        AVALANCHE_NO_DISCARD coroutine_handle pop() {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            m_cv.wait(lock, [this] {
-                return !m_queue.empty();
-            });
-            const coroutine_handle top = m_queue.front();
-            m_queue.pop();
-            return top;
+        /**
+         * @brief Push the coroutines of expired timers to their executors, by whichever worker gets there first.
+         */
+        void poll_timers(worker_context& context) {
+            const uint64_t next_deadline = m_next_timer_deadline.load(std::memory_order_acquire);
+            if (next_deadline == timer_wheel_type::no_deadline || current_timer_tick() < next_deadline) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_timer_mutex, std::try_to_lock);
+                if (!lock.owns_lock()) {
+                    return;
+                }
+                m_timing_wheel.advance(current_timer_tick(), [&context](const task_type task) {
+                    context.expired_timers.push_back(task);
+                });
+                m_next_timer_deadline.store(m_timing_wheel.earliest_deadline(), std::memory_order_release);
+            }
+            for (const task_type task : context.expired_timers) {
+                coroutine_handle handle = coroutine_handle::adopt(task);
+                coroutine_executor_base* executor = handle->get_executor();
+                executor->push_coroutine(std::move(handle));
+            }
+            context.expired_timers.clear();
+        }
+
+        void wake_one() {
+            if (m_num_sleeping.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                m_cv.notify_one();
+            }
+        }
+
+        /**
+         * @brief Whether a worker has something to pick, background tasks don't count while they are at their limit.
+         */
+        AVALANCHE_NO_DISCARD bool has_runnable_task() const {
+            const size_type num_background = m_num_queued_of_lane[static_cast<size_type>(task_priority::background)].load(std::memory_order_seq_cst);
+            const size_type num_queued = m_num_queued.load(std::memory_order_seq_cst);
+            return num_queued > num_background
+                || (num_background > 0 && m_num_running_background.load(std::memory_order_seq_cst) < m_max_background_workers);
+        }
+
+        /**
+         * @brief Busy wait for a task shortly before parking, which is much cheaper than a wakeup for short gaps.
+         */
+        AVALANCHE_NO_DISCARD task_type spin_for_task(worker_context& context) {
+            m_num_spinning.fetch_add(1, std::memory_order_seq_cst);
+            task_type task = nullptr;
+            for (size_type i = 0; i < context.spin_count && m_is_running.load(std::memory_order_relaxed); ++i) {
+                if (has_runnable_task() && (task = find_task(context)) != nullptr) {
+                    break;
+                }
+                cpu_relax();
+            }
+            const bool is_last_spinning = m_num_spinning.fetch_sub(1, std::memory_order_seq_cst) == 1;
+
+            if (task != nullptr) {
+                context.spin_count = std::min(context.spin_count * 2, max_spin_count);
+                // Pushes skipped the wakeup while we were spinning, pass the duty on if there is more to do
+                if (is_last_spinning && has_runnable_task()) {
+                    wake_one();
+                }
+                return task;
+            }
+            context.spin_count = std::max(context.spin_count / 2, min_spin_count);
+            // Pairs with the check of spinning workers in push()
+            return has_runnable_task() ? find_task(context) : nullptr;
         }
 
         void wait_for_all_jobs(size_type how_long_to_wait_ms) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            AVALANCHE_CHECK(current_worker == nullptr || current_worker->owner != this, "wait_for_all_jobs() called from a worker, which never finishes its own task");
+            std::unique_lock<std::mutex> lock(m_empty_mutex);
+            m_num_empty_waiters.fetch_add(1, std::memory_order_seq_cst);
+            const auto predicate = [this] {
+                return is_empty();
+            };
             if (how_long_to_wait_ms > 0) {
                 const auto timeout = std::chrono::milliseconds(how_long_to_wait_ms);
-                m_cv_empty_check.wait_for(lock, timeout, [this] {
-                    return m_queue.empty();
-                });
+                m_cv_empty_check.wait_for(lock, timeout, predicate);
             } else {
-                m_cv_empty_check.wait(lock, [this] {
-                    return m_queue.empty();
-                });
+                m_cv_empty_check.wait(lock, predicate);
             }
+            m_num_empty_waiters.fetch_sub(1, std::memory_order_relaxed);
         }
 
-        void worker() {
-            while (m_is_running) {
-                if (coroutine_handle handle = pop(); handle) {
-                    if (!handle->done()) {
-                        handle->resume();
-                    }
-                    if (m_queue.empty()) {
-                        m_cv_empty_check.notify_all();
-                    }
+        AVALANCHE_NO_DISCARD task_type pop_injected(const size_type lane) {
+            std::lock_guard<std::mutex> lock(m_injection_mutex);
+            auto& injection_queue = m_injection_queues[lane];
+            if (injection_queue.empty()) {
+                return nullptr;
+            }
+            task_type task = injection_queue.front();
+            injection_queue.pop();
+            return task;
+        }
+
+        AVALANCHE_NO_DISCARD task_type steal_from_others(worker_context& context, const size_type lane) {
+            const size_type num_workers = m_workers.size();
+            if (num_workers <= 1) {
+                return nullptr;
+            }
+
+            // xorshift32, choosing a random victim to begin with
+            uint32_t x = context.random_state;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            context.random_state = x;
+
+            const size_type start = x % num_workers;
+            for (size_type i = 0; i < num_workers; ++i) {
+                const size_type victim = (start + i) % num_workers;
+                if (victim == context.index) {
+                    continue;
+                }
+                task_type task = nullptr;
+                if (m_workers[victim]->local_queues[lane].steal(task)) {
+                    worker_telemetry::add(context.telemetry.num_steals, 1);
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+
+        AVALANCHE_NO_DISCARD task_type find_task_in_lane(worker_context& context, const size_type lane) {
+            task_type task = nullptr;
+            if (context.local_queues[lane].pop(task)) {
+                return task;
+            }
+            if (m_num_queued_of_lane[lane].load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+            if ((task = pop_injected(lane))) {
+                return task;
+            }
+            return steal_from_others(context, lane);
+        }
+
+        /**
+         * @brief Reserve one of the workers allowed to run background tasks.
+         */
+        AVALANCHE_NO_DISCARD bool try_acquire_background_slot() {
+            size_type num_running = m_num_running_background.load(std::memory_order_relaxed);
+            while (num_running < m_max_background_workers) {
+                if (m_num_running_background.compare_exchange_weak(num_running, num_running + 1, std::memory_order_seq_cst)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void release_background_slot() {
+            m_num_running_background.fetch_sub(1, std::memory_order_seq_cst);
+            // Others might have parked with background tasks left, since they were at their limit
+            if (m_num_queued_of_lane[static_cast<size_type>(task_priority::background)].load(std::memory_order_seq_cst) > 0) {
+                wake_one();
+            }
+        }
+
+        /**
+         * @brief Highest priority first, a background task is returned with a background slot acquired.
+         */
+        AVALANCHE_NO_DISCARD task_type find_task(worker_context& context) {
+            constexpr auto background_lane = static_cast<size_type>(task_priority::background);
+            for (size_type lane = 0; lane < background_lane; ++lane) {
+                if (task_type task = find_task_in_lane(context, lane)) {
+                    return task;
                 }
             }
+            if (m_num_queued_of_lane[background_lane].load(std::memory_order_acquire) == 0 || !try_acquire_background_slot()) {
+                return nullptr;
+            }
+            if (task_type task = find_task_in_lane(context, background_lane)) {
+                return task;
+            }
+            m_num_running_background.fetch_sub(1, std::memory_order_seq_cst);
+            return nullptr;
+        }
+
+        void park(worker_context& context) {
+            AVALANCHE_PROFILE_SCOPE("Executor::park");
+            const uint64_t park_time = now_in_nanoseconds();
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_num_sleeping.fetch_add(1, std::memory_order_seq_cst);
+            // Re-check after announcing ourselves as sleeping, pairs with the check in push()
+            if (m_is_running.load(std::memory_order_acquire) && !has_runnable_task()) {
+                // Pairs with the wakeup in push_at() when there is an earlier timer
+                if (const uint64_t next_deadline = m_next_timer_deadline.load(std::memory_order_seq_cst); next_deadline == timer_wheel_type::no_deadline) {
+                    m_cv.wait(lock);
+                } else if (next_deadline > current_timer_tick()) {
+                    m_cv.wait_until(lock, m_timer_epoch + std::chrono::milliseconds(next_deadline));
+                }
+                worker_telemetry::add(context.telemetry.num_wakeups, 1);
+            }
+            m_num_sleeping.fetch_sub(1, std::memory_order_relaxed);
+            worker_telemetry::add(context.telemetry.idle_time, now_in_nanoseconds() - park_time);
+        }
+
+        void run_task(worker_context& context, task_type task) {
+            const size_type lane = lane_of(task);
+            m_num_queued_of_lane[lane].fetch_sub(1, std::memory_order_acq_rel);
+            m_num_queued.fetch_sub(1, std::memory_order_acq_rel);
+
+            coroutine_handle handle = coroutine_handle::adopt(task);
+            if (handle && !handle->done()) {
+                worker_telemetry& telemetry = context.telemetry;
+                const uint64_t start_time = now_in_nanoseconds();
+                const uint64_t enqueue_time = handle->get_enqueue_timestamp();
+                worker_telemetry::record(telemetry.schedule_latency, start_time > enqueue_time ? start_time - enqueue_time : 0);
+                {
+                    AVALANCHE_PROFILE_SCOPE("Executor::run_task");
+                    t_current_priority = handle->get_priority();
+                    handle->resume();
+                    t_current_priority = task_priority::normal;
+                }
+                const uint64_t duration = now_in_nanoseconds() - start_time;
+                worker_telemetry::record(telemetry.run_duration, duration);
+                worker_telemetry::add(telemetry.busy_time, duration);
+                worker_telemetry::add(telemetry.num_tasks_run, 1);
+            }
+            // Drop our reference first, the frame might be destroyed with it
+            handle.reset();
+            if (lane == static_cast<size_type>(task_priority::background)) {
+                release_background_slot();
+            }
+
+            // Tasks it pushed are counted before, so this doesn't reach zero while more work is coming
+            if (m_num_in_flight.fetch_sub(1, std::memory_order_seq_cst) == 1 && m_num_empty_waiters.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(m_empty_mutex);
+                m_cv_empty_check.notify_all();
+            }
+        }
+
+        void worker(worker_context& context) {
+            current_worker = &context;
+            AVALANCHE_PROFILE_THREAD_NAME(std::format("Worker {}", context.index));
+            if (!context.cpus.is_empty()) {
+                set_current_thread_affinity(context.cpus);
+            }
+            while (m_is_running.load(std::memory_order_acquire)) {
+                poll_timers(context);
+                task_type task = find_task(context);
+                if (task == nullptr && m_should_spin) {
+                    task = spin_for_task(context);
+                }
+                if (task != nullptr) {
+                    run_task(context, task);
+                } else {
+                    park(context);
+                }
+            }
+            current_worker = nullptr;
         }
 
         std::atomic<bool> m_is_running{true};
-        std::queue<coroutine_handle> m_queue{};
-        std::mutex m_mutex{};
+        // Queued or running, a coroutine suspended on something else than the executor isn't counted
+        std::atomic<size_type> m_num_in_flight{0};
+        std::atomic<size_type> m_num_queued{0};
+        std::array<std::atomic<size_type>, num_task_priorities> m_num_queued_of_lane{};
+        std::atomic<size_type> m_num_running_background{0};
+        const size_type m_max_background_workers;
+        std::atomic<size_type> m_num_sleeping{0};
+        std::atomic<size_type> m_num_spinning{0};
+        // Spinning only steals the core from the thread which would push the work on a single core machine
+        const bool m_should_spin = std::thread::hardware_concurrency() > 1;
+        std::atomic<size_type> m_num_empty_waiters{0};
+
+        using timer_wheel_type = timing_wheel<task_type>;
+
+        // Timer ticks are milliseconds since then
+        const clock_type::time_point m_timer_epoch = clock_type::now();
+        std::mutex m_timer_mutex{};
+        timer_wheel_type m_timing_wheel{};
+        std::atomic<uint64_t> m_next_timer_deadline{timer_wheel_type::no_deadline};
+
+        // Coroutines pushed from non-worker threads
+        std::array<std::queue<task_type>, num_task_priorities> m_injection_queues{};
+        std::mutex m_injection_mutex{};
+
+        std::mutex m_sleep_mutex{};
         std::condition_variable m_cv{};
+        std::mutex m_empty_mutex{};
         std::condition_variable m_cv_empty_check{};
+
+        vector<unique_ptr<worker_context>> m_workers;
         vector<std::jthread> m_threads;
     };
 
+    thread_local threaded_coroutine_executor::impl::worker_context* threaded_coroutine_executor::impl::current_worker = nullptr;
+
     coroutine_executor_base::~coroutine_executor_base() = default;
 
     void coroutine_executor_base::wait_for_all_jobs(size_type how_long_to_wait_ms) {}
@@ -101,8 +589,51 @@ namespace avalanche::core::execution {
         return executor;
     }
 
-    threaded_coroutine_executor::threaded_coroutine_executor(const size_type num_threads)
-        : m_impl_(new impl(num_threads)){}
+    struct main_thread_executor::impl {
+        mutable std::mutex mutex{};
+        std::queue<coroutine_handle> queue{};
+    };
+
+    main_thread_executor::main_thread_executor() : m_impl_(new impl) {}
+
+    main_thread_executor::~main_thread_executor() {
+        delete m_impl_;
+    }
+
+    void main_thread_executor::push_coroutine(coroutine_handle handle) {
+        std::lock_guard<std::mutex> lock(m_impl_->mutex);
+        m_impl_->queue.push(std::move(handle));
+    }
+
+    main_thread_executor::size_type main_thread_executor::drain() {
+        AVALANCHE_PROFILE_SCOPE("main_thread_executor::drain");
+        std::queue<coroutine_handle> pending{};
+        {
+            std::lock_guard<std::mutex> lock(m_impl_->mutex);
+            pending.swap(m_impl_->queue);
+        }
+        size_type num_resumed = 0;
+        for (; !pending.empty(); pending.pop()) {
+            if (const coroutine_handle& handle = pending.front(); handle && !handle->done()) {
+                handle->resume();
+                ++num_resumed;
+            }
+        }
+        return num_resumed;
+    }
+
+    bool main_thread_executor::is_empty() const {
+        std::lock_guard<std::mutex> lock(m_impl_->mutex);
+        return m_impl_->queue.empty();
+    }
+
+    main_thread_executor& main_thread_executor::get_global_executor() {
+        static main_thread_executor executor{};
+        return executor;
+    }
+
+    threaded_coroutine_executor::threaded_coroutine_executor(const size_type num_threads, const worker_affinity& affinity)
+        : m_impl_(new impl(num_threads, affinity)){}
 
     threaded_coroutine_executor::~threaded_coroutine_executor() {
         delete m_impl_;
@@ -120,12 +651,89 @@ namespace avalanche::core::execution {
         m_impl_->push(std::move(handle));
     }
 
+    void threaded_coroutine_executor::push_coroutine_at(coroutine_handle handle, const clock_type::time_point deadline) {
+        m_impl_->push_at(std::move(handle), deadline);
+    }
+
     void threaded_coroutine_executor::wait_for_all_jobs(size_type how_long_to_wait_ms) {
         m_impl_->wait_for_all_jobs(how_long_to_wait_ms);
     }
 
+    threaded_coroutine_executor::size_type threaded_coroutine_executor::get_num_workers() const {
+        return m_impl_->m_workers.size();
+    }
+
+    executor_stats threaded_coroutine_executor::get_stats() const {
+        executor_stats stats{};
+        stats.workers.ensure_capacity(m_impl_->m_workers.size());
+        for (const auto& context : m_impl_->m_workers) {
+            const impl::worker_telemetry& telemetry = context->telemetry;
+            stats.workers.push_back({
+                .num_tasks_run = telemetry.num_tasks_run.load(std::memory_order_relaxed),
+                .num_steals = telemetry.num_steals.load(std::memory_order_relaxed),
+                .num_wakeups = telemetry.num_wakeups.load(std::memory_order_relaxed),
+                .idle_time = telemetry.idle_time.load(std::memory_order_relaxed),
+                .busy_time = telemetry.busy_time.load(std::memory_order_relaxed),
+                .queue_depth = std::accumulate(context->local_queues.begin(), context->local_queues.end(), size_t{0}, [](const size_t sum, const auto& local_queue) {
+                    return sum + local_queue.size_approx();
+                }),
+            });
+            impl::worker_telemetry::snapshot(telemetry.schedule_latency, stats.schedule_latency);
+            impl::worker_telemetry::snapshot(telemetry.run_duration, stats.run_duration);
+        }
+        stats.num_queued = m_impl_->m_num_queued.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_impl_->m_injection_mutex);
+            for (const auto& injection_queue : m_impl_->m_injection_queues) {
+                stats.injection_queue_depth += injection_queue.size();
+            }
+        }
+        return stats;
+    }
+
+    void threaded_coroutine_executor::reset_stats() {
+        for (const auto& context : m_impl_->m_workers) {
+            context->telemetry.reset();
+        }
+    }
+
+    void threaded_coroutine_executor::log_stats() const {
+        const executor_stats stats = get_stats();
+        constexpr double nanoseconds_per_millisecond = 1e6;
+        constexpr double nanoseconds_per_microsecond = 1e3;
+        AVALANCHE_LOGGER.info("Executor: {} workers, {} queued, {} in injection queue", stats.workers.size(), stats.num_queued, stats.injection_queue_depth);
+        for (size_type i = 0; i < stats.workers.size(); ++i) {
+            const executor_worker_stats& worker = stats.workers[i];
+            AVALANCHE_LOGGER.info("  Worker {}: {} tasks, {} steals, {} wakeups, busy {:.3f} ms, idle {:.3f} ms, {} in local queue",
+                i, worker.num_tasks_run, worker.num_steals, worker.num_wakeups,
+                static_cast<double>(worker.busy_time) / nanoseconds_per_millisecond,
+                static_cast<double>(worker.idle_time) / nanoseconds_per_millisecond,
+                worker.queue_depth);
+        }
+        for (const auto& [name, histogram] : { std::pair{ "Schedule latency", &stats.schedule_latency }, std::pair{ "Run duration", &stats.run_duration } }) {
+            AVALANCHE_LOGGER.info("  {} (us): p50 {:.3f}, p90 {:.3f}, p99 {:.3f}, max {:.3f} over {} samples", name,
+                static_cast<double>(histogram->value_at_percentile(50.0)) / nanoseconds_per_microsecond,
+                static_cast<double>(histogram->value_at_percentile(90.0)) / nanoseconds_per_microsecond,
+                static_cast<double>(histogram->value_at_percentile(99.0)) / nanoseconds_per_microsecond,
+                static_cast<double>(histogram->max_value()) / nanoseconds_per_microsecond,
+                histogram->total_count());
+        }
+    }
+
+    threaded_coroutine_executor::size_type threaded_coroutine_executor::get_current_worker_index() {
+        if (const impl::worker_context* context = impl::current_worker) {
+            return context->index;
+        }
+        return invalid_worker_index;
+    }
+
+    task_priority threaded_coroutine_executor::get_current_priority() {
+        return t_current_priority;
+    }
+
     threaded_coroutine_executor& threaded_coroutine_executor::get_global_executor() {
-        static threaded_coroutine_executor executor{};
+        // Leave one core for the thread driving the frame
+        static threaded_coroutine_executor executor{ std::max<size_type>(std::thread::hardware_concurrency(), default_thread_group_size + 1) - 1 };
         return executor;
     }
 }
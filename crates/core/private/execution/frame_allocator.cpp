@@ -0,0 +1,319 @@
+#include "execution/frame_allocator.h"
+#include "container/allocator.hpp"
+#include "logger.h"
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <utility>
+
+
+namespace avalanche::core::execution {
+
+    namespace {
+        using size_type = frame_allocator::size_type;
+
+        /**
+         * @brief Prefix of every block, remembers where the block came from.
+         */
+        struct alignas(std::max_align_t) block_header {
+            coroutine_arena* arena;
+        };
+
+        struct free_node {
+            free_node* next;
+        };
+
+        constexpr size_type header_size = sizeof(block_header);
+        constexpr size_type num_size_classes = std::bit_width(frame_allocator::max_block_size / frame_allocator::min_block_size);
+        // Number of blocks moving between thread cache and global depot at once
+        constexpr size_type batch_size = 32;
+        constexpr size_type max_cached_blocks_per_class = batch_size * 2;
+        constexpr size_type max_depot_blocks_per_class = batch_size * 64;
+
+        constexpr size_type size_class_of(const size_type block_bytes) {
+            if (block_bytes <= frame_allocator::min_block_size) {
+                return 0;
+            }
+            return std::bit_width((block_bytes - 1) / frame_allocator::min_block_size);
+        }
+
+        constexpr size_type block_size_of_class(const size_type size_class) {
+            return frame_allocator::min_block_size << size_class;
+        }
+
+        static_assert(size_class_of(frame_allocator::max_block_size) == num_size_classes - 1);
+        static_assert(block_size_of_class(size_class_of(65)) == 128);
+
+        struct global_counters {
+            std::atomic<uint64_t> pooled_allocations{0};
+            std::atomic<uint64_t> arena_allocations{0};
+            std::atomic<uint64_t> system_allocations{0};
+            std::atomic<uint64_t> system_deallocations{0};
+            std::atomic<uint64_t> deallocations{0};
+        };
+
+        global_counters& get_global_counters() {
+            static global_counters* counters = new global_counters();
+            return *counters;
+        }
+
+        /**
+         * @brief Free blocks shared by all threads, only touched once per batch.
+         */
+        class depot {
+        public:
+            static depot& get() {
+                // Intentionally leaked, worker threads might flush their caches during static destruction
+                static depot* instance = new depot();
+                return *instance;
+            }
+
+            /**
+             * @return false if depot is full and caller should release blocks to system
+             */
+            bool put(const size_type size_class, free_node* head, free_node* tail, const size_type count) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_counts[size_class] + count > max_depot_blocks_per_class) {
+                    return false;
+                }
+                tail->next = m_heads[size_class];
+                m_heads[size_class] = head;
+                m_counts[size_class] += count;
+                return true;
+            }
+
+            size_type take(const size_type size_class, free_node*& out_head) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                size_type count = 0;
+                free_node* head = m_heads[size_class];
+                free_node* tail = nullptr;
+                for (free_node* node = head; node != nullptr && count < batch_size; node = node->next) {
+                    tail = node;
+                    ++count;
+                }
+                if (tail != nullptr) {
+                    m_heads[size_class] = tail->next;
+                    tail->next = nullptr;
+                }
+                m_counts[size_class] -= count;
+                out_head = head;
+                return count;
+            }
+
+        private:
+            std::mutex m_mutex{};
+            free_node* m_heads[num_size_classes]{};
+            size_type m_counts[num_size_classes]{};
+        };
+
+        void* system_allocate(const size_type size_class) {
+            get_global_counters().system_allocations.fetch_add(1, std::memory_order_relaxed);
+            return allocate_memory(block_size_of_class(size_class));
+        }
+
+        void system_deallocate(void* block, const size_type size_class) {
+            get_global_counters().system_deallocations.fetch_add(1, std::memory_order_relaxed);
+            deallocate_memory(block, block_size_of_class(size_class));
+        }
+
+        thread_local bool t_cache_destroyed = false;
+        thread_local coroutine_arena* t_bound_arena = nullptr;
+
+        struct thread_cache {
+            free_node* heads[num_size_classes]{};
+            size_type counts[num_size_classes]{};
+            frame_allocator_stats stats{};
+
+            ~thread_cache() {
+                for (size_type size_class = 0; size_class < num_size_classes; ++size_class) {
+                    while (counts[size_class] > 0) {
+                        flush_batch(size_class);
+                    }
+                }
+                global_counters& counters = get_global_counters();
+                counters.pooled_allocations.fetch_add(stats.pooled_allocations, std::memory_order_relaxed);
+                counters.arena_allocations.fetch_add(stats.arena_allocations, std::memory_order_relaxed);
+                counters.deallocations.fetch_add(stats.deallocations, std::memory_order_relaxed);
+                t_cache_destroyed = true;
+            }
+
+            void* pop(const size_type size_class) {
+                if (heads[size_class] == nullptr) AVALANCHE_UNLIKELY_BRANCH {
+                    free_node* head = nullptr;
+                    counts[size_class] = depot::get().take(size_class, head);
+                    heads[size_class] = head;
+                    if (head == nullptr) {
+                        return system_allocate(size_class);
+                    }
+                }
+                free_node* node = heads[size_class];
+                heads[size_class] = node->next;
+                --counts[size_class];
+                ++stats.pooled_allocations;
+                return node;
+            }
+
+            void push(const size_type size_class, void* block) {
+                if (counts[size_class] >= max_cached_blocks_per_class) AVALANCHE_UNLIKELY_BRANCH {
+                    flush_batch(size_class);
+                }
+                auto* node = static_cast<free_node*>(block);
+                node->next = heads[size_class];
+                heads[size_class] = node;
+                ++counts[size_class];
+            }
+
+            void flush_batch(const size_type size_class) {
+                free_node* head = heads[size_class];
+                free_node* tail = head;
+                size_type count = 1;
+                while (count < batch_size && tail->next != nullptr) {
+                    tail = tail->next;
+                    ++count;
+                }
+                heads[size_class] = tail->next;
+                counts[size_class] -= count;
+
+                if (!depot::get().put(size_class, head, tail, count)) {
+                    tail->next = nullptr;
+                    for (free_node* node = head; node != nullptr;) {
+                        free_node* next = node->next;
+                        system_deallocate(node, size_class);
+                        node = next;
+                    }
+                }
+            }
+        };
+
+        thread_cache& get_thread_cache() {
+            thread_local thread_cache cache{};
+            return cache;
+        }
+    }
+
+    void* frame_allocator::allocate(const size_type bytes) {
+        const size_type block_bytes = bytes + header_size;
+
+        void* block = nullptr;
+        coroutine_arena* arena = t_bound_arena;
+        if (arena != nullptr) {
+            block = arena->try_allocate(block_bytes);
+            if (block == nullptr) {
+                arena = nullptr;
+            } else if (!t_cache_destroyed) {
+                ++get_thread_cache().stats.arena_allocations;
+            }
+        }
+
+        if (block == nullptr) {
+            if (block_bytes > max_block_size) AVALANCHE_UNLIKELY_BRANCH {
+                get_global_counters().system_allocations.fetch_add(1, std::memory_order_relaxed);
+                block = allocate_memory(block_bytes);
+            } else if (t_cache_destroyed) AVALANCHE_UNLIKELY_BRANCH {
+                block = system_allocate(size_class_of(block_bytes));
+            } else {
+                block = get_thread_cache().pop(size_class_of(block_bytes));
+            }
+        }
+
+        auto* header = static_cast<block_header*>(block);
+        header->arena = arena;
+        return static_cast<std::byte*>(block) + header_size;
+    }
+
+    void frame_allocator::deallocate(void* pointer, const size_type bytes) AVALANCHE_NOEXCEPT {
+        if (pointer == nullptr) {
+            return;
+        }
+
+        const size_type block_bytes = bytes + header_size;
+        void* block = static_cast<std::byte*>(pointer) - header_size;
+        const auto* header = static_cast<block_header*>(block);
+
+        if (!t_cache_destroyed) {
+            ++get_thread_cache().stats.deallocations;
+        } else {
+            get_global_counters().deallocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (coroutine_arena* arena = header->arena; arena != nullptr) {
+            arena->release();
+        } else if (block_bytes > max_block_size) AVALANCHE_UNLIKELY_BRANCH {
+            get_global_counters().system_deallocations.fetch_add(1, std::memory_order_relaxed);
+            deallocate_memory(block, block_bytes);
+        } else if (t_cache_destroyed) AVALANCHE_UNLIKELY_BRANCH {
+            system_deallocate(block, size_class_of(block_bytes));
+        } else {
+            get_thread_cache().push(size_class_of(block_bytes), block);
+        }
+    }
+
+    frame_allocator_stats frame_allocator::get_thread_stats() {
+        if (t_cache_destroyed) {
+            return {};
+        }
+        return get_thread_cache().stats;
+    }
+
+    frame_allocator_stats frame_allocator::get_global_stats() {
+        const global_counters& counters = get_global_counters();
+        return frame_allocator_stats {
+            .pooled_allocations = counters.pooled_allocations.load(std::memory_order_relaxed),
+            .arena_allocations = counters.arena_allocations.load(std::memory_order_relaxed),
+            .system_allocations = counters.system_allocations.load(std::memory_order_relaxed),
+            .system_deallocations = counters.system_deallocations.load(std::memory_order_relaxed),
+            .deallocations = counters.deallocations.load(std::memory_order_relaxed),
+        };
+    }
+
+    coroutine_arena::coroutine_arena(const size_type capacity_in_bytes)
+        : m_memory(static_cast<std::byte*>(allocate_memory(capacity_in_bytes)))
+        , m_capacity(capacity_in_bytes)
+    {}
+
+    coroutine_arena::~coroutine_arena() {
+        AVALANCHE_CHECK(m_live_allocations.load(std::memory_order_acquire) == 0, "coroutine_arena destroyed while frames still alive");
+        deallocate_memory(m_memory, m_capacity);
+    }
+
+    void coroutine_arena::reset() {
+        AVALANCHE_CHECK(m_live_allocations.load(std::memory_order_acquire) == 0, "coroutine_arena reset while frames still alive");
+        m_offset.store(0, std::memory_order_release);
+    }
+
+    coroutine_arena::size_type coroutine_arena::capacity() const {
+        return m_capacity;
+    }
+
+    coroutine_arena::size_type coroutine_arena::used_bytes() const {
+        return std::min(m_offset.load(std::memory_order_acquire), m_capacity);
+    }
+
+    coroutine_arena::size_type coroutine_arena::live_allocations() const {
+        return m_live_allocations.load(std::memory_order_acquire);
+    }
+
+    void* coroutine_arena::try_allocate(size_type bytes) {
+        constexpr size_type alignment = alignof(std::max_align_t);
+        bytes = (bytes + alignment - 1) & ~(alignment - 1);
+        const size_type offset = m_offset.fetch_add(bytes, std::memory_order_relaxed);
+        if (offset + bytes > m_capacity) {
+            return nullptr;
+        }
+        m_live_allocations.fetch_add(1, std::memory_order_relaxed);
+        return m_memory + offset;
+    }
+
+    void coroutine_arena::release() {
+        m_live_allocations.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    scoped_coroutine_arena::scoped_coroutine_arena(coroutine_arena& arena)
+        : m_previous(std::exchange(t_bound_arena, &arena))
+    {}
+
+    scoped_coroutine_arena::~scoped_coroutine_arena() {
+        t_bound_arena = m_previous;
+    }
+
+}
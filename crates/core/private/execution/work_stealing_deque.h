@@ -0,0 +1,172 @@
+#pragma once
+
+#include "polyfill.h"
+#include "container/vector.hpp"
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace avalanche::core::execution {
+
+    /**
+     * @brief Chase-Lev work stealing deque.
+     *
+     * Only the owner thread is allowed to call `push()` and `pop()`, which work on the bottom end.
+     * Any other thread can `steal()` from the top end.
+     *
+     * Implementation follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al. 2013).
+     *
+     * @tparam T Must be trivially copyable, thieves might read a slot which is being overwritten by owner.
+     */
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    class work_stealing_deque {
+    public:
+        using value_type = T;
+        using index_type = int64_t;
+        using size_type = size_t;
+
+        static constexpr size_type default_capacity = 256;
+
+        explicit work_stealing_deque(size_type capacity = default_capacity)
+            : m_buffer(new ring(capacity))
+        {
+            AVALANCHE_CHECK(capacity > 0 && (capacity & (capacity - 1)) == 0, "work_stealing_deque: capacity must be power of two");
+        }
+
+        ~work_stealing_deque() {
+            delete m_buffer.load(std::memory_order_relaxed);
+            for (ring* retired : m_retired_buffers) {
+                delete retired;
+            }
+        }
+
+        work_stealing_deque(const work_stealing_deque&) = delete;
+        work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+        /**
+         * @brief Owner only. Push an item to the bottom.
+         */
+        void push(value_type item) {
+            const index_type bottom = m_bottom.load(std::memory_order_relaxed);
+            const index_type top = m_top.load(std::memory_order_acquire);
+            ring* buffer = m_buffer.load(std::memory_order_relaxed);
+
+            if (bottom - top > static_cast<index_type>(buffer->capacity()) - 1) AVALANCHE_UNLIKELY_BRANCH {
+                buffer = grow(buffer, bottom, top);
+            }
+
+            buffer->store(bottom, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Owner only. Pop an item from the bottom.
+         * @return false if deque is empty or the last item was stolen
+         */
+        bool pop(value_type& out) {
+            const index_type bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            ring* buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            index_type top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom) {
+                // Empty
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            out = buffer->load(bottom);
+            if (top == bottom) {
+                // Racing with thieves for the last item
+                const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Any thread. Steal an item from the top.
+         * @return false if deque is empty or lost the race with other thieves or owner
+         */
+        bool steal(value_type& out) {
+            index_type top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const index_type bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom) {
+                return false;
+            }
+
+            ring* buffer = m_buffer.load(std::memory_order_acquire);
+            const value_type item = buffer->load(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return false;
+            }
+            out = item;
+            return true;
+        }
+
+        /**
+         * @brief Approximate number of items, might be stale when observed from non-owner threads.
+         */
+        AVALANCHE_NO_DISCARD size_type size_approx() const {
+            const index_type bottom = m_bottom.load(std::memory_order_relaxed);
+            const index_type top = m_top.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<size_type>(bottom - top) : 0;
+        }
+
+        AVALANCHE_NO_DISCARD bool is_empty_approx() const {
+            return size_approx() == 0;
+        }
+
+    private:
+        class ring {
+        public:
+            explicit ring(const size_type capacity) : m_mask(capacity - 1), m_slots(new std::atomic<value_type>[capacity]) {}
+
+            ~ring() {
+                delete[] m_slots;
+            }
+
+            ring(const ring&) = delete;
+            ring& operator=(const ring&) = delete;
+
+            AVALANCHE_NO_DISCARD size_type capacity() const {
+                return m_mask + 1;
+            }
+
+            void store(const index_type index, value_type item) {
+                m_slots[static_cast<size_type>(index) & m_mask].store(item, std::memory_order_relaxed);
+            }
+
+            AVALANCHE_NO_DISCARD value_type load(const index_type index) const {
+                return m_slots[static_cast<size_type>(index) & m_mask].load(std::memory_order_relaxed);
+            }
+
+        private:
+            size_type m_mask;
+            std::atomic<value_type>* m_slots;
+        };
+
+        ring* grow(ring* old_buffer, const index_type bottom, const index_type top) {
+            ring* new_buffer = new ring(old_buffer->capacity() * 2);
+            for (index_type i = top; i < bottom; ++i) {
+                new_buffer->store(i, old_buffer->load(i));
+            }
+            // Thieves might still reading the old buffer, so we keep it alive until the deque destroyed
+            m_retired_buffers.push_back(old_buffer);
+            m_buffer.store(new_buffer, std::memory_order_release);
+            return new_buffer;
+        }
+
+        alignas(64) std::atomic<index_type> m_top{0};
+        alignas(64) std::atomic<index_type> m_bottom{0};
+        std::atomic<ring*> m_buffer;
+        vector<ring*> m_retired_buffers{};
+    };
+
+}
@@ -1,64 +1,349 @@
 #include "manager/tick_manager.h"
+#include "profiler.h"
 #include "container/vector.hpp"
-#include "execution/generator.h"
-#include <queue>
-#include <shared_mutex>
+#include "execution/parallel.h"
+#include "execution/graph.h"
+#include "execution/graph_executor.h"
+#include "container/unique_ptr.hpp"
+#include "container/timing_wheel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
 #include <chrono>
+#include <limits>
+#include <unordered_map>
 #include <utility>
 
 
 namespace avalanche::core {
+
+    /**
+     * @brief Node of the dependency graph of a tick group.
+     */
+    class TickGraphNode : public execution::Node<TickGraphNode> {
+    public:
+        using Node::Node;
+
+        ITickable* tickable = nullptr;
+        const ITickable::duration_type* delta_time = nullptr;
+        // Ticks on the calling thread, unless the tickable is parallel safe
+        bool is_serial = true;
+
+        void execute() const {
+            // The root node of graph doesn't bind to a tickable
+            if (tickable != nullptr) {
+                AVALANCHE_PROFILE_SCOPE("ITickable::tick");
+                tickable->tick(*delta_time);
+            }
+        }
+    };
+
+    /**
+     * @brief Compiled dependency graph of a tick group, cached until the topology changed.
+     */
+    struct TickGraph {
+        using graph_type = execution::CompiledGraph<TickGraphNode>;
+        using node_id_type = graph_type::node_id_type;
+
+        explicit TickGraph(graph_type&& compiled_graph)
+            : graph(std::move(compiled_graph))
+            , executor(graph)
+        {
+            for (const node_id_type nid : graph.get_topological_order()) {
+                if (graph.get_node(nid).is_serial) {
+                    serial_order.push_back(nid);
+                }
+            }
+        }
+
+        graph_type graph;
+        execution::GraphExecutor<TickGraphNode, graph_type> executor;
+        // Serial nodes in topological order including the prerequisite edges, ticked on the calling thread in this order
+        // while the others run on the job system
+        vector<node_id_type> serial_order{};
+    };
+
     class TickManager : public ITickManager {
     public:
 
         using clock_type = std::chrono::steady_clock;
         using time_point_type = std::chrono::time_point<clock_type>;
         using duration_type = std::chrono::duration<typename ITickable::duration_type, std::milli>;
+        using size_type = size_t;
 
         TickManager()
             : m_is_shutdown(false)
-            , m_previous_frame_time(clock_type::now())
+            , m_start_time(clock_type::now())
+            , m_previous_frame_time(m_start_time)
         {}
 
         struct TickPair {
             ITickable* tickable;
             tick_group_t group;
-        };
+            ITickable::duration_type interval = 0;
+            bool is_round_robin = false;
+            bool is_sleeping = false;
+            // Id of the pending timer of this tickable in the timing wheel, 0 if there is none
+            uint64_t timer_id = 0;
+            time_point_type last_tick_time{};
+
+            AVALANCHE_NO_DISCARD bool is_in_tick_list() const {
+                return !is_sleeping && !is_round_robin && interval <= 0;
+            }
+
+            AVALANCHE_NO_DISCARD bool is_in_round_robin() const {
+                return !is_sleeping && is_round_robin;
+            }
 
-        struct PriorityCompartor {
-            bool operator()(const TickPair& lhs, const TickPair& rhs) {
-                // The smaller number has higher priority
-                return lhs.group > rhs.group;
+            AVALANCHE_NO_DISCARD bool is_interval_ticking() const {
+                return !is_sleeping && !is_round_robin && interval > 0;
             }
         };
 
+        /**
+         * @brief Timer in the timing wheel, waking up a sleeping tickable or ticking an interval tickable.
+         *
+         * Timers are never removed from the wheel, a timer is stale once its id differs from the one in the registry.
+         */
+        struct TickTimer {
+            ITickable* tickable;
+            uint64_t id;
+        };
+
+        enum class TickCommandType : uint8_t {
+            SetInterval,
+            Sleep,
+            Wake,
+            SetRoundRobin,
+        };
+
+        /**
+         * @brief Scheduling change requested by the API, applied at the beginning of the next frame.
+         */
+        struct TickCommand {
+            TickCommandType type;
+            ITickable* tickable;
+            ITickable::duration_type duration;
+            bool is_round_robin;
+        };
+
+        /**
+         * @brief Tickable out of the tick list ticking in this frame, `index` is its position in the registry.
+         */
+        struct DueTickable {
+            size_type index;
+            tick_group_t group;
+        };
+
+        using timing_wheel_type = timing_wheel<TickTimer>;
+        using wheel_tick_type = timing_wheel_type::tick_type;
+        using coroutine_handle = execution::coroutine_executor_base::coroutine_handle;
+
+        /**
+         * @brief Tickables of a group, as a slice of the cached tick list.
+         *
+         * Tickables in [begin, parallel_begin) tick on the calling thread, the ones in [parallel_begin, end) are parallel
+         * safe and fan out on the job system meanwhile. If there are prerequisites in the group, it's ticked by its
+         * dependency graph `m_tick_graphs[graph_index]` instead.
+         */
+        struct TickBucket {
+            tick_group_t group;
+            size_type begin;
+            size_type parallel_begin;
+            size_type end;
+            size_type graph_index;
+        };
+
+        static constexpr size_type invalid_graph_index = static_cast<size_type>(-1);
+
+        // Number of parallel safe tickables ticked by a job at least
+        static constexpr size_type parallel_tick_grain = 64;
+
+        static constexpr size_type default_round_robin_budget = 16;
+
         void register_tickable(avalanche::core::ITickable *tickable, tick_group_t group) override {
-            std::unique_lock<std::shared_mutex> lock(m_mutex);
-            m_registered_tickable.push_back({ tickable, group });
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (const auto it = m_index_of_tickable.find(tickable); it != m_index_of_tickable.end()) {
+                m_registered_tickable[it->second].group = group;
+            } else {
+                TickPair pair{ tickable, group };
+                pair.last_tick_time = clock_type::now();
+                m_index_of_tickable.emplace(tickable, m_registered_tickable.size());
+                m_registered_tickable.push_back(pair);
+            }
+            m_is_tick_list_dirty = true;
         }
 
         void unregister_tickable(avalanche::core::ITickable* tickable) override {
-            std::unique_lock<std::shared_mutex> lock(m_mutex);
-            for (auto i : execution::range<size_t>(0, m_registered_tickable.size())) {
-                const auto& [t, g] = m_registered_tickable[i];
-                if (t == tickable) {
-                    m_registered_tickable.remove_at(i);
-                    return;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            {
+                // Another tickable might be registered at the same address later
+                std::lock_guard<std::mutex> command_lock(m_command_mutex);
+                const auto new_end = std::remove_if(m_pending_commands.begin(), m_pending_commands.end(), [tickable](const TickCommand& command) {
+                    return command.tickable == tickable;
+                });
+                const auto num_remaining = static_cast<size_type>(new_end - m_pending_commands.begin());
+                while (m_pending_commands.size() > num_remaining) {
+                    m_pending_commands.remove_last();
+                }
+            }
+
+            const auto it = m_index_of_tickable.find(tickable);
+            if (it == m_index_of_tickable.end()) {
+                return;
+            }
+
+            // Leave a hole to keep the registration order, compacted at the beginning of the next frame
+            m_registered_tickable[it->second].tickable = nullptr;
+            m_index_of_tickable.erase(it);
+            ++m_num_unregistered;
+
+            if (const auto prerequisites = m_prerequisites.find(tickable); prerequisites != m_prerequisites.end()) {
+                for (ITickable* prerequisite : prerequisites->second) {
+                    m_dependents[prerequisite].remove(tickable);
                 }
+                m_prerequisites.erase(prerequisites);
             }
+            if (const auto dependents = m_dependents.find(tickable); dependents != m_dependents.end()) {
+                for (ITickable* dependent : dependents->second) {
+                    m_prerequisites[dependent].remove(tickable);
+                }
+                m_dependents.erase(dependents);
+            }
+            m_is_tick_list_dirty = true;
+        }
+
+        void add_tick_prerequisite(ITickable* tickable, ITickable* prerequisite) override {
+            AVALANCHE_CHECK(tickable != nullptr && prerequisite != nullptr && tickable != prerequisite, "Invalid tick prerequisite");
+            std::lock_guard<std::mutex> lock(m_mutex);
+            vector<ITickable*>& prerequisites = m_prerequisites[tickable];
+            if (prerequisites.find(prerequisite) != vector<ITickable*>::npos) {
+                return;
+            }
+            prerequisites.push_back(prerequisite);
+            m_dependents[prerequisite].push_back(tickable);
+            m_is_tick_list_dirty = true;
+        }
+
+        void remove_tick_prerequisite(ITickable* tickable, ITickable* prerequisite) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto it = m_prerequisites.find(tickable);
+            if (it == m_prerequisites.end() || it->second.find(prerequisite) == vector<ITickable*>::npos) {
+                return;
+            }
+            it->second.remove(prerequisite);
+            m_dependents[prerequisite].remove(tickable);
+            m_is_tick_list_dirty = true;
+        }
+
+        void set_tick_interval(ITickable* tickable, const ITickable::duration_type interval) override {
+            push_command({ TickCommandType::SetInterval, tickable, interval > 0 ? interval : 0, false });
+        }
+
+        void sleep_tickable(ITickable* tickable, const ITickable::duration_type duration) override {
+            push_command({ TickCommandType::Sleep, tickable, duration > 0 ? duration : 0, false });
+        }
+
+        void wake_tickable(ITickable* tickable) override {
+            push_command({ TickCommandType::Wake, tickable, 0, false });
+        }
+
+        void set_tick_round_robin(ITickable* tickable, const bool is_round_robin) override {
+            push_command({ TickCommandType::SetRoundRobin, tickable, 0, is_round_robin });
+        }
+
+        void set_round_robin_budget(const size_t max_tickables_per_frame) override {
+            m_round_robin_budget.store(max_tickables_per_frame, std::memory_order_relaxed);
+        }
+
+        void set_loop_settings(const TickLoopSettings& settings) override {
+            std::lock_guard<std::mutex> lock(m_command_mutex);
+            m_pending_loop_settings = settings;
+        }
+
+        TickLoopSettings get_loop_settings() const override {
+            std::lock_guard<std::mutex> lock(m_command_mutex);
+            return m_pending_loop_settings;
+        }
+
+        void resume_on_next_frame(execution::promise_state_base& coroutine) override {
+            std::lock_guard<std::mutex> lock(m_next_frame_mutex);
+            m_next_frame_coroutines.emplace_back(&coroutine);
+        }
+
+        FrameTimingStats get_frame_stats() const override {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            return m_frame_stats;
         }
 
         bool tick_frame() override {
             if (m_is_shutdown.load(std::memory_order_acquire)) {
                 return false;
             }
-            std::shared_lock<std::shared_mutex> lock(m_mutex);
-            const time_point_type time_point = std::exchange(m_previous_frame_time, clock_type::now());
-            const duration_type duration = m_previous_frame_time - time_point;
-            std::priority_queue<TickPair, std::vector<TickPair>, PriorityCompartor> queue { m_registered_tickable.begin(), m_registered_tickable.end() };
-            for (; !queue.empty(); queue.pop()) {
-                queue.top().tickable->tick(duration.count());
+
+            // Before taking the lock, since they are free to touch the tick manager
+            {
+                std::lock_guard<std::mutex> lock(m_next_frame_mutex);
+                m_resuming_coroutines.swap(m_next_frame_coroutines);
+            }
+            for (coroutine_handle& coroutine : m_resuming_coroutines) {
+                execution::coroutine_executor_base* executor = coroutine->get_executor();
+                executor->push_coroutine(std::move(coroutine));
+            }
+            m_resuming_coroutines.clear();
+            execution::main_thread_executor::get_global_executor().drain();
+
+            FrameTimingStats stats{};
+            time_point_type frame_start_time{};
+            duration_type target_frame_time{};
+            duration_type spin_threshold{};
+            {
+                AVALANCHE_PROFILE_SCOPE("TickManager::tick_frame");
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                frame_start_time = clock_type::now();
+                const duration_type raw_delta_time = frame_start_time - std::exchange(m_previous_frame_time, frame_start_time);
+
+                m_due_tickables.clear();
+                compact_registry();
+                apply_commands();
+                m_timing_wheel.advance(to_wheel_tick(m_previous_frame_time), [this](const TickTimer& timer) {
+                    on_timer_expired(timer);
+                });
+                rebuild_tick_list();
+                pick_round_robin();
+                std::stable_sort(m_due_tickables.begin(), m_due_tickables.end(), [](const DueTickable& lhs, const DueTickable& rhs) {
+                    return lhs.group < rhs.group;
+                });
+
+                m_delta_time = raw_delta_time.count();
+                if (m_loop_settings.max_delta_time > 0) {
+                    m_delta_time = std::min(m_delta_time, m_loop_settings.max_delta_time);
+                }
+                const uint32_t num_fixed_steps = consume_fixed_steps(m_delta_time);
+                tick_groups(num_fixed_steps);
+
+                stats.frame_index = ++m_frame_index;
+                stats.raw_delta_time = raw_delta_time.count();
+                stats.delta_time = m_delta_time;
+                stats.num_fixed_steps = num_fixed_steps;
+                stats.fixed_step_alpha = m_loop_settings.fixed_delta_time > 0 ? m_fixed_step_accumulator / m_loop_settings.fixed_delta_time : 0;
+                target_frame_time = duration_type(m_loop_settings.target_frame_time);
+                spin_threshold = duration_type(m_loop_settings.spin_threshold);
+            }
+
+            // Wait without holding the registry, other threads are free to register in the meantime
+            const time_point_type tick_end_time = clock_type::now();
+            stats.tick_time = duration_type(tick_end_time - frame_start_time).count();
+            if (target_frame_time.count() > 0) {
+                wait_until(frame_start_time + std::chrono::duration_cast<clock_type::duration>(target_frame_time), spin_threshold);
+                stats.wait_time = duration_type(clock_type::now() - tick_end_time).count();
             }
+
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_frame_stats = stats;
             return true;
         }
 
@@ -67,9 +352,449 @@ namespace avalanche::core {
         }
 
     private:
+        AVALANCHE_NO_DISCARD bool is_fixed_step_group(const tick_group_t group) const {
+            return m_loop_settings.fixed_delta_time > 0
+                && group >= m_loop_settings.fixed_step_group_begin
+                && group <= m_loop_settings.fixed_step_group_end;
+        }
+
+        /**
+         * @brief Accumulate the frame time, resulting the number of fixed steps to tick in this frame.
+         */
+        uint32_t consume_fixed_steps(const ITickable::duration_type delta_time) {
+            const ITickable::duration_type fixed_delta_time = m_loop_settings.fixed_delta_time;
+            if (fixed_delta_time <= 0) {
+                m_fixed_step_accumulator = 0;
+                return 0;
+            }
+            m_fixed_step_accumulator += delta_time;
+            auto num_steps = static_cast<uint32_t>(m_fixed_step_accumulator / fixed_delta_time);
+            if (num_steps > m_loop_settings.max_fixed_steps_per_frame) {
+                num_steps = m_loop_settings.max_fixed_steps_per_frame;
+                // Drop the time we can't catch up with
+                m_fixed_step_accumulator = std::fmod(m_fixed_step_accumulator, fixed_delta_time);
+            } else {
+                m_fixed_step_accumulator -= static_cast<ITickable::duration_type>(num_steps) * fixed_delta_time;
+            }
+            return num_steps;
+        }
+
+        /**
+         * @brief Tick every bucket in order, tickables out of the tick list tick after the tick list of their group.
+         *
+         * Consecutive fixed step groups tick `num_fixed_steps` times together, the ones out of the tick list tick once
+         * after all of the steps.
+         */
+        void tick_groups(const uint32_t num_fixed_steps) {
+            size_type due_cursor = 0;
+            const auto tick_due_until = [this, &due_cursor](const tick_group_t group, const bool is_inclusive) {
+                while (due_cursor < m_due_tickables.size()
+                    && (m_due_tickables[due_cursor].group < group || (is_inclusive && m_due_tickables[due_cursor].group == group))) {
+                    tick_due(m_due_tickables[due_cursor++]);
+                }
+            };
+
+            for (size_type i = 0; i < m_tick_buckets.size();) {
+                const tick_group_t group = m_tick_buckets[i].group;
+                tick_due_until(group, false);
+                if (!is_fixed_step_group(group)) {
+                    tick_bucket(m_tick_buckets[i], m_delta_time);
+                    tick_due_until(group, true);
+                    ++i;
+                    continue;
+                }
+
+                size_type end = i + 1;
+                while (end < m_tick_buckets.size() && is_fixed_step_group(m_tick_buckets[end].group)) {
+                    ++end;
+                }
+                for (uint32_t step = 0; step < num_fixed_steps; ++step) {
+                    for (size_type j = i; j < end; ++j) {
+                        tick_bucket(m_tick_buckets[j], m_loop_settings.fixed_delta_time);
+                    }
+                }
+                tick_due_until(m_tick_buckets[end - 1].group, true);
+                i = end;
+            }
+            tick_due_until(std::numeric_limits<tick_group_t>::max(), true);
+        }
+
+        /**
+         * @brief Sleep until shortly before `deadline` then spin for the rest, as sleeping tends to overshoot.
+         */
+        static void wait_until(const time_point_type deadline, const duration_type spin_threshold) {
+            AVALANCHE_PROFILE_SCOPE("TickManager::wait_for_frame");
+            const auto sleep_deadline = deadline - std::chrono::duration_cast<clock_type::duration>(spin_threshold);
+            if (clock_type::now() < sleep_deadline) {
+                std::this_thread::sleep_until(sleep_deadline);
+            }
+            while (clock_type::now() < deadline) {
+                std::this_thread::yield();
+            }
+        }
+
+        void push_command(const TickCommand& command) {
+            std::lock_guard<std::mutex> lock(m_command_mutex);
+            m_pending_commands.push_back(command);
+        }
+
+        AVALANCHE_NO_DISCARD wheel_tick_type to_wheel_tick(const time_point_type time_point) const {
+            return static_cast<wheel_tick_type>(std::chrono::duration_cast<std::chrono::milliseconds>(time_point - m_start_time).count());
+        }
+
+        void schedule_timer(TickPair& pair, const ITickable::duration_type delay) {
+            pair.timer_id = ++m_last_timer_id;
+            const auto delay_ticks = static_cast<wheel_tick_type>(std::ceil(delay));
+            m_timing_wheel.schedule({ pair.tickable, pair.timer_id }, to_wheel_tick(m_previous_frame_time) + delay_ticks);
+        }
+
+        void apply_commands() {
+            {
+                std::lock_guard<std::mutex> lock(m_command_mutex);
+                m_applying_commands.swap(m_pending_commands);
+                m_loop_settings = m_pending_loop_settings;
+            }
+            for (const TickCommand& command : m_applying_commands) {
+                apply_command(command);
+            }
+            m_applying_commands.clear();
+        }
+
+        void apply_command(const TickCommand& command) {
+            const auto it = m_index_of_tickable.find(command.tickable);
+            if (it == m_index_of_tickable.end()) {
+                return;
+            }
+            TickPair& pair = m_registered_tickable[it->second];
+            const bool was_in_tick_list = pair.is_in_tick_list();
+            const bool was_in_round_robin = pair.is_in_round_robin();
+            const bool was_interval_ticking = pair.is_interval_ticking();
+
+            switch (command.type) {
+                case TickCommandType::SetInterval:
+                    pair.interval = command.duration;
+                    break;
+                case TickCommandType::Sleep:
+                    pair.is_sleeping = true;
+                    pair.timer_id = 0;
+                    if (command.duration > 0) {
+                        schedule_timer(pair, command.duration);
+                    }
+                    break;
+                case TickCommandType::Wake:
+                    if (pair.is_sleeping) {
+                        pair.is_sleeping = false;
+                        pair.timer_id = 0;
+                    }
+                    break;
+                case TickCommandType::SetRoundRobin:
+                    pair.is_round_robin = command.is_round_robin;
+                    break;
+            }
+
+            if (pair.is_interval_ticking()) {
+                if (!was_interval_ticking) {
+                    // A woken up tickable ticks as soon as possible, otherwise waits for a whole interval
+                    schedule_timer(pair, command.type == TickCommandType::Wake ? 0 : pair.interval);
+                } else if (command.type == TickCommandType::SetInterval) {
+                    schedule_timer(pair, pair.interval);
+                }
+            } else if (!pair.is_sleeping) {
+                pair.timer_id = 0;
+            }
+            if (was_in_tick_list != pair.is_in_tick_list() || was_in_round_robin != pair.is_in_round_robin()) {
+                m_is_tick_list_dirty = true;
+            }
+        }
+
+        void on_timer_expired(const TickTimer& timer) {
+            const auto it = m_index_of_tickable.find(timer.tickable);
+            if (it == m_index_of_tickable.end()) {
+                return;
+            }
+            TickPair& pair = m_registered_tickable[it->second];
+            if (pair.timer_id != timer.id) {
+                return;
+            }
+            pair.timer_id = 0;
+            if (pair.is_sleeping) {
+                pair.is_sleeping = false;
+                if (!pair.is_interval_ticking()) {
+                    m_is_tick_list_dirty = true;
+                    return;
+                }
+            }
+            if (pair.is_interval_ticking()) {
+                m_due_tickables.push_back({ it->second, pair.group });
+                schedule_timer(pair, pair.interval);
+            }
+        }
+
+        void pick_round_robin() {
+            const size_type budget = std::min(m_round_robin_budget.load(std::memory_order_relaxed), m_round_robin_list.size());
+            for (size_type i = 0; i < budget; ++i) {
+                if (m_round_robin_cursor >= m_round_robin_list.size()) {
+                    m_round_robin_cursor = 0;
+                }
+                const size_type index = m_round_robin_list[m_round_robin_cursor++];
+                m_due_tickables.push_back({ index, m_registered_tickable[index].group });
+            }
+        }
+
+        void tick_due(const DueTickable& due) {
+            AVALANCHE_PROFILE_SCOPE("ITickable::tick");
+            TickPair& pair = m_registered_tickable[due.index];
+            const duration_type duration = m_previous_frame_time - pair.last_tick_time;
+            pair.last_tick_time = m_previous_frame_time;
+            pair.tickable->tick(duration.count());
+        }
+
+        /**
+         * @brief Tick a group, returning after all of its tickables finished, which is the barrier between groups.
+         */
+        void tick_bucket(const TickBucket& bucket, const ITickable::duration_type delta_time) {
+            AVALANCHE_PROFILE_SCOPE("TickManager::tick_bucket");
+            if (bucket.graph_index != invalid_graph_index) {
+                m_graph_delta_time = delta_time;
+                tick_graph(*m_tick_graphs[bucket.graph_index]);
+                return;
+            }
+
+            const size_type num_parallel = bucket.end - bucket.parallel_begin;
+            const bool should_fan_out = num_parallel > parallel_tick_grain
+                && execution::threaded_coroutine_executor::get_current_worker_index() == execution::threaded_coroutine_executor::invalid_worker_index;
+            if (!should_fan_out) {
+                for (size_type i = bucket.begin; i < bucket.end; ++i) {
+                    AVALANCHE_PROFILE_SCOPE("ITickable::tick");
+                    m_tick_list[i]->tick(delta_time);
+                }
+                return;
+            }
+
+            auto parallel_ticks = execution::parallel_for_async(bucket.parallel_begin, bucket.end, parallel_tick_grain, [this, delta_time](const size_type i) {
+                AVALANCHE_PROFILE_SCOPE("ITickable::tick");
+                m_tick_list[i]->tick(delta_time);
+            });
+            execution::launch(parallel_ticks, execution::task_priority::high);
+            for (size_type i = bucket.begin; i < bucket.parallel_begin; ++i) {
+                AVALANCHE_PROFILE_SCOPE("ITickable::tick");
+                m_tick_list[i]->tick(delta_time);
+            }
+            execution::detail::parallel::block_on(parallel_ticks);
+        }
+
+        static void tick_graph(TickGraph& tick_graph) {
+            if (execution::threaded_coroutine_executor::get_current_worker_index() != execution::threaded_coroutine_executor::invalid_worker_index) {
+                // Can't block a worker, tick serially following the dependencies
+                for (const auto nid : tick_graph.graph.get_topological_order()) {
+                    tick_graph.graph.get_node(nid).execute();
+                }
+                return;
+            }
+            tick_graph.executor.run_with_inline_nodes(tick_graph.serial_order, execution::task_priority::high);
+        }
+
+        /**
+         * @brief Build the dependency graph of a bucket, nullptr if there are no prerequisites inside it.
+         */
+        unique_ptr<TickGraph> build_tick_graph(const TickBucket& bucket) {
+            using adjacency_list_type = execution::Graph<TickGraphNode>::adjacency_list_type;
+
+            bool has_prerequisite = false;
+            for (size_type i = bucket.begin; i < bucket.end && !has_prerequisite; ++i) {
+                if (const auto it = m_prerequisites.find(m_tick_list[i]); it != m_prerequisites.end()) {
+                    for (ITickable* prerequisite : it->second) {
+                        has_prerequisite |= group_of(prerequisite) == bucket.group;
+                    }
+                }
+            }
+            if (!has_prerequisite) {
+                return nullptr;
+            }
+
+            const size_type num_tickables = bucket.end - bucket.begin;
+            execution::Graph<TickGraphNode> graph(num_tickables + 1);
+            std::unordered_map<ITickable*, shared_ptr<TickGraphNode>> node_of_tickable{};
+            node_of_tickable.reserve(num_tickables);
+
+            // Serial tickables need no edges between them, they tick one by one on the calling thread anyway
+            for (size_type i = bucket.begin; i < bucket.end; ++i) {
+                shared_ptr<TickGraphNode> node = graph.new_node();
+                node->tickable = m_tick_list[i];
+                node->delta_time = &m_graph_delta_time;
+                node->is_serial = i < bucket.parallel_begin;
+                node_of_tickable.emplace(m_tick_list[i], node);
+            }
+
+            for (size_type i = bucket.begin; i < bucket.end; ++i) {
+                const auto it = m_prerequisites.find(m_tick_list[i]);
+                if (it == m_prerequisites.end()) {
+                    continue;
+                }
+                const shared_ptr<TickGraphNode>& node = node_of_tickable[m_tick_list[i]];
+                for (ITickable* prerequisite : it->second) {
+                    const tick_group_t prerequisite_group = group_of(prerequisite);
+                    if (prerequisite_group > bucket.group) {
+                        AVALANCHE_LOGGER.warn("Tick prerequisite in a later tick group is ignored");
+                        continue;
+                    }
+                    if (prerequisite_group != bucket.group) {
+                        continue;
+                    }
+                    const auto prerequisite_it = node_of_tickable.find(prerequisite);
+                    if (prerequisite_it == node_of_tickable.end()) {
+                        // Sleeping or ticking out of the tick list
+                        continue;
+                    }
+                    const shared_ptr<TickGraphNode>& prerequisite_node = prerequisite_it->second;
+                    if (graph.get_successors(prerequisite_node->node_id()).find(node->node_id()) != adjacency_list_type::npos) {
+                        continue;
+                    }
+                    try {
+                        graph.add_edge(prerequisite_node, node);
+                    } catch (const execution::cycle_detected&) {
+                        AVALANCHE_LOGGER.error("Tick prerequisite forming a cycle is ignored");
+                    }
+                }
+            }
+
+            return make_unique<TickGraph>(graph.compile());
+        }
+
+        AVALANCHE_NO_DISCARD tick_group_t group_of(ITickable* tickable) const {
+            if (const auto it = m_index_of_tickable.find(tickable); it != m_index_of_tickable.end()) {
+                return m_registered_tickable[it->second].group;
+            }
+            // Not registered, never ticks in this frame
+            return std::numeric_limits<tick_group_t>::lowest();
+        }
+
+        /**
+         * @brief Sort tickables ticking every frame by group, only happens after the registry or scheduling changed.
+         */
+        /**
+         * @brief Drop the holes left by unregistering, keeping the registration order of the remaining tickables.
+         */
+        void compact_registry() {
+            if (m_num_unregistered == 0) {
+                return;
+            }
+            size_type num_kept = 0;
+            for (size_type i = 0; i < m_registered_tickable.size(); ++i) {
+                const TickPair& pair = m_registered_tickable[i];
+                if (pair.tickable == nullptr) {
+                    continue;
+                }
+                if (num_kept != i) {
+                    m_registered_tickable[num_kept] = pair;
+                    m_index_of_tickable[pair.tickable] = num_kept;
+                }
+                ++num_kept;
+            }
+            while (m_registered_tickable.size() > num_kept) {
+                m_registered_tickable.remove_last();
+            }
+            m_num_unregistered = 0;
+        }
+
+        void rebuild_tick_list() {
+            if (!m_is_tick_list_dirty) {
+                return;
+            }
+            AVALANCHE_PROFILE_SCOPE("TickManager::rebuild_tick_list");
+
+            vector<TickPair> sorted{};
+            sorted.ensure_capacity(m_registered_tickable.size());
+            m_round_robin_list.clear();
+            for (size_type i = 0; i < m_registered_tickable.size(); ++i) {
+                const TickPair& pair = m_registered_tickable[i];
+                if (pair.is_in_tick_list()) {
+                    sorted.push_back(pair);
+                } else if (pair.is_in_round_robin()) {
+                    m_round_robin_list.push_back(i);
+                }
+            }
+            // The smaller number has higher priority, serial tickables come first within a group, registration order is
+            // kept otherwise
+            std::stable_sort(sorted.begin(), sorted.end(), [](const TickPair& lhs, const TickPair& rhs) {
+                if (lhs.group != rhs.group) {
+                    return lhs.group < rhs.group;
+                }
+                return !lhs.tickable->is_parallel_tick_safe() && rhs.tickable->is_parallel_tick_safe();
+            });
+
+            m_tick_list.clear();
+            m_tick_list.ensure_capacity(sorted.size());
+            m_tick_buckets.clear();
+            for (const TickPair& pair : sorted) {
+                ITickable* tickable = pair.tickable;
+                const tick_group_t group = pair.group;
+                if (m_tick_buckets.is_empty() || m_tick_buckets.last_item().group != group) {
+                    m_tick_buckets.push_back({ group, m_tick_list.size(), m_tick_list.size(), m_tick_list.size(), invalid_graph_index });
+                }
+                TickBucket& bucket = m_tick_buckets.last_item();
+                m_tick_list.push_back(tickable);
+                ++bucket.end;
+                if (!tickable->is_parallel_tick_safe()) {
+                    bucket.parallel_begin = bucket.end;
+                }
+            }
+
+            m_tick_graphs.clear();
+            for (TickBucket& bucket : m_tick_buckets) {
+                if (unique_ptr<TickGraph> tick_graph = build_tick_graph(bucket)) {
+                    bucket.graph_index = m_tick_graphs.size();
+                    m_tick_graphs.push_back(std::move(tick_graph));
+                }
+            }
+
+            m_is_tick_list_dirty = false;
+        }
+
         std::atomic<bool> m_is_shutdown;
-        std::shared_mutex m_mutex;
+        std::mutex m_mutex;
         vector<TickPair> m_registered_tickable{};
+        std::unordered_map<ITickable*, size_type> m_index_of_tickable{};
+        // Unregistered entries in the registry, which are null until compacted
+        size_type m_num_unregistered = 0;
+
+        // Cached tick order, rebuilt from the registry when dirty
+        bool m_is_tick_list_dirty = false;
+        vector<ITickable*> m_tick_list{};
+        vector<TickBucket> m_tick_buckets{};
+        vector<unique_ptr<TickGraph>> m_tick_graphs{};
+
+        // Prerequisites of each tickable, and the reversed relation to clean up on unregistering
+        std::unordered_map<ITickable*, vector<ITickable*>> m_prerequisites{};
+        std::unordered_map<ITickable*, vector<ITickable*>> m_dependents{};
+        ITickable::duration_type m_delta_time = 0;
+        // Read by the nodes of tick graphs, either the frame delta time or the fixed one
+        ITickable::duration_type m_graph_delta_time = 0;
+
+        // Loop settings of the current frame, copied from the pending one at the beginning of each frame
+        TickLoopSettings m_loop_settings{};
+        TickLoopSettings m_pending_loop_settings{};
+        ITickable::duration_type m_fixed_step_accumulator = 0;
+        uint64_t m_frame_index = 0;
+        mutable std::mutex m_stats_mutex;
+        FrameTimingStats m_frame_stats{};
+
+        // Scheduling out of the tick list, in milliseconds since the manager started
+        mutable std::mutex m_command_mutex;
+        vector<TickCommand> m_pending_commands{};
+        vector<TickCommand> m_applying_commands{};
+        timing_wheel_type m_timing_wheel{};
+        uint64_t m_last_timer_id = 0;
+        vector<DueTickable> m_due_tickables{};
+        vector<size_type> m_round_robin_list{};
+        size_type m_round_robin_cursor = 0;
+        std::atomic<size_type> m_round_robin_budget{default_round_robin_budget};
+
+        std::mutex m_next_frame_mutex;
+        vector<coroutine_handle> m_next_frame_coroutines{};
+        vector<coroutine_handle> m_resuming_coroutines{};
+
+        time_point_type m_start_time;
         time_point_type m_previous_frame_time;
     };
 
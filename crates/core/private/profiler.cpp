@@ -0,0 +1,221 @@
+#include "profiler.h"
+#include "logger.h"
+#include "container/vector.hpp"
+#include "container/unique_ptr.hpp"
+
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+namespace avalanche::core {
+
+    struct ProfileZoneEvent {
+        const ProfileZoneLocation* location;
+        IProfiler::timestamp_type begin;
+        IProfiler::timestamp_type end;
+    };
+
+    /**
+     * @brief Single producer single consumer ring of zones, written by its thread and drained by the exporter.
+     *
+     * Owned by the profiler, so zones of a thread are still exportable after the thread exited. The ring is only
+     * allocated by the first zone of the thread, naming a thread which never records anything costs nothing.
+     */
+    struct ThreadProfileBuffer {
+        static constexpr size_t capacity = 1 << 16;
+        static constexpr size_t index_mask = capacity - 1;
+
+        explicit ThreadProfileBuffer(const uint32_t thread_index)
+            : thread_index(thread_index)
+            , name(std::format("Thread {}", thread_index))
+        {}
+
+        const uint32_t thread_index;
+        // Guarded by the mutex of profiler
+        std::string name;
+        // Written by its thread before publishing the first zone
+        std::unique_ptr<ProfileZoneEvent[]> events{};
+
+        alignas(64) std::atomic<size_t> write_index{0};
+        alignas(64) std::atomic<size_t> read_index{0};
+        std::atomic<size_t> num_dropped{0};
+    };
+
+    namespace {
+        std::atomic<bool> g_is_profiler_enabled{false};
+        thread_local ThreadProfileBuffer* t_profile_buffer = nullptr;
+
+        void append_json_string(std::string& out, const std::string_view str) {
+            out.push_back('"');
+            for (const char c : str) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                        } else {
+                            out.push_back(c);
+                        }
+                }
+            }
+            out.push_back('"');
+        }
+    }
+
+    class Profiler final : public IProfiler {
+    public:
+        Profiler()
+            : m_base_timestamp(now())
+            , m_base_time(std::chrono::steady_clock::now())
+        {}
+
+        ThreadProfileBuffer* create_thread_buffer() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return current_thread_buffer();
+        }
+
+        void set_thread_name(const std::string_view name) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            current_thread_buffer()->name = name;
+        }
+
+        bool write_chrome_trace(const std::string_view path) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::ofstream file{std::string(path), std::ios::out | std::ios::trunc};
+            if (!file) {
+                AVALANCHE_LOGGER.error("Failed to open {} for writing trace", path);
+                return false;
+            }
+
+            const double microseconds_per_tick = get_microseconds_per_tick();
+            std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+            bool is_first = true;
+            const auto begin_event = [&out, &is_first] {
+                if (!is_first) {
+                    out += ",\n";
+                }
+                is_first = false;
+            };
+
+            for (const auto& buffer : m_thread_buffers) {
+                begin_event();
+                out += std::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":", buffer->thread_index);
+                append_json_string(out, buffer->name);
+                out += "}}";
+
+                const size_t read_index = buffer->read_index.load(std::memory_order_relaxed);
+                const size_t write_index = buffer->write_index.load(std::memory_order_acquire);
+                for (size_t i = read_index; i != write_index; ++i) {
+                    const ProfileZoneEvent& event = buffer->events[i & ThreadProfileBuffer::index_mask];
+                    const double timestamp = static_cast<double>(event.begin - m_base_timestamp) * microseconds_per_tick;
+                    const double duration = static_cast<double>(event.end - event.begin) * microseconds_per_tick;
+                    begin_event();
+                    out += "{\"ph\":\"X\",\"cat\":\"avalanche\",\"name\":";
+                    append_json_string(out, event.location->name);
+                    out += std::format(",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"file\":", buffer->thread_index, timestamp, duration);
+                    append_json_string(out, event.location->filename);
+                    out += std::format(",\"line\":{}}}}}", event.location->line);
+
+                    // Keep the memory bounded for large captures
+                    if (out.size() > (1 << 20)) {
+                        file << out;
+                        out.clear();
+                    }
+                }
+                buffer->read_index.store(write_index, std::memory_order_release);
+            }
+            out += "\n]}\n";
+            file << out;
+            return static_cast<bool>(file);
+        }
+
+        void clear() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& buffer : m_thread_buffers) {
+                buffer->read_index.store(buffer->write_index.load(std::memory_order_acquire), std::memory_order_release);
+            }
+        }
+
+        size_t get_num_dropped_zones() const override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t num_dropped = 0;
+            for (const auto& buffer : m_thread_buffers) {
+                num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+            }
+            return num_dropped;
+        }
+
+    private:
+        ThreadProfileBuffer* current_thread_buffer() {
+            if (t_profile_buffer == nullptr) {
+                m_thread_buffers.push_back(make_unique<ThreadProfileBuffer>(static_cast<uint32_t>(m_thread_buffers.size())));
+                t_profile_buffer = m_thread_buffers.last_item().get();
+            }
+            return t_profile_buffer;
+        }
+
+        /**
+         * @brief Calibrate the profiler clock against `steady_clock` over the time since the profiler was created.
+         */
+        AVALANCHE_NO_DISCARD double get_microseconds_per_tick() const {
+#if AVALANCHE_PROFILER_USE_RDTSC
+            const timestamp_type elapsed_ticks = now() - m_base_timestamp;
+            const std::chrono::duration<double, std::micro> elapsed_time = std::chrono::steady_clock::now() - m_base_time;
+            return elapsed_ticks > 0 ? elapsed_time.count() / static_cast<double>(elapsed_ticks) : 0.0;
+#else
+            return 1e-3;
+#endif
+        }
+
+        mutable std::mutex m_mutex;
+        vector<unique_ptr<ThreadProfileBuffer>> m_thread_buffers{};
+        const timestamp_type m_base_timestamp;
+        const std::chrono::steady_clock::time_point m_base_time;
+    };
+
+    IProfiler::~IProfiler() = default;
+
+    IProfiler& IProfiler::get() {
+        // Intentionally leaked, worker threads of global executors might still record zones during static destruction
+        static Profiler* profiler = new Profiler();
+        return *profiler;
+    }
+
+    void IProfiler::set_enabled(const bool enabled) AVALANCHE_NOEXCEPT {
+        if (enabled) {
+            // Calibration starts as early as possible
+            AVALANCHE_MAYBE_UNUSED IProfiler& profiler = get();
+        }
+        g_is_profiler_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IProfiler::is_enabled() AVALANCHE_NOEXCEPT {
+        return g_is_profiler_enabled.load(std::memory_order_relaxed);
+    }
+
+    void IProfiler::submit_zone(const ProfileZoneLocation& location, const timestamp_type begin, const timestamp_type end) AVALANCHE_NOEXCEPT {
+        ThreadProfileBuffer* buffer = t_profile_buffer;
+        if (buffer == nullptr) AVALANCHE_UNLIKELY_BRANCH {
+            buffer = static_cast<Profiler&>(get()).create_thread_buffer();
+        }
+        if (buffer->events == nullptr) AVALANCHE_UNLIKELY_BRANCH {
+            buffer->events = std::make_unique<ProfileZoneEvent[]>(ThreadProfileBuffer::capacity);
+        }
+
+        const size_t write_index = buffer->write_index.load(std::memory_order_relaxed);
+        if (write_index - buffer->read_index.load(std::memory_order_acquire) >= ThreadProfileBuffer::capacity) {
+            buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer->events[write_index & ThreadProfileBuffer::index_mask] = { &location, begin, end };
+        buffer->write_index.store(write_index + 1, std::memory_order_release);
+    }
+
+} // namespace avalanche::core
@@ -5,7 +5,8 @@
 #include "container/optional.hpp"
 #include "container/vector_queue.hpp"
 #include "execution/executor.h"
-#include "container/shared_ptr.hpp"
+#include "execution/frame_allocator.h"
+#include "container/intrusive_ptr.hpp"
 #include <type_traits>
 #include <coroutine>
 #include <utility>
@@ -34,44 +35,185 @@ namespace detail::async {
         using state_type = coroutine_state<Ret>;
 
         explicit coroutine(handle_type coroutine_handle)
-            : m_state(make_atomic_shared<state_type>(coroutine_handle))
+            : m_state(&coroutine_handle.promise())
         {}
 
-        coroutine(const coroutine& other) : m_state(other.m_state) {}
-        coroutine& operator=(const coroutine& other) {
-            if (this != &other) {
-                m_state = other.m_state;
-            }
-            return *this;
-        }
+        coroutine(const coroutine& other) = default;
+        coroutine& operator=(const coroutine& other) = default;
 
-        coroutine(coroutine&& other) AVALANCHE_NOEXCEPT : m_state(std::move(other.m_state)) {}
-        coroutine& operator=(coroutine&& other) AVALANCHE_NOEXCEPT {
-            if (this != &other) {
-                AVALANCHE_MAYBE_UNUSED coroutine temporary(other);
-                std::swap(m_state, other.m_state);
-            }
-            return *this;
-        }
+        coroutine(coroutine&& other) AVALANCHE_NOEXCEPT = default;
+        coroutine& operator=(coroutine&& other) AVALANCHE_NOEXCEPT = default;
 
         state_type* operator->() {
-            return m_state.template get<state_type>();
+            return m_state.get();
         }
 
-        shared_ptr<state_type, true> get_state() {
+        intrusive_ptr<state_type> get_state() {
             return m_state;
         }
 
         awaiter_type operator co_await() AVALANCHE_NOEXCEPT {
-            return awaiter_type{m_state};
+            return awaiter_type{m_state.get()};
         }
 
     private:
-        shared_ptr<state_type, true> m_state;
+        intrusive_ptr<state_type> m_state;
     };
+    /////////////////////////
+
+    /////////////////////////
 
+    template <typename T>
+    struct bool_if_void_else_type {
+        using type = T;
+        using ret = const T&;
+    };
+
+    template <>
+    struct bool_if_void_else_type<void> {
+        using type = bool;
+        using ret = bool;
+    };
+
+    /**
+     * @brief Observer notified in place of resuming `continuation`, used by fan-out awaitables such as `when_all`.
+     */
+    class completion_listener {
+    public:
+        virtual ~completion_listener() = default;
+
+        /**
+         * @param completed The state of coroutine which just finished
+         * @return The coroutine to transfer to, or `std::noop_coroutine()`
+         */
+        virtual std::coroutine_handle<> on_completed(promise_state_base& completed) AVALANCHE_NOEXCEPT = 0;
+    };
+
+    /**
+     * @brief The state shared between a coroutine and its observers.
+     *
+     * It is the base of the promise, so it lives inside the coroutine frame and the frame is destroyed once the last
+     * reference of the state dropped.
+     */
     template <typename Ret>
-    struct coroutine<Ret>::promise_base {
+    class coroutine_state : public promise_state_base {
+    public:
+        using promise_type = typename coroutine<Ret>::promise_type;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        coroutine_state()
+            : m_is_ready(false)
+            , m_is_scheduled(false)
+            , m_continuation_handshake(false)
+            , m_late_continuation_handshake(false)
+        {
+            set_executor(&threaded_coroutine_executor::get_global_executor());
+            set_priority(threaded_coroutine_executor::get_current_priority());
+        }
+
+        handle_type get_handle() {
+            return handle_type::from_promise(static_cast<promise_type&>(*this));
+        }
+
+        std::coroutine_handle<> get_erased_handle() override {
+            return get_handle();
+        }
+
+        bool set_ready() override {
+            return m_is_ready.exchange(true, std::memory_order_acq_rel);
+        }
+
+        bool done() override {
+            return get_handle().done();
+        }
+
+        void resume() override {
+            get_handle().resume();
+        }
+
+        bool is_ready() override {
+            return m_is_ready.load(std::memory_order_acquire);
+        }
+
+        void set_result(typename bool_if_void_else_type<Ret>::type &&result) { m_coroutine_result = std::move(result); }
+
+        typename bool_if_void_else_type<Ret>::ret get_result() {
+            return m_coroutine_result.value();
+        }
+
+        void submit_to_executor(coroutine_executor_base::coroutine_handle task) const AVALANCHE_NOEXCEPT {
+            get_executor()->push_coroutine(std::move(task));
+        }
+
+        /**
+         * @brief Submit this coroutine to its executor, only the first call takes effect.
+         *
+         * A coroutine might be both launched and awaited, it must not be resumed from two workers at the same time.
+         * A scheduled coroutine keeps itself alive until its final suspend point, since it might be resumed by symmetric
+         * transfer where nobody else is holding it.
+         */
+        void schedule() AVALANCHE_NOEXCEPT {
+            if (!m_is_scheduled.exchange(true, std::memory_order_acq_rel)) {
+                add_reference();
+                submit_to_executor(coroutine_executor_base::coroutine_handle(this));
+            }
+        }
+
+        AVALANCHE_NO_DISCARD bool is_scheduled() const AVALANCHE_NOEXCEPT {
+            return m_is_scheduled.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Two-party handshake between the awaiting coroutine and this one.
+         *
+         * Both the awaiter (after it has stored the continuation) and the final awaiter (after the result is set) arrive here.
+         * The one arriving later is responsible for resuming the continuation.
+         *
+         * @return true if the other party has already arrived
+         */
+        bool arrive_at_continuation_handshake() AVALANCHE_NOEXCEPT {
+            return m_continuation_handshake.exchange(true, std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Second handshake for a coroutine awaited after a fan-out awaitable (e.g. a `when_any` loser) has taken
+         * the first one, the final awaiter arrives here once the listener has been notified.
+         *
+         * @return true if the other party has already arrived
+         */
+        bool arrive_at_late_continuation_handshake() AVALANCHE_NOEXCEPT {
+            return m_late_continuation_handshake.exchange(true, std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Must be set before arriving at the continuation handshake.
+         */
+        void set_completion_listener(completion_listener* listener) AVALANCHE_NOEXCEPT {
+            m_completion_listener = listener;
+        }
+
+        AVALANCHE_NO_DISCARD completion_listener* get_completion_listener() const AVALANCHE_NOEXCEPT {
+            return m_completion_listener;
+        }
+
+    protected:
+        void destroy() override {
+            get_handle().destroy();
+        }
+
+    private:
+        std::atomic<bool> m_is_ready;
+        std::atomic<bool> m_is_scheduled;
+        std::atomic<bool> m_continuation_handshake;
+        std::atomic<bool> m_late_continuation_handshake;
+        completion_listener* m_completion_listener = nullptr;
+        optional<typename bool_if_void_else_type<Ret>::type> m_coroutine_result{};
+    };
+    /////////////////////////
+
+    /////////////////////////
+    template <typename Ret>
+    struct coroutine<Ret>::promise_base : coroutine_state<Ret>, pooled_frame {
 
         /**
          * @brief We won't handle the exception inside the coroutine.
@@ -110,8 +252,8 @@ namespace detail::async {
          *
          * to resume the continuation if existed.
          */
-        final_awaiter final_suspend() AVALANCHE_NOEXCEPT {
-            return final_awaiter { coroutine_state_value };
+        static final_awaiter final_suspend() AVALANCHE_NOEXCEPT {
+            return final_awaiter{};
         }
 
         /**
@@ -133,62 +275,73 @@ namespace detail::async {
          *
          */
         std::coroutine_handle<> continuation = nullptr;
-
-        /**
-         * @brief We use a shared state to allow tracking coroutine that moving across threads.
-         */
-        weak_ptr<state_type, true> coroutine_state_value;
     };
 
     template <typename Ret>
     struct coroutine<Ret>::promise_type : coroutine<Ret>::promise_base {
         coroutine<Ret> get_return_object() AVALANCHE_NOEXCEPT {
-            coroutine res { handle_type::from_promise(*this) };
-            this->coroutine_state_value = weak_ptr{res.m_state};
-            return res;
+            return coroutine{ handle_type::from_promise(*this) };
         }
 
         void return_value(Ret&& value) {
-            this->coroutine_state_value.lock().set_result(std::move(value));
+            this->set_result(std::move(value));
         }
     };
 
     template <>
     struct coroutine<void>::promise_type : coroutine<void>::promise_base {
         coroutine<void> get_return_object() AVALANCHE_NOEXCEPT {
-            coroutine res{ handle_type::from_promise(*this) };
-            this->coroutine_state_value = weak_ptr{res.m_state};
-            return res;
+            return coroutine{ handle_type::from_promise(*this) };
         }
 
-        static void return_void() {}
+        void return_void() {
+            this->set_result(true);
+        }
     };
 
     template <typename Ret>
     struct coroutine<Ret>::awaiter_type {
-        weak_ptr<state_type, true> awaiting_coroutine_state;
+        // The awaited coroutine object outlives the co_await expression, no need to hold a reference here
+        state_type* awaiting_coroutine_state;
 
         /**
-         * @brief Always returning false to step into `await_suspend()`
+         * @brief Skip suspending if the awaited coroutine has already finished (e.g. it was launched before)
          */
-        AVALANCHE_CONSTEXPR static bool await_ready() AVALANCHE_NOEXCEPT {
-            return false;
+        bool await_ready() const AVALANCHE_NOEXCEPT {
+            return awaiting_coroutine_state->is_ready();
         }
 
         /**
-         * @brief
+         * @brief A coroutine not launched yet runs on the executor and lane of the one awaiting it.
          * @param parent_handle The handle of coroutine awaiting current `awaiter`
          * @return true to suspend handle, false to resume handle
          */
-        decltype(auto) await_suspend(std::coroutine_handle<> parent_handle) AVALANCHE_NOEXCEPT {
-            auto state = awaiting_coroutine_state.lock();
+        template <typename ParentPromise>
+        decltype(auto) await_suspend(std::coroutine_handle<ParentPromise> parent_handle) AVALANCHE_NOEXCEPT {
+            state_type* state = awaiting_coroutine_state;
+            if constexpr (std::is_base_of_v<promise_state_base, ParentPromise>) {
+                if (!state->is_scheduled()) {
+                    const promise_state_base& parent = parent_handle.promise();
+                    state->set_executor(parent.get_executor());
+                    state->set_priority(parent.get_priority());
+                }
+            }
             handle_type awaiting_handle = state->get_handle();
             auto& promise = awaiting_handle.promise();
             promise.continuation = parent_handle;  // Set awaiting coroutine's continuation to parent scope handle
 
-            state->submit_to_executor(state);
+            state->schedule();
 
-            return !state->is_ready();
+            // If the awaited coroutine finished before we arrived, it won't resume us, so don't suspend.
+            // Otherwise it will transfer to `parent_handle` from its final awaiter.
+            if (!state->arrive_at_continuation_handshake()) {
+                return true;
+            }
+            // Taken by a fan-out awaitable which has already resumed without this coroutine, wait for it once more
+            if (state->get_completion_listener() != nullptr) {
+                return !state->arrive_at_late_continuation_handshake();
+            }
+            return false;
         }
 
         decltype(auto) await_resume() AVALANCHE_NOEXCEPT {
@@ -198,111 +351,102 @@ namespace detail::async {
 
     template <typename Ret>
     struct coroutine<Ret>::final_awaiter {
-        weak_ptr<state_type, true> awaiting_coroutine_state;
-
         AVALANCHE_CONSTEXPR static bool await_ready() AVALANCHE_NOEXCEPT {
             return false;
         }
 
-        decltype(auto) await_suspend(std::coroutine_handle<> current_handle) AVALANCHE_NOEXCEPT {
-            auto state = awaiting_coroutine_state.lock();
-            handle_type awaiting_handle = state->get_handle();
-            auto& promise = awaiting_handle.promise();
-
-            if (state->set_ready()) {
-                if (promise.continuation) {
-                    promise.continuation.resume();
+        /**
+         * @brief Symmetric transfer to the continuation, so that a long await chain won't grow the native stack.
+         */
+        std::coroutine_handle<> await_suspend(handle_type current_handle) AVALANCHE_NOEXCEPT {
+            auto& promise = current_handle.promise();
+
+            std::coroutine_handle<> next = std::noop_coroutine();
+            promise.set_ready();
+            // The continuation is only readable once the awaiter has arrived
+            if (promise.arrive_at_continuation_handshake()) {
+                if (completion_listener* listener = promise.get_completion_listener()) {
+                    next = listener->on_completed(promise);
+                    // The listener only resumes its own awaiting coroutine, one awaiting us afterwards (e.g. a `when_any`
+                    // loser) is resumed from here. It can't also be the listener's, which is resumed by then.
+                    if (promise.arrive_at_late_continuation_handshake()) {
+                        next = promise.continuation;
+                    }
+                } else {
+                    next = promise.continuation;
                 }
             }
+            // Paired with `schedule()`, the frame might be destroyed here so don't touch it anymore
+            promise.release_reference();
+            return next;
         }
 
         void await_resume() AVALANCHE_NOEXCEPT {}
     };
     /////////////////////////
 
-    /////////////////////////
 
-    template <typename T>
-    struct bool_if_void_else_type {
-        using type = T;
-        using ret = const T&;
-    };
-
-    template <>
-    struct bool_if_void_else_type<void> {
-        using type = bool;
-        using ret = bool;
-    };
-
-    template <typename Ret>
-    class coroutine_state : public promise_state_base {
-    public:
-        using promise_type = typename coroutine<Ret>::promise_type;
-        using handle_type = std::coroutine_handle<promise_type>;
-
-        explicit coroutine_state(handle_type handle)
-            : m_handle(handle)
-            , m_is_ready(false)
-            , m_executor(threaded_coroutine_executor::get_global_executor())
-        {}
-
-        ~coroutine_state() override {
-            if (m_handle) {
-                m_handle.destroy();
-            }
-        }
-
-        handle_type get_handle() {
-            return m_handle;
-        }
-
-        std::coroutine_handle<> get_erased_handle() override {
-            return m_handle;
-        }
+}
 
-        bool set_ready() override {
-            return m_is_ready.exchange(true, std::memory_order_acq_rel);
-        }
+    template <typename T>
+    using async = detail::async::coroutine<T>;
 
-        bool done() override {
-            return m_handle.done();
-        }
+    template <typename T>
+    void launch(T&& in) {
+        in->schedule();
+    }
 
-        void resume() override {
-            m_handle.resume();
+    /**
+     * @brief Launch on the given executor and lane, which the coroutines it awaits inherit unless launched elsewhere.
+     */
+    template <typename T>
+    void launch(T&& in, coroutine_executor_base& executor, const task_priority priority = task_priority::normal) {
+        if (!in->is_scheduled()) {
+            in->set_executor(&executor);
+            in->set_priority(priority);
         }
+        in->schedule();
+    }
 
-        bool is_ready() override {
-            return m_is_ready.load(std::memory_order_acquire);
+    template <typename T>
+    void launch(T&& in, const task_priority priority) {
+        if (!in->is_scheduled()) {
+            in->set_priority(priority);
         }
+        in->schedule();
+    }
 
-        void set_result(typename bool_if_void_else_type<Ret>::type &&result) { m_coroutine_result = std::move(result); }
+    /**
+     * @brief `co_await resume_on(executor)` continues the awaiting coroutine on `executor`, in the lane of `priority` if
+     * given, otherwise keeping its own.
+     *
+     * @code
+     * async<void> upload(texture_data data) {
+     *     co_await decompress(data);
+     *     co_await resume_on(main_thread_executor::get_global_executor());
+     *     // On the main thread from here on
+     * }
+     * @endcode
+     */
+    struct resume_on {
+        coroutine_executor_base& executor;
+        optional<task_priority> priority{};
 
-        typename bool_if_void_else_type<Ret>::ret get_result() {
-            return m_coroutine_result.value();
+        AVALANCHE_CONSTEXPR static bool await_ready() AVALANCHE_NOEXCEPT {
+            return false;
         }
 
-        void submit_to_executor(shared_ptr<promise_state_base, true> task) const AVALANCHE_NOEXCEPT {
-            m_executor.push_coroutine(std::move(task));
+        template <typename Promise>
+        requires std::is_base_of_v<promise_state_base, Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle) const {
+            Promise& promise = handle.promise();
+            promise.set_executor(&executor);
+            promise.set_priority(priority.value_or(promise.get_priority()));
+            // Might be resumed by another thread right away, don't touch the frame after pushing
+            executor.push_coroutine(coroutine_executor_base::coroutine_handle(&promise));
         }
 
-    private:
-        handle_type m_handle;
-        std::atomic<bool> m_is_ready;
-        optional<typename bool_if_void_else_type<Ret>::type> m_coroutine_result{};
-        coroutine_executor_base& m_executor;
+        void await_resume() AVALANCHE_NOEXCEPT {}
     };
-    /////////////////////////
-
-
-}
-
-    template <typename T>
-    using async = detail::async::coroutine<T>;
-
-    template <typename T>
-    void launch(T&& in) {
-        in->submit_to_executor(in.get_state().template clone<promise_state_base>());
-    }
 
 }
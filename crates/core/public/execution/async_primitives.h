@@ -0,0 +1,391 @@
+#pragma once
+
+#include "polyfill.h"
+#include "logger.h"
+#include "execution/executor.h"
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+
+namespace avalanche::core::execution {
+
+namespace detail::async {
+
+    /**
+     * @brief A suspended coroutine queued on a synchronization primitive, lives in the frame of the coroutine.
+     */
+    struct async_waiter {
+        promise_state_base* promise = nullptr;
+        async_waiter* next = nullptr;
+    };
+
+    template <typename Promise>
+    concept executor_bound_promise = std::is_base_of_v<promise_state_base, Promise>;
+
+    /**
+     * @brief Push a waiter back to the executor it was running on, instead of resuming it on the releasing thread.
+     *
+     * The waiter might be destroyed as soon as it is pushed.
+     */
+    inline void resume_waiter(promise_state_base& promise) {
+        promise.get_executor()->push_coroutine(coroutine_executor_base::coroutine_handle(&promise));
+    }
+
+    /**
+     * @brief Resume every waiter of a LIFO list, in the order they arrived.
+     */
+    inline void resume_waiters(async_waiter* head) {
+        async_waiter* reversed = nullptr;
+        while (head != nullptr) {
+            async_waiter* next = head->next;
+            head->next = reversed;
+            reversed = head;
+            head = next;
+        }
+        while (reversed != nullptr) {
+            // Read before resuming, the waiter goes away with its frame
+            async_waiter* next = reversed->next;
+            resume_waiter(*reversed->promise);
+            reversed = next;
+        }
+    }
+
+}
+
+    class async_mutex;
+
+    /**
+     * @brief Owns a locked `async_mutex`, unlocks it on destruction.
+     */
+    class async_mutex_lock {
+    public:
+        explicit async_mutex_lock(async_mutex& mutex, std::adopt_lock_t) AVALANCHE_NOEXCEPT : m_mutex(&mutex) {}
+
+        async_mutex_lock(async_mutex_lock&& other) AVALANCHE_NOEXCEPT : m_mutex(std::exchange(other.m_mutex, nullptr)) {}
+
+        async_mutex_lock(const async_mutex_lock&) = delete;
+        async_mutex_lock& operator=(const async_mutex_lock&) = delete;
+        async_mutex_lock& operator=(async_mutex_lock&&) = delete;
+
+        inline ~async_mutex_lock();
+
+    private:
+        async_mutex* m_mutex;
+    };
+
+    /**
+     * @brief Mutex suspending the awaiting coroutine instead of blocking its worker.
+     *
+     * Locking and unlocking without contention is a single CAS. The lock is handed over to waiters in FIFO order, a
+     * waiter is resumed on its own executor.
+     *
+     * @code
+     * async<void> append(async_mutex& mutex, vector<int>& out, int value) {
+     *     const auto lock = co_await mutex.scoped_lock_async();
+     *     out.push_back(value);
+     * }
+     * @endcode
+     */
+    class async_mutex {
+    public:
+        async_mutex() = default;
+
+        async_mutex(const async_mutex&) = delete;
+        async_mutex& operator=(const async_mutex&) = delete;
+
+        ~async_mutex() {
+            AVALANCHE_CHECK(m_state.load(std::memory_order_relaxed) == not_locked && m_waiters == nullptr, "async_mutex destroyed while locked");
+        }
+
+        AVALANCHE_NO_DISCARD bool try_lock() AVALANCHE_NOEXCEPT {
+            std::uintptr_t expected = not_locked;
+            return m_state.compare_exchange_strong(expected, locked_no_waiters, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        class lock_awaiter {
+        public:
+            explicit lock_awaiter(async_mutex& mutex) AVALANCHE_NOEXCEPT : m_mutex(mutex) {}
+
+            bool await_ready() AVALANCHE_NOEXCEPT {
+                return m_mutex.try_lock();
+            }
+
+            /**
+             * @return false if the lock was acquired meanwhile
+             */
+            template <detail::async::executor_bound_promise Promise>
+            bool await_suspend(std::coroutine_handle<Promise> handle) AVALANCHE_NOEXCEPT {
+                m_waiter.promise = &handle.promise();
+                std::uintptr_t old_state = m_mutex.m_state.load(std::memory_order_acquire);
+                while (true) {
+                    if (old_state == not_locked) {
+                        if (m_mutex.m_state.compare_exchange_weak(old_state, locked_no_waiters, std::memory_order_acquire, std::memory_order_relaxed)) {
+                            return false;
+                        }
+                    } else {
+                        m_waiter.next = reinterpret_cast<detail::async::async_waiter*>(old_state);
+                        // Might be resumed by the unlocking thread right away, don't touch the frame afterward
+                        if (m_mutex.m_state.compare_exchange_weak(old_state, reinterpret_cast<std::uintptr_t>(&m_waiter), std::memory_order_release, std::memory_order_relaxed)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            void await_resume() AVALANCHE_NOEXCEPT {}
+
+        protected:
+            async_mutex& m_mutex;
+            detail::async::async_waiter m_waiter{};
+        };
+
+        class scoped_lock_awaiter : public lock_awaiter {
+        public:
+            using lock_awaiter::lock_awaiter;
+
+            AVALANCHE_NO_DISCARD async_mutex_lock await_resume() AVALANCHE_NOEXCEPT {
+                return async_mutex_lock(m_mutex, std::adopt_lock);
+            }
+        };
+
+        /**
+         * @brief `co_await` it to lock the mutex, `unlock()` must be called afterward.
+         */
+        AVALANCHE_NO_DISCARD lock_awaiter lock_async() AVALANCHE_NOEXCEPT {
+            return lock_awaiter(*this);
+        }
+
+        /**
+         * @brief `co_await` it to lock the mutex, resulting a guard unlocking it on destruction.
+         */
+        AVALANCHE_NO_DISCARD scoped_lock_awaiter scoped_lock_async() AVALANCHE_NOEXCEPT {
+            return scoped_lock_awaiter(*this);
+        }
+
+        /**
+         * @brief Hand the lock over to the earliest waiter, or unlock if there is none.
+         */
+        void unlock() {
+            detail::async::async_waiter* head = m_waiters;
+            if (head == nullptr) {
+                std::uintptr_t old_state = locked_no_waiters;
+                if (m_state.compare_exchange_strong(old_state, not_locked, std::memory_order_release, std::memory_order_relaxed)) {
+                    return;
+                }
+                // New waiters arrived, take them over into the FIFO list only accessed by the owner
+                old_state = m_state.exchange(locked_no_waiters, std::memory_order_acquire);
+                auto* waiter = reinterpret_cast<detail::async::async_waiter*>(old_state);
+                while (waiter != nullptr) {
+                    detail::async::async_waiter* next = waiter->next;
+                    waiter->next = head;
+                    head = waiter;
+                    waiter = next;
+                }
+            }
+            m_waiters = head->next;
+            detail::async::resume_waiter(*head->promise);
+        }
+
+    private:
+        // Any other state is the head of a LIFO list of waiters pushed since the owner last took them over
+        static constexpr std::uintptr_t not_locked = 1;
+        static constexpr std::uintptr_t locked_no_waiters = 0;
+
+        std::atomic<std::uintptr_t> m_state{not_locked};
+        // Waiters in FIFO order, only accessed by the owner of the lock
+        detail::async::async_waiter* m_waiters = nullptr;
+    };
+
+    async_mutex_lock::~async_mutex_lock() {
+        if (m_mutex != nullptr) {
+            m_mutex->unlock();
+        }
+    }
+
+    /**
+     * @brief Single use countdown, coroutines awaiting it are resumed once it reached zero.
+     */
+    class async_latch {
+    public:
+        using count_type = std::ptrdiff_t;
+
+        explicit async_latch(const count_type count) AVALANCHE_NOEXCEPT
+            : m_count(count)
+            , m_state(count > 0 ? no_waiters : ready)
+        {}
+
+        async_latch(const async_latch&) = delete;
+        async_latch& operator=(const async_latch&) = delete;
+
+        void count_down(const count_type n = 1) {
+            if (m_count.fetch_sub(n, std::memory_order_acq_rel) == n) {
+                const std::uintptr_t old_state = m_state.exchange(ready, std::memory_order_acq_rel);
+                detail::async::resume_waiters(reinterpret_cast<detail::async::async_waiter*>(old_state));
+            }
+        }
+
+        AVALANCHE_NO_DISCARD bool is_ready() const AVALANCHE_NOEXCEPT {
+            return m_state.load(std::memory_order_acquire) == ready;
+        }
+
+        class wait_awaiter {
+        public:
+            explicit wait_awaiter(async_latch& latch) AVALANCHE_NOEXCEPT : m_latch(latch) {}
+
+            bool await_ready() const AVALANCHE_NOEXCEPT {
+                return m_latch.is_ready();
+            }
+
+            template <detail::async::executor_bound_promise Promise>
+            bool await_suspend(std::coroutine_handle<Promise> handle) AVALANCHE_NOEXCEPT {
+                m_waiter.promise = &handle.promise();
+                std::uintptr_t old_state = m_latch.m_state.load(std::memory_order_acquire);
+                do {
+                    if (old_state == ready) {
+                        return false;
+                    }
+                    m_waiter.next = reinterpret_cast<detail::async::async_waiter*>(old_state);
+                } while (!m_latch.m_state.compare_exchange_weak(old_state, reinterpret_cast<std::uintptr_t>(&m_waiter), std::memory_order_release, std::memory_order_acquire));
+                return true;
+            }
+
+            void await_resume() const AVALANCHE_NOEXCEPT {}
+
+        private:
+            async_latch& m_latch;
+            detail::async::async_waiter m_waiter{};
+        };
+
+        /**
+         * @brief `co_await` it to suspend until the count reached zero.
+         */
+        AVALANCHE_NO_DISCARD wait_awaiter wait_async() AVALANCHE_NOEXCEPT {
+            return wait_awaiter(*this);
+        }
+
+    private:
+        // Any other state is the head of a LIFO list of waiters
+        static constexpr std::uintptr_t ready = 1;
+        static constexpr std::uintptr_t no_waiters = 0;
+
+        std::atomic<count_type> m_count;
+        std::atomic<std::uintptr_t> m_state;
+    };
+
+    /**
+     * @brief Counting semaphore suspending the awaiting coroutine while no permit is available.
+     *
+     * Acquiring and releasing are a single atomic operation as long as nobody has to wait, only the slow path takes a
+     * lock, for a few instructions.
+     */
+    class async_semaphore {
+    public:
+        using count_type = std::ptrdiff_t;
+
+        explicit async_semaphore(const count_type initial_count) AVALANCHE_NOEXCEPT : m_count(initial_count) {}
+
+        async_semaphore(const async_semaphore&) = delete;
+        async_semaphore& operator=(const async_semaphore&) = delete;
+
+        AVALANCHE_NO_DISCARD bool try_acquire() AVALANCHE_NOEXCEPT {
+            count_type count = m_count.load(std::memory_order_relaxed);
+            while (count > 0) {
+                if (m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void release(count_type n = 1) {
+            // A negative count is the number of coroutines which are, or about to be, waiting
+            const count_type old_count = m_count.fetch_add(n, std::memory_order_release);
+            count_type num_to_wake = old_count < 0 ? std::min(n, -old_count) : 0;
+            if (num_to_wake == 0) {
+                return;
+            }
+
+            detail::async::async_waiter* woken = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (; num_to_wake > 0 && m_head != nullptr; --num_to_wake) {
+                    detail::async::async_waiter* waiter = m_head;
+                    m_head = waiter->next;
+                    if (m_head == nullptr) {
+                        m_tail = nullptr;
+                    }
+                    waiter->next = woken;
+                    woken = waiter;
+                }
+                // The rest haven't enqueued themselves yet, they take their permits on arrival
+                m_num_pending_permits += num_to_wake;
+            }
+            detail::async::resume_waiters(woken);
+        }
+
+        class acquire_awaiter {
+        public:
+            explicit acquire_awaiter(async_semaphore& semaphore) AVALANCHE_NOEXCEPT : m_semaphore(semaphore) {}
+
+            bool await_ready() const AVALANCHE_NOEXCEPT {
+                // Take a permit or a place in the queue
+                return m_semaphore.m_count.fetch_sub(1, std::memory_order_acquire) > 0;
+            }
+
+            /**
+             * @return false if a permit was released before we got enqueued
+             */
+            template <detail::async::executor_bound_promise Promise>
+            bool await_suspend(std::coroutine_handle<Promise> handle) {
+                m_waiter.promise = &handle.promise();
+                std::lock_guard<std::mutex> lock(m_semaphore.m_mutex);
+                if (m_semaphore.m_num_pending_permits > 0) {
+                    --m_semaphore.m_num_pending_permits;
+                    return false;
+                }
+                if (m_semaphore.m_tail != nullptr) {
+                    m_semaphore.m_tail->next = &m_waiter;
+                } else {
+                    m_semaphore.m_head = &m_waiter;
+                }
+                m_semaphore.m_tail = &m_waiter;
+                return true;
+            }
+
+            void await_resume() const AVALANCHE_NOEXCEPT {}
+
+        private:
+            async_semaphore& m_semaphore;
+            detail::async::async_waiter m_waiter{};
+        };
+
+        /**
+         * @brief `co_await` it to take a permit, `release()` must be called afterward.
+         */
+        AVALANCHE_NO_DISCARD acquire_awaiter acquire_async() AVALANCHE_NOEXCEPT {
+            return acquire_awaiter(*this);
+        }
+
+        /**
+         * @brief Permits available, negative if coroutines are waiting.
+         */
+        AVALANCHE_NO_DISCARD count_type get_count() const AVALANCHE_NOEXCEPT {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<count_type> m_count;
+
+        std::mutex m_mutex{};
+        // FIFO list of waiters
+        detail::async::async_waiter* m_head = nullptr;
+        detail::async::async_waiter* m_tail = nullptr;
+        count_type m_num_pending_permits = 0;
+    };
+
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "polyfill.h"
+#include "execution/async_coroutine.h"
+#include "execution/async_primitives.h"
+#include "execution/executor.h"
+#include "manager/tick_manager.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+
+
+namespace avalanche::core::execution {
+
+    using timer_clock = threaded_coroutine_executor::clock_type;
+
+    /**
+     * @brief `co_await sleep_until(deadline)` suspends the coroutine without blocking its worker.
+     *
+     * The coroutine is resumed on its own executor, in millisecond resolution.
+     */
+    struct sleep_until {
+        timer_clock::time_point deadline;
+
+        bool await_ready() const AVALANCHE_NOEXCEPT {
+            return timer_clock::now() >= deadline;
+        }
+
+        template <detail::async::executor_bound_promise Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle) const {
+            // Might be resumed by a worker right away, don't touch the frame afterward
+            threaded_coroutine_executor::get_global_executor().push_coroutine_at(coroutine_executor_base::coroutine_handle(&handle.promise()), deadline);
+        }
+
+        void await_resume() const AVALANCHE_NOEXCEPT {}
+    };
+
+    template <typename Rep, typename Period>
+    sleep_until sleep_for(const std::chrono::duration<Rep, Period> duration) {
+        return sleep_until{ timer_clock::now() + std::chrono::ceil<timer_clock::duration>(duration) };
+    }
+
+    /**
+     * @brief `co_await next_frame()` resumes the coroutine on its own executor at the beginning of the next
+     * `ITickManager::tick_frame()`.
+     */
+    struct next_frame {
+        AVALANCHE_CONSTEXPR static bool await_ready() AVALANCHE_NOEXCEPT {
+            return false;
+        }
+
+        template <detail::async::executor_bound_promise Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle) const {
+            ITickManager::get().resume_on_next_frame(handle.promise());
+        }
+
+        void await_resume() const AVALANCHE_NOEXCEPT {}
+    };
+
+namespace detail::async {
+
+    /**
+     * @brief A task and a timer racing to resume the awaiting coroutine of `with_timeout`.
+     *
+     * Owned by both of them, freed by the later one.
+     */
+    class timeout_race final : public completion_listener {
+    public:
+        timeout_race(promise_state_base& awaiting, bool& is_completed) AVALANCHE_NOEXCEPT
+            : m_awaiting(awaiting)
+            , m_is_completed(is_completed)
+        {}
+
+        std::coroutine_handle<> on_completed(promise_state_base&) AVALANCHE_NOEXCEPT override {
+            std::coroutine_handle<> next = std::noop_coroutine();
+            if (try_win()) {
+                m_is_completed = true;
+                next = m_awaiting.get_erased_handle();
+            }
+            release();
+            return next;
+        }
+
+        void on_timer_expired() {
+            if (try_win()) {
+                m_is_completed = false;
+                resume_waiter(m_awaiting);
+            }
+            release();
+        }
+
+        /**
+         * @brief Only the winner may touch the awaiting coroutine, which is gone once resumed.
+         */
+        bool try_win() AVALANCHE_NOEXCEPT {
+            return !m_is_decided.exchange(true, std::memory_order_acq_rel);
+        }
+
+        void release() AVALANCHE_NOEXCEPT {
+            if (m_num_owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+    private:
+        promise_state_base& m_awaiting;
+        bool& m_is_completed;
+        std::atomic<bool> m_is_decided{false};
+        std::atomic<uint32_t> m_num_owners{2};
+    };
+
+    inline coroutine<void> expire_timeout_race(timeout_race* race, const timer_clock::time_point deadline) {
+        co_await sleep_until{ deadline };
+        race->on_timer_expired();
+    }
+
+    template <typename Ret>
+    class with_timeout_awaitable {
+    public:
+        with_timeout_awaitable(coroutine<Ret>& task, const timer_clock::time_point deadline)
+            : m_task(task.get_state())
+            , m_deadline(deadline)
+        {}
+
+        bool await_ready() const AVALANCHE_NOEXCEPT {
+            return m_task->is_ready();
+        }
+
+        template <executor_bound_promise Promise>
+        bool await_suspend(std::coroutine_handle<Promise> handle) {
+            auto* race = new timeout_race(handle.promise(), m_is_completed);
+            // The awaiting coroutine might be resumed as soon as the handshake is done, keep what we need on the stack
+            const timer_clock::time_point deadline = m_deadline;
+            coroutine_state<Ret>* task = m_task.get();
+
+            // Like awaiting it directly, a task not launched yet runs on the executor and lane of the awaiting coroutine
+            if (!task->is_scheduled()) {
+                const promise_state_base& parent = handle.promise();
+                task->set_executor(parent.get_executor());
+                task->set_priority(parent.get_priority());
+            }
+            task->set_completion_listener(race);
+            task->schedule();
+            if (task->arrive_at_continuation_handshake()) {
+                // Finished before we arrived, it won't notify the race
+                m_is_completed = true;
+                delete race;
+                return false;
+            }
+            launch(expire_timeout_race(race, deadline));
+            return true;
+        }
+
+        /**
+         * @return false if timed out
+         */
+        bool await_resume() const AVALANCHE_NOEXCEPT {
+            return m_is_completed;
+        }
+
+    private:
+        intrusive_ptr<coroutine_state<Ret>> m_task;
+        timer_clock::time_point m_deadline;
+        bool m_is_completed = false;
+    };
+
+}
+
+    /**
+     * @brief `co_await with_timeout(task, duration)` waits for `task` at most `duration`, resulting false if timed out.
+     *
+     * A timed out task keeps running and can't be awaited again, poll its `is_ready()` instead.
+     */
+    template <typename Ret, typename Rep, typename Period>
+    detail::async::with_timeout_awaitable<Ret> with_timeout(async<Ret>& task, const std::chrono::duration<Rep, Period> duration) {
+        return { task, timer_clock::now() + std::chrono::ceil<timer_clock::duration>(duration) };
+    }
+
+}
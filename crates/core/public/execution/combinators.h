@@ -0,0 +1,226 @@
+#pragma once
+
+#include "polyfill.h"
+#include "execution/async_coroutine.h"
+#include "execution/frame_allocator.h"
+#include "container/intrusive_ptr.hpp"
+#include <atomic>
+#include <coroutine>
+#include <iterator>
+#include <ranges>
+
+
+namespace avalanche::core::execution {
+
+namespace detail::async {
+
+    template <typename Range>
+    concept async_range = std::ranges::forward_range<Range> && requires(std::ranges::range_reference_t<Range> task) {
+        { task->schedule() };
+        { task->arrive_at_continuation_handshake() } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief Count down of a `when_all`, the awaiting coroutine holds one extra count until it has suspended.
+     */
+    class when_all_counter final : public completion_listener {
+    public:
+        using size_type = size_t;
+
+        explicit when_all_counter(const size_type num_tasks) : m_remaining(num_tasks + 1) {}
+
+        /**
+         * @brief Wait for more tasks, only callable by someone still holding a count (the awaiting coroutine or a task).
+         */
+        void expect(const size_type num_tasks) AVALANCHE_NOEXCEPT {
+            m_remaining.fetch_add(num_tasks, std::memory_order_relaxed);
+        }
+
+        /**
+         * @return true if the awaiting coroutine should suspend
+         */
+        bool try_suspend(std::coroutine_handle<> awaiting) AVALANCHE_NOEXCEPT {
+            m_awaiting = awaiting;
+            return m_remaining.fetch_sub(1, std::memory_order_acq_rel) > 1;
+        }
+
+        std::coroutine_handle<> arrive() AVALANCHE_NOEXCEPT {
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return m_awaiting;
+            }
+            return std::noop_coroutine();
+        }
+
+        std::coroutine_handle<> on_completed(promise_state_base&) AVALANCHE_NOEXCEPT override {
+            return arrive();
+        }
+
+    private:
+        std::atomic<size_type> m_remaining;
+        std::coroutine_handle<> m_awaiting = nullptr;
+    };
+
+    template <async_range Range>
+    class when_all_awaitable {
+    public:
+        explicit when_all_awaitable(Range& tasks)
+            : m_tasks(tasks)
+            , m_counter(static_cast<size_t>(std::ranges::distance(tasks)))
+        {}
+
+        when_all_awaitable(const when_all_awaitable&) = delete;
+        when_all_awaitable& operator=(const when_all_awaitable&) = delete;
+
+        bool await_ready() const AVALANCHE_NOEXCEPT {
+            return std::ranges::empty(m_tasks);
+        }
+
+        /**
+         * @brief Submit every task before suspending, so they could run in parallel on the executor.
+         */
+        bool await_suspend(std::coroutine_handle<> parent_handle) AVALANCHE_NOEXCEPT {
+            for (auto&& task : m_tasks) {
+                task->set_completion_listener(&m_counter);
+                task->schedule();
+                if (task->arrive_at_continuation_handshake()) {
+                    // Finished before we arrived, it won't notify us. The counter never reaches zero here as we are still holding one.
+                    AVALANCHE_MAYBE_UNUSED const auto handle = m_counter.arrive();
+                }
+            }
+            return m_counter.try_suspend(parent_handle);
+        }
+
+        static void await_resume() AVALANCHE_NOEXCEPT {}
+
+    private:
+        Range& m_tasks;
+        when_all_counter m_counter;
+    };
+
+    /**
+     * @brief Shared by the `when_any` awaitable and every task of it, as losers keep running after the winner resumed the
+     * awaiting coroutine.
+     */
+    class when_any_state final : public completion_listener, public pooled_frame {
+    public:
+        void add_reference() AVALANCHE_NOEXCEPT {
+            m_reference_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release_reference() AVALANCHE_NOEXCEPT {
+            if (m_reference_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        bool try_suspend(std::coroutine_handle<> awaiting) AVALANCHE_NOEXCEPT {
+            m_awaiting = awaiting;
+            return m_remaining.fetch_sub(1, std::memory_order_acq_rel) > 1;
+        }
+
+        std::coroutine_handle<> on_completed(promise_state_base& completed) AVALANCHE_NOEXCEPT override {
+            std::coroutine_handle<> next = std::noop_coroutine();
+            promise_state_base* expected = nullptr;
+            if (m_winner.compare_exchange_strong(expected, &completed, std::memory_order_acq_rel)) {
+                if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    next = m_awaiting;
+                }
+            }
+            // Paired with the reference added while registering the task
+            release_reference();
+            return next;
+        }
+
+        AVALANCHE_NO_DISCARD promise_state_base* winner() const AVALANCHE_NOEXCEPT {
+            return m_winner.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<uint32_t> m_reference_count{0};
+        // One for the winner and one for the awaiting coroutine
+        std::atomic<uint32_t> m_remaining{2};
+        std::atomic<promise_state_base*> m_winner{nullptr};
+        std::coroutine_handle<> m_awaiting = nullptr;
+    };
+
+    template <async_range Range>
+    class when_any_awaitable {
+    public:
+        using size_type = size_t;
+
+        explicit when_any_awaitable(Range& tasks)
+            : m_tasks(tasks)
+            , m_state(new when_any_state())
+        {
+            AVALANCHE_CHECK(!std::ranges::empty(tasks), "when_any() requires at least one task");
+        }
+
+        when_any_awaitable(const when_any_awaitable&) = delete;
+        when_any_awaitable& operator=(const when_any_awaitable&) = delete;
+
+        static constexpr bool await_ready() AVALANCHE_NOEXCEPT {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> parent_handle) AVALANCHE_NOEXCEPT {
+            for (auto&& task : m_tasks) {
+                m_state->add_reference();
+                task->set_completion_listener(m_state.get());
+                task->schedule();
+                if (task->arrive_at_continuation_handshake()) {
+                    AVALANCHE_MAYBE_UNUSED const auto handle = m_state->on_completed(*task.operator->());
+                }
+            }
+            return m_state->try_suspend(parent_handle);
+        }
+
+        /**
+         * @return Index of the first finished task in the range
+         */
+        size_type await_resume() const AVALANCHE_NOEXCEPT {
+            const promise_state_base* winner = m_state->winner();
+            size_type index = 0;
+            for (auto&& task : m_tasks) {
+                if (static_cast<const promise_state_base*>(task.operator->()) == winner) {
+                    return index;
+                }
+                ++index;
+            }
+            return index;
+        }
+
+    private:
+        Range& m_tasks;
+        intrusive_ptr<when_any_state> m_state;
+    };
+
+}
+
+    /**
+     * @brief Await all `async<T>` in the range, they are submitted to the executor at once.
+     *
+     * @code
+     * vector<async<int>> tasks = ...;
+     * co_await when_all(tasks);
+     * for (auto& task : tasks) { task->get_result(); }
+     * @endcode
+     *
+     * Every task could only be awaited once, and the range must outlive the `co_await` expression.
+     */
+    template <detail::async::async_range Range>
+    detail::async::when_all_awaitable<Range> when_all(Range& tasks) {
+        return detail::async::when_all_awaitable<Range>(tasks);
+    }
+
+    /**
+     * @brief Await the first finished `async<T>` in the range, resulting its index.
+     *
+     * Other tasks keep running in background after the awaiting coroutine resumed, each of them could still be awaited
+     * once afterwards to wait for its result.
+     */
+    template <detail::async::async_range Range>
+    detail::async::when_any_awaitable<Range> when_any(Range& tasks) {
+        return detail::async::when_any_awaitable<Range>(tasks);
+    }
+
+}
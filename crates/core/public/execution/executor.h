@@ -1,17 +1,89 @@
 #pragma once
 
 #include "avalanche_core_export.h"
-#include "container/shared_ptr.hpp"
+#include "container/intrusive_ptr.hpp"
+#include "execution/executor_stats.h"
 #include "polyfill.h"
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <coroutine>
 
 namespace avalanche::core::execution {
 
+    class coroutine_executor_base;
+
+    /**
+     * @brief Lanes of a threaded executor, a worker always picks from the highest non-empty one.
+     */
+    enum class task_priority : uint8_t {
+        // Frame critical work, e.g. ticking and culling
+        high,
+        normal,
+        // Long running work such as asset decompression, never occupies every worker
+        background,
+    };
+
+    constexpr size_t num_task_priorities = 3;
+
+    /**
+     * @brief Type-erased coroutine state living inside the coroutine frame.
+     *
+     * The state is reference counted intrusively, the frame is destroyed when the last reference dropped.
+     */
     class promise_state_base {
     public:
+        using reference_count_type = uint32_t;
+
         AVALANCHE_CORE_API virtual ~promise_state_base() = default;
 
+        void add_reference() AVALANCHE_NOEXCEPT {
+            m_reference_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release_reference() AVALANCHE_NOEXCEPT {
+            if (m_reference_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                destroy();
+            }
+        }
+
+        AVALANCHE_NO_DISCARD reference_count_type reference_count() const AVALANCHE_NOEXCEPT {
+            return m_reference_count.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Time of the last push to an executor in nanoseconds, published to the worker along with the handle.
+         */
+        void set_enqueue_timestamp(const uint64_t timestamp) AVALANCHE_NOEXCEPT {
+            m_enqueue_timestamp = timestamp;
+        }
+
+        AVALANCHE_NO_DISCARD uint64_t get_enqueue_timestamp() const AVALANCHE_NOEXCEPT {
+            return m_enqueue_timestamp;
+        }
+
+        /**
+         * @brief The executor resuming this coroutine, must not be changed while it is queued.
+         */
+        void set_executor(coroutine_executor_base* executor) AVALANCHE_NOEXCEPT {
+            m_executor = executor;
+        }
+
+        AVALANCHE_NO_DISCARD coroutine_executor_base* get_executor() const AVALANCHE_NOEXCEPT {
+            return m_executor;
+        }
+
+        /**
+         * @brief Lane of this coroutine in its executor, must not be changed while it is queued.
+         */
+        void set_priority(const task_priority priority) AVALANCHE_NOEXCEPT {
+            m_priority = priority;
+        }
+
+        AVALANCHE_NO_DISCARD task_priority get_priority() const AVALANCHE_NOEXCEPT {
+            return m_priority;
+        }
+
         AVALANCHE_CORE_INTERNAL virtual std::coroutine_handle<> get_erased_handle() = 0;
 
         AVALANCHE_CORE_INTERNAL virtual bool set_ready() = 0;
@@ -21,11 +93,23 @@ namespace avalanche::core::execution {
         AVALANCHE_CORE_INTERNAL virtual void resume() = 0;
 
         AVALANCHE_CORE_INTERNAL AVALANCHE_NO_DISCARD virtual bool is_ready() = 0;
+
+    protected:
+        /**
+         * @brief Invoked once the last reference dropped, normally destroys the coroutine frame owning this state.
+         */
+        AVALANCHE_CORE_INTERNAL virtual void destroy() = 0;
+
+    private:
+        std::atomic<reference_count_type> m_reference_count{0};
+        uint64_t m_enqueue_timestamp = 0;
+        coroutine_executor_base* m_executor = nullptr;
+        task_priority m_priority = task_priority::normal;
     };
 
     class AVALANCHE_CORE_API coroutine_executor_base {
     public:
-        using coroutine_handle = shared_ptr<promise_state_base, true>;
+        using coroutine_handle = intrusive_ptr<promise_state_base>;
         using size_type = size_t;
 
         virtual ~coroutine_executor_base();
@@ -37,26 +121,118 @@ namespace avalanche::core::execution {
 
     class AVALANCHE_CORE_API sync_coroutine_executor : public coroutine_executor_base {
     public:
-        using coroutine_handle = shared_ptr<promise_state_base, true>;
+        using coroutine_handle = intrusive_ptr<promise_state_base>;
 
         void push_coroutine(coroutine_handle handle) override;
 
         static sync_coroutine_executor& get_global_executor();
     };
 
+    /**
+     * @brief Queue of coroutines which only run when the owning thread drains it, e.g. the main thread once per frame.
+     *
+     * Used for work bound to a thread, such as touching the window or submitting to the render device.
+     */
+    class AVALANCHE_CORE_API main_thread_executor : public coroutine_executor_base {
+    public:
+        using coroutine_handle = intrusive_ptr<promise_state_base>;
+
+        main_thread_executor();
+        ~main_thread_executor() override;
+
+        void push_coroutine(coroutine_handle handle) override;
+
+        /**
+         * @brief Resume the coroutines queued so far on calling thread, the ones they queue wait for the next call.
+         * @return Number of coroutines resumed
+         */
+        size_type drain();
+
+        AVALANCHE_NO_DISCARD bool is_empty() const;
+
+        /**
+         * @brief Drained by `ITickManager::tick_frame()` at the beginning of each frame.
+         */
+        static main_thread_executor& get_global_executor();
+
+    private:
+        struct impl;
+        impl* m_impl_;
+    };
+
+    /**
+     * @brief CPU pinning of the workers of a `threaded_coroutine_executor`, nothing is pinned if `cpu_set` is empty.
+     */
+    struct worker_affinity {
+        // Logical CPU indices
+        vector<uint32_t> cpu_set{};
+        // Pin worker i to `cpu_set[i % size]`, otherwise every worker is allowed to run on the whole set
+        bool pin_each_worker = true;
+    };
+
+    /**
+     * @brief Work stealing executor with a lane per `task_priority`.
+     *
+     * Background coroutines run on at most all but one worker, so high priority work never waits for a whole batch of
+     * them to finish.
+     */
     class AVALANCHE_CORE_API threaded_coroutine_executor : public coroutine_executor_base {
     public:
-        using coroutine_handle = shared_ptr<promise_state_base, true>;
+        using coroutine_handle = intrusive_ptr<promise_state_base>;
         using coroutine_executor_base::size_type;
+        using clock_type = std::chrono::steady_clock;
         static constexpr size_type default_thread_group_size = 4;
+        static constexpr size_type invalid_worker_index = static_cast<size_type>(-1);
 
-        explicit threaded_coroutine_executor(size_type num_threads = default_thread_group_size);
+        explicit threaded_coroutine_executor(size_type num_threads = default_thread_group_size, const worker_affinity& affinity = {});
         ~threaded_coroutine_executor() override;
 
+        /**
+         * @return true if no coroutine is queued or running
+         */
         AVALANCHE_NO_DISCARD bool is_empty();
         void terminate();
         void push_coroutine(coroutine_handle handle) override;
+
+        /**
+         * @brief Push `handle` to its own executor once `deadline` passed, in millisecond resolution.
+         *
+         * Timers are kept in a timing wheel driven by the idle workers of this executor, no thread is dedicated to them.
+         */
+        void push_coroutine_at(coroutine_handle handle, clock_type::time_point deadline);
+
+        /**
+         * @brief Block until no coroutine is queued or running, or the timeout (0 for none) expired.
+         *
+         * Coroutines suspended on an async primitive or a timer aren't waited for until they are resumed. Must not be
+         * called from a worker.
+         */
         void wait_for_all_jobs(size_type how_long_to_wait_ms) override;
+        AVALANCHE_NO_DISCARD size_type get_num_workers() const;
+
+        /**
+         * @brief Snapshot of per-worker counters and latency histograms, cheap enough to be always collected.
+         */
+        AVALANCHE_NO_DISCARD executor_stats get_stats() const;
+
+        void reset_stats();
+
+        /**
+         * @brief Dump `get_stats()` to the logger.
+         */
+        void log_stats() const;
+
+        /**
+         * @return Index of the worker running on calling thread, or `invalid_worker_index` if it isn't a worker
+         */
+        static size_type get_current_worker_index();
+
+        /**
+         * @brief Priority of the coroutine being resumed by calling thread, `task_priority::normal` outside of workers.
+         *
+         * Coroutines created meanwhile default to it, so the work spawned by a task stays in its lane.
+         */
+        static task_priority get_current_priority();
 
         static threaded_coroutine_executor& get_global_executor();
 
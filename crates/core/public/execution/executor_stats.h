@@ -0,0 +1,133 @@
+#pragma once
+
+#include "polyfill.h"
+#include "container/vector.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+
+namespace avalanche::core::execution {
+
+    /**
+     * @brief Log-linear histogram of durations in nanoseconds, in the spirit of HDR histogram.
+     *
+     * Every power of two range is split into `num_sub_buckets` linear buckets, so any recorded value is within 12.5% of
+     * its bucket bounds, across the whole uint64 range, with a fixed size of memory.
+     */
+    class latency_histogram {
+    public:
+        using value_type = uint64_t;
+        using count_type = uint64_t;
+        using size_type = size_t;
+
+        static constexpr size_type sub_bucket_bits = 3;
+        static constexpr size_type num_sub_buckets = 1 << sub_bucket_bits;
+        static constexpr size_type num_buckets = (64 - sub_bucket_bits + 1) * num_sub_buckets;
+
+        static constexpr size_type bucket_index_of(const value_type value) AVALANCHE_NOEXCEPT {
+            if (value < num_sub_buckets) {
+                return static_cast<size_type>(value);
+            }
+            const auto exponent = static_cast<size_type>(std::bit_width(value) - 1);
+            const auto sub_bucket = static_cast<size_type>(value >> (exponent - sub_bucket_bits)) & (num_sub_buckets - 1);
+            return (exponent - sub_bucket_bits + 1) * num_sub_buckets + sub_bucket;
+        }
+
+        static constexpr value_type bucket_lower_bound(const size_type index) AVALANCHE_NOEXCEPT {
+            if (index < num_sub_buckets) {
+                return index;
+            }
+            const size_type exponent = index / num_sub_buckets + sub_bucket_bits - 1;
+            const size_type sub_bucket = index % num_sub_buckets;
+            return static_cast<value_type>(num_sub_buckets + sub_bucket) << (exponent - sub_bucket_bits);
+        }
+
+        static constexpr value_type bucket_upper_bound(const size_type index) AVALANCHE_NOEXCEPT {
+            return index + 1 < num_buckets ? bucket_lower_bound(index + 1) - 1 : ~value_type{0};
+        }
+
+        void record(const value_type value, const count_type count = 1) AVALANCHE_NOEXCEPT {
+            m_counts[bucket_index_of(value)] += count;
+            m_total_count += count;
+        }
+
+        void merge(const latency_histogram& other) AVALANCHE_NOEXCEPT {
+            for (size_type i = 0; i < num_buckets; ++i) {
+                m_counts[i] += other.m_counts[i];
+            }
+            m_total_count += other.m_total_count;
+        }
+
+        AVALANCHE_NO_DISCARD count_type total_count() const AVALANCHE_NOEXCEPT {
+            return m_total_count;
+        }
+
+        AVALANCHE_NO_DISCARD count_type count_at(const size_type index) const AVALANCHE_NOEXCEPT {
+            return m_counts[index];
+        }
+
+        /**
+         * @return Upper bound of the bucket containing the given percentile in [0, 100], 0 if nothing recorded
+         */
+        AVALANCHE_NO_DISCARD value_type value_at_percentile(const double percentile) const AVALANCHE_NOEXCEPT {
+            if (m_total_count == 0) {
+                return 0;
+            }
+            const double clamped = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+            auto target = static_cast<count_type>(clamped / 100.0 * static_cast<double>(m_total_count) + 0.5);
+            target = target < 1 ? 1 : target;
+            count_type accumulated = 0;
+            for (size_type i = 0; i < num_buckets; ++i) {
+                accumulated += m_counts[i];
+                if (accumulated >= target) {
+                    return bucket_upper_bound(i);
+                }
+            }
+            return bucket_upper_bound(num_buckets - 1);
+        }
+
+        AVALANCHE_NO_DISCARD value_type max_value() const AVALANCHE_NOEXCEPT {
+            for (size_type i = num_buckets; i > 0; --i) {
+                if (m_counts[i - 1] > 0) {
+                    return bucket_upper_bound(i - 1);
+                }
+            }
+            return 0;
+        }
+
+    private:
+        std::array<count_type, num_buckets> m_counts{};
+        count_type m_total_count = 0;
+    };
+
+    /**
+     * @brief Counters of a worker since it started (or the last reset), durations are in nanoseconds.
+     */
+    struct executor_worker_stats {
+        uint64_t num_tasks_run = 0;
+        uint64_t num_steals = 0;
+        uint64_t num_wakeups = 0;
+        uint64_t idle_time = 0;
+        uint64_t busy_time = 0;
+        size_t queue_depth = 0;
+    };
+
+    /**
+     * @brief Snapshot of the telemetry of a threaded executor.
+     *
+     * Counters are written by workers without synchronization with the reader, a snapshot taken while running is
+     * approximate.
+     */
+    struct executor_stats {
+        vector<executor_worker_stats> workers{};
+        // From pushing a coroutine to a worker resuming it
+        latency_histogram schedule_latency{};
+        // Until a resumed coroutine suspended or finished
+        latency_histogram run_duration{};
+        size_t num_queued = 0;
+        size_t injection_queue_depth = 0;
+    };
+
+}
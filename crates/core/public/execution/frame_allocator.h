@@ -0,0 +1,119 @@
+#pragma once
+
+#include "avalanche_core_export.h"
+#include "polyfill.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace avalanche::core::execution {
+
+    class coroutine_arena;
+
+    struct frame_allocator_stats {
+        // Served from the thread local free lists
+        uint64_t pooled_allocations = 0;
+        // Served from a bound coroutine_arena
+        uint64_t arena_allocations = 0;
+        // Fallback to allocate_memory(), which should stay flat in steady state
+        uint64_t system_allocations = 0;
+        uint64_t system_deallocations = 0;
+        uint64_t deallocations = 0;
+    };
+
+    /**
+     * @brief Small object allocator for coroutine frames and coroutine bookkeeping.
+     *
+     * Blocks are rounded up to power-of-two size classes and recycled through thread local free lists.
+     * Overflowed free lists are handed to a global depot in batches, so a frame spawned on game thread
+     * and destroyed on a worker could be reused by the game thread again without touching `malloc`.
+     */
+    class AVALANCHE_CORE_API frame_allocator {
+    public:
+        using size_type = size_t;
+
+        static constexpr size_type min_block_size = 64;
+        static constexpr size_type max_block_size = 4096;
+
+        static void* allocate(size_type bytes);
+        static void deallocate(void* pointer, size_type bytes) AVALANCHE_NOEXCEPT;
+
+        /**
+         * @brief Counters of the calling thread.
+         */
+        static frame_allocator_stats get_thread_stats();
+
+        /**
+         * @brief Counters of all threads, system allocations are always exact while others are only
+         * accumulated from the threads which have exited.
+         */
+        static frame_allocator_stats get_global_stats();
+    };
+
+    /**
+     * @brief Linear memory for coroutine frames living no longer than a frame (or a tick).
+     *
+     * Allocations made on a thread with a bound arena (see `scoped_coroutine_arena`) are bumped from the arena,
+     * freeing them is almost free. Once exhausted, allocations fall back to the pooled path.
+     */
+    class AVALANCHE_CORE_API coroutine_arena {
+    public:
+        using size_type = size_t;
+
+        explicit coroutine_arena(size_type capacity_in_bytes);
+        ~coroutine_arena();
+
+        coroutine_arena(const coroutine_arena&) = delete;
+        coroutine_arena& operator=(const coroutine_arena&) = delete;
+
+        /**
+         * @brief Rewind the arena, all frames allocated from it must have been destroyed.
+         */
+        void reset();
+
+        AVALANCHE_NO_DISCARD size_type capacity() const;
+        AVALANCHE_NO_DISCARD size_type used_bytes() const;
+        AVALANCHE_NO_DISCARD size_type live_allocations() const;
+
+    private:
+        AVALANCHE_CORE_INTERNAL void* try_allocate(size_type bytes);
+        AVALANCHE_CORE_INTERNAL void release();
+
+        std::byte* m_memory;
+        size_type m_capacity;
+        std::atomic<size_type> m_offset{0};
+        std::atomic<size_type> m_live_allocations{0};
+
+        friend class frame_allocator;
+    };
+
+    /**
+     * @brief Bind an arena to current thread during the scope.
+     */
+    class AVALANCHE_CORE_API scoped_coroutine_arena {
+    public:
+        explicit scoped_coroutine_arena(coroutine_arena& arena);
+        ~scoped_coroutine_arena();
+
+        scoped_coroutine_arena(const scoped_coroutine_arena&) = delete;
+        scoped_coroutine_arena& operator=(const scoped_coroutine_arena&) = delete;
+
+    private:
+        coroutine_arena* m_previous;
+    };
+
+    /**
+     * @brief Inherit from this to route `new`/`delete` of the class (or coroutine frame if it is a promise) to
+     * `frame_allocator`.
+     */
+    struct pooled_frame {
+        static void* operator new(const size_t bytes) {
+            return frame_allocator::allocate(bytes);
+        }
+
+        static void operator delete(void* pointer, const size_t bytes) AVALANCHE_NOEXCEPT {
+            frame_allocator::deallocate(pointer, bytes);
+        }
+    };
+
+}
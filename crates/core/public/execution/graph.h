@@ -3,11 +3,15 @@
 #include "avalanche_core_export.h"
 #include "container/exception.hpp"
 #include "container/vector.hpp"
+#include "container/small_vector.hpp"
 #include "container/vector_queue.hpp"
 #include "container/shared_ptr.hpp"
 #include <cstdint>
 #include <concepts>
+#include <algorithm>
 #include <atomic>
+#include <span>
+#include <utility>
 
 namespace avalanche::core::execution {
 
@@ -34,6 +38,17 @@ namespace avalanche::core::execution {
         friend class Graph;
     };
 
+    template <typename NodeType>
+    class CompiledGraph;
+
+    /**
+     * @brief Directed acyclic graph keeping a topological order of its nodes.
+     *
+     * The order is maintained incrementally with Pearce-Kelly algorithm, inserting an edge which already agrees with the
+     * order costs O(1), otherwise only the nodes between both ends of the edge are visited and reordered.
+     *
+     * A lot of edges could be inserted between `begin_batch()` and `commit()`, they are validated and sorted at once.
+     */
     template <typename NodeType>
     class Graph {
     public:
@@ -42,21 +57,34 @@ namespace avalanche::core::execution {
         using size_type = size_t;
 
         static constexpr size_type default_reserved_node_num = 32;
+        // Most nodes have a handful of edges, their lists are kept inside the graph's node arrays
+        static constexpr size_type inline_edge_num = 4;
+
+        using adjacency_list_type = small_vector<node_id_type, inline_edge_num>;
 
         explicit Graph(size_type reserved_node_num = default_reserved_node_num)
             : m_nodes(reserved_node_num)
             , m_adjacency_to_list(reserved_node_num)
+            , m_adjacency_from_list(reserved_node_num)
             , m_in_degree(reserved_node_num)
             , m_topological_sorting(reserved_node_num)
+            , m_topological_index(reserved_node_num)
+            , m_visit_mark(reserved_node_num)
         {
             // Create root node
             new_node();
         }
 
         shared_ptr<node_type> new_node() {
-            m_nodes.push_back(make_shared<node_type>(m_increase_id_value++));
+            const node_id_type nid = m_increase_id_value++;
+            m_nodes.push_back(make_shared<node_type>(nid));
             m_adjacency_to_list.emplace_back();
+            m_adjacency_from_list.emplace_back();
             m_in_degree.emplace_back(0);
+            m_visit_mark.emplace_back(0);
+            // A node without edges could be placed anywhere, appending keeps the order valid
+            m_topological_index.emplace_back(m_topological_sorting.size());
+            m_topological_sorting.emplace_back(nid);
             return m_nodes.last_item();
         }
 
@@ -64,6 +92,11 @@ namespace avalanche::core::execution {
             return m_nodes.is_valid_index(nid) && m_nodes[nid] && m_nodes[nid]->node_id() == nid;
         }
 
+        /**
+         * @brief Connect two nodes, raising `cycle_detected` (and leaving the graph unchanged) if it would form a cycle.
+         *
+         * Inside a batch, the check is deferred to `commit()`.
+         */
         void add_edge(const shared_ptr<node_type>& from, const shared_ptr<node_type>& to) {
             AVALANCHE_CHECK(from && to, "Trying to connect invalid nodes");
 
@@ -72,22 +105,60 @@ namespace avalanche::core::execution {
 
             AVALANCHE_CHECK(!m_adjacency_to_list[nid_from].contains(nid_to), "Edge already exists");
 
-            m_adjacency_to_list[nid_from].push_back(nid_to);
-            ++m_in_degree[nid_to];
+            insert_edge(nid_from, nid_to);
 
-            // Memory barrier to ensure all modifications are visible to the next operations
-            std::atomic_thread_fence(std::memory_order_release);
+            if (m_is_batching) {
+                m_batched_edges.emplace_back(nid_from, nid_to);
+                return;
+            }
 
-            if (has_cycle()) {
-                m_adjacency_to_list[nid_from].remove_last();
-                --m_in_degree[nid_to];
+            if (!reorder_for_edge(nid_from, nid_to)) {
+                remove_last_edge(nid_from, nid_to);
                 raise_exception(cycle_detected{});
             }
+        }
 
-            // Memory barrier to ensure all read are performed
-            std::atomic_thread_fence(std::memory_order_acquire);
+        /**
+         * @brief Defer cycle detection and sorting of following `add_edge()` until `commit()`.
+         *
+         * Topological order is stale during a batch.
+         */
+        void begin_batch() {
+            AVALANCHE_CHECK(!m_is_batching, "Graph::begin_batch(): Already in a batch");
+            m_is_batching = true;
+        }
 
-            topological_sort();
+        /**
+         * @brief Validate and sort all edges inserted in current batch with a single pass.
+         *
+         * If they form a cycle, all of them are removed and `cycle_detected` is raised.
+         */
+        void commit() {
+            AVALANCHE_CHECK(m_is_batching, "Graph::commit(): Not in a batch");
+            m_is_batching = false;
+
+            if (!topological_sort()) {
+                // Remove in reverse order, so each edge is the last one of its lists
+                for (size_type i = m_batched_edges.size(); i > 0; --i) {
+                    const auto& [nid_from, nid_to] = m_batched_edges[i - 1];
+                    remove_last_edge(nid_from, nid_to);
+                }
+                m_batched_edges.clear();
+                topological_sort();
+                raise_exception(cycle_detected{});
+            }
+            m_batched_edges.clear();
+        }
+
+        AVALANCHE_NO_DISCARD bool is_batching() const {
+            return m_is_batching;
+        }
+
+        /**
+         * @brief Freeze current graph into a `CompiledGraph`, nodes are copied.
+         */
+        CompiledGraph<node_type> compile() const {
+            return CompiledGraph<node_type>(*this);
         }
 
         shared_ptr<node_type> get_node_from_id(node_id_type nid) const {
@@ -99,38 +170,130 @@ namespace avalanche::core::execution {
             return get_node_from_id(0);
         }
 
-    protected:
-        AVALANCHE_NO_DISCARD bool has_cycle() const {
-            vector<size_type> in_degree = m_in_degree;
-            vector_queue<node_id_type> zero_in_degree_queue{};
+        /**
+         * @brief Access node without touching its reference count, for hot paths iterating over nodes.
+         */
+        node_type& get_node(node_id_type nid) const {
+            return *m_nodes[nid].get();
+        }
 
-            for (int i = 0; i < in_degree.size(); ++i) {
-                AVALANCHE_CHECK(in_degree.is_valid_index(i), "Graph::has_cycle(): Internal state is not consistency");
-                if (in_degree[i] == 0) {
-                    zero_in_degree_queue.emplace_back(i);
-                }
-            }
+        AVALANCHE_NO_DISCARD size_type node_count() const {
+            return m_nodes.size();
+        }
 
-            size_type visited_nodes = 0;
-            while (!zero_in_degree_queue.queue_is_empty()) {
-                const node_id_type nid = zero_in_degree_queue.queue_pop_front();
-                visited_nodes++;
+        AVALANCHE_NO_DISCARD const adjacency_list_type& get_successors(node_id_type nid) const {
+            return m_adjacency_to_list[nid];
+        }
+
+        AVALANCHE_NO_DISCARD const adjacency_list_type& get_predecessors(node_id_type nid) const {
+            return m_adjacency_from_list[nid];
+        }
+
+        AVALANCHE_NO_DISCARD size_type get_in_degree(node_id_type nid) const {
+            return m_in_degree[nid];
+        }
+
+        AVALANCHE_NO_DISCARD const vector<node_id_type>& get_topological_order() const {
+            return m_topological_sorting;
+        }
 
+        /**
+         * @return Position of the node in `get_topological_order()`
+         */
+        AVALANCHE_NO_DISCARD size_type get_topological_index(node_id_type nid) const {
+            return m_topological_index[nid];
+        }
+
+        /**
+         * @brief Check every edge against the maintained order, an edge pointing backwards means a cycle.
+         *
+         * Edges closing a cycle are rejected on insertion or on `commit()`, so this only fails if the graph is corrupted.
+         */
+        AVALANCHE_NO_DISCARD bool has_cycle() const {
+            AVALANCHE_CHECK(!m_is_batching, "Graph::has_cycle(): Order is stale during a batch");
+            for (size_type nid = 0; nid < node_count(); ++nid) {
                 for (const node_id_type next_nid : m_adjacency_to_list[nid]) {
-                    in_degree[next_nid]--;
-                    if (in_degree[next_nid] == 0) {
-                        zero_in_degree_queue.emplace_back(next_nid);
+                    if (m_topological_index[next_nid] <= m_topological_index[nid]) {
+                        return true;
                     }
                 }
             }
+            return false;
+        }
+
+    protected:
+        void insert_edge(node_id_type nid_from, node_id_type nid_to) {
+            m_adjacency_to_list[nid_from].push_back(nid_to);
+            m_adjacency_from_list[nid_to].push_back(nid_from);
+            ++m_in_degree[nid_to];
+        }
 
-            return visited_nodes != in_degree.size();
+        void remove_last_edge(node_id_type nid_from, node_id_type nid_to) {
+            m_adjacency_to_list[nid_from].remove_last();
+            m_adjacency_from_list[nid_to].remove_last();
+            --m_in_degree[nid_to];
         }
 
-        void topological_sort() {
+        /**
+         * @brief Pearce-Kelly, restore the order after inserting edge `nid_from -> nid_to`.
+         *
+         * Only nodes whose position lies in [index(to), index(from)] could be affected. Nodes reachable from `to` are
+         * collected with a forward search and nodes reaching `from` with a backward search, then positions of both sets are
+         * reassigned so that the backward set precedes the forward set.
+         *
+         * @return false if the edge closes a cycle, the order is untouched in that case
+         */
+        bool reorder_for_edge(node_id_type nid_from, node_id_type nid_to) {
+            const size_type lower_bound = m_topological_index[nid_to];
+            const size_type upper_bound = m_topological_index[nid_from];
+            if (upper_bound < lower_bound) {
+                return true;
+            }
+
+            m_forward_visited.clear();
+            m_backward_visited.clear();
+
+            const size_type forward_mark = next_visit_mark();
+            if (!search_forward(nid_to, upper_bound, nid_from, forward_mark)) {
+                return false;
+            }
+            search_backward(nid_from, lower_bound, next_visit_mark());
+
+            const auto by_topological_index = [this](const node_id_type a, const node_id_type b) {
+                return m_topological_index[a] < m_topological_index[b];
+            };
+            std::sort(m_forward_visited.begin(), m_forward_visited.end(), by_topological_index);
+            std::sort(m_backward_visited.begin(), m_backward_visited.end(), by_topological_index);
+
+            // Merge positions of both sets, they are disjoint as the graph was acyclic
+            m_reorder_slots.clear();
+            size_type f = 0, b = 0;
+            while (f < m_forward_visited.size() || b < m_backward_visited.size()) {
+                if (b == m_backward_visited.size() || (f < m_forward_visited.size() && by_topological_index(m_forward_visited[f], m_backward_visited[b]))) {
+                    m_reorder_slots.emplace_back(m_topological_index[m_forward_visited[f++]]);
+                } else {
+                    m_reorder_slots.emplace_back(m_topological_index[m_backward_visited[b++]]);
+                }
+            }
+
+            size_type slot = 0;
+            for (const node_id_type nid : m_backward_visited) {
+                place_node(nid, m_reorder_slots[slot++]);
+            }
+            for (const node_id_type nid : m_forward_visited) {
+                place_node(nid, m_reorder_slots[slot++]);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Rebuild the whole order with Kahn's algorithm.
+         * @return false if there is a cycle, the order is left untouched in that case
+         */
+        bool topological_sort() {
             vector<size_type> in_degree = m_in_degree;
-            vector_queue<node_id_type> zero_in_degree_queue{};
-            m_topological_sorting.clear();
+            vector_queue<node_id_type> zero_in_degree_queue(in_degree.size());
+            vector<node_id_type> sorting(in_degree.size());
 
             for (size_type i = 0; i < in_degree.size(); ++i) {
                 if (in_degree[i] == 0) {
@@ -140,7 +303,7 @@ namespace avalanche::core::execution {
 
             while (!zero_in_degree_queue.queue_is_empty()) {
                 const node_id_type nid = zero_in_degree_queue.queue_pop_front();
-                m_topological_sorting.emplace_back(nid);
+                sorting.emplace_back(nid);
 
                 for (const node_id_type next_nid : m_adjacency_to_list[nid]) {
                     in_degree[next_nid]--;
@@ -149,19 +312,223 @@ namespace avalanche::core::execution {
                     }
                 }
             }
+
+            if (sorting.size() != in_degree.size()) {
+                return false;
+            }
+
+            m_topological_sorting = std::move(sorting);
+            for (size_type i = 0; i < m_topological_sorting.size(); ++i) {
+                m_topological_index[m_topological_sorting[i]] = i;
+            }
+            return true;
         }
 
     private:
+        size_type next_visit_mark() {
+            return ++m_current_visit_mark;
+        }
+
+        void place_node(node_id_type nid, size_type index) {
+            m_topological_index[nid] = index;
+            m_topological_sorting[index] = nid;
+        }
+
+        /**
+         * @return false if `target` is reachable, which means a cycle
+         */
+        bool search_forward(node_id_type start, size_type upper_bound, node_id_type target, size_type mark) {
+            m_search_stack.clear();
+            m_search_stack.emplace_back(start);
+            m_visit_mark[start] = mark;
+            while (!m_search_stack.is_empty()) {
+                const node_id_type nid = m_search_stack.last_item();
+                m_search_stack.remove_last();
+                if (nid == target) {
+                    return false;
+                }
+                m_forward_visited.emplace_back(nid);
+                for (const node_id_type next_nid : m_adjacency_to_list[nid]) {
+                    if (m_visit_mark[next_nid] != mark && m_topological_index[next_nid] <= upper_bound) {
+                        m_visit_mark[next_nid] = mark;
+                        m_search_stack.emplace_back(next_nid);
+                    }
+                }
+            }
+            return true;
+        }
+
+        void search_backward(node_id_type start, size_type lower_bound, size_type mark) {
+            m_search_stack.clear();
+            m_search_stack.emplace_back(start);
+            m_visit_mark[start] = mark;
+            while (!m_search_stack.is_empty()) {
+                const node_id_type nid = m_search_stack.last_item();
+                m_search_stack.remove_last();
+                m_backward_visited.emplace_back(nid);
+                for (const node_id_type prev_nid : m_adjacency_from_list[nid]) {
+                    if (m_visit_mark[prev_nid] != mark && m_topological_index[prev_nid] >= lower_bound) {
+                        m_visit_mark[prev_nid] = mark;
+                        m_search_stack.emplace_back(prev_nid);
+                    }
+                }
+            }
+        }
+
         std::atomic<node_id_type> m_increase_id_value = 0;
 
         // Store nodes
         vector<shared_ptr<node_type>> m_nodes;
         // Store out edges of each node
-        vector<vector<node_id_type>> m_adjacency_to_list;
+        vector<adjacency_list_type> m_adjacency_to_list;
+        // Store in edges of each node, for the backward search of incremental sorting
+        vector<adjacency_list_type> m_adjacency_from_list;
         // Store in-degree of each node
         vector<size_type> m_in_degree;
         // Store topological sorting
         vector<node_id_type> m_topological_sorting;
+        // Store position of each node in topological sorting
+        vector<size_type> m_topological_index;
+
+        // Scratch buffers of incremental sorting, kept to avoid allocating per edge
+        vector<size_type> m_visit_mark;
+        size_type m_current_visit_mark = 0;
+        vector<node_id_type> m_search_stack{};
+        vector<node_id_type> m_forward_visited{};
+        vector<node_id_type> m_backward_visited{};
+        vector<size_type> m_reorder_slots{};
+
+        bool m_is_batching = false;
+        vector<std::pair<node_id_type, node_id_type>> m_batched_edges{};
+    };
+
+    /**
+     * @brief Frozen form of a `Graph`, built for traversing rather than editing.
+     *
+     * Edges are stored as compressed sparse rows (all successors in one array, sliced by per-node offsets) and nodes are
+     * stored by value in one array, so walking the graph touches a few contiguous arrays instead of a heap block per node.
+     */
+    template <typename NodeType>
+    class CompiledGraph {
+    public:
+        using node_type = NodeType;
+        using node_id_type = typename Graph<NodeType>::node_id_type;
+        using size_type = typename Graph<NodeType>::size_type;
+        using successor_range = std::span<const node_id_type>;
+
+        CompiledGraph() = default;
+
+        explicit CompiledGraph(const Graph<NodeType>& graph)
+            : m_nodes(graph.node_count())
+            , m_successor_offsets(graph.node_count() + 1)
+            , m_in_degree(graph.node_count())
+        {
+            AVALANCHE_CHECK(!graph.is_batching(), "CompiledGraph: Can't compile a graph with uncommitted batch");
+            const size_type num_nodes = graph.node_count();
+
+            size_type num_edges = 0;
+            for (size_type nid = 0; nid < num_nodes; ++nid) {
+                num_edges += graph.get_successors(static_cast<node_id_type>(nid)).size();
+            }
+            m_successor_targets = vector<node_id_type>(num_edges);
+
+            m_successor_offsets.emplace_back(0);
+            for (size_type nid = 0; nid < num_nodes; ++nid) {
+                m_nodes.emplace_back(graph.get_node(static_cast<node_id_type>(nid)));
+                for (const node_id_type next_nid : graph.get_successors(static_cast<node_id_type>(nid))) {
+                    m_successor_targets.emplace_back(next_nid);
+                }
+                m_successor_offsets.emplace_back(m_successor_targets.size());
+                m_in_degree.emplace_back(graph.get_in_degree(static_cast<node_id_type>(nid)));
+            }
+
+            topological_sort();
+        }
+
+        AVALANCHE_NO_DISCARD size_type node_count() const {
+            return m_nodes.size();
+        }
+
+        AVALANCHE_NO_DISCARD size_type edge_count() const {
+            return m_successor_targets.size();
+        }
+
+        node_type& get_node(node_id_type nid) {
+            return m_nodes[nid];
+        }
+
+        const node_type& get_node(node_id_type nid) const {
+            return m_nodes[nid];
+        }
+
+        AVALANCHE_NO_DISCARD successor_range get_successors(node_id_type nid) const {
+            const size_type begin = m_successor_offsets[nid];
+            return successor_range(m_successor_targets.data() + begin, m_successor_offsets[nid + 1] - begin);
+        }
+
+        AVALANCHE_NO_DISCARD size_type get_in_degree(node_id_type nid) const {
+            return m_in_degree[nid];
+        }
+
+        AVALANCHE_NO_DISCARD const vector<node_id_type>& get_topological_order() const {
+            return m_topological_sorting;
+        }
+
+        AVALANCHE_NO_DISCARD static constexpr bool is_batching() {
+            return false;
+        }
+
+        /**
+         * @brief Visit nodes reachable from `start` in breadth first order, `function(nid)` is invoked once per node.
+         */
+        template <typename Function>
+        void breadth_first_traverse(node_id_type start, Function&& function) const {
+            vector<bool> visited(node_count());
+            for (size_type i = 0; i < node_count(); ++i) {
+                visited.emplace_back(false);
+            }
+            vector_queue<node_id_type> queue(node_count());
+            queue.emplace_back(start);
+            visited[start] = true;
+            while (!queue.queue_is_empty()) {
+                const node_id_type nid = queue.queue_pop_front();
+                function(nid);
+                for (const node_id_type next_nid : get_successors(nid)) {
+                    if (!visited[next_nid]) {
+                        visited[next_nid] = true;
+                        queue.emplace_back(next_nid);
+                    }
+                }
+            }
+        }
+
+    private:
+        void topological_sort() {
+            vector<size_type> in_degree = m_in_degree;
+            m_topological_sorting = vector<node_id_type>(node_count());
+
+            for (size_type nid = 0; nid < node_count(); ++nid) {
+                if (in_degree[nid] == 0) {
+                    m_topological_sorting.emplace_back(static_cast<node_id_type>(nid));
+                }
+            }
+            // The output doubles as the queue of Kahn's algorithm
+            for (size_type cursor = 0; cursor < m_topological_sorting.size(); ++cursor) {
+                for (const node_id_type next_nid : get_successors(m_topological_sorting[cursor])) {
+                    if (--in_degree[next_nid] == 0) {
+                        m_topological_sorting.emplace_back(next_nid);
+                    }
+                }
+            }
+            AVALANCHE_CHECK(m_topological_sorting.size() == node_count(), "CompiledGraph: Source graph has a cycle");
+        }
+
+        vector<node_type> m_nodes{};
+        // Successors of node `i` are m_successor_targets[m_successor_offsets[i] .. m_successor_offsets[i + 1])
+        vector<size_type> m_successor_offsets{};
+        vector<node_id_type> m_successor_targets{};
+        vector<size_type> m_in_degree{};
+        vector<node_id_type> m_topological_sorting{};
     };
 
 }
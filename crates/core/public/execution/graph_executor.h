@@ -0,0 +1,277 @@
+#pragma once
+
+#include "polyfill.h"
+#include "logger.h"
+#include "execution/graph.h"
+#include "execution/async_coroutine.h"
+#include "execution/combinators.h"
+#include "execution/parallel.h"
+#include <atomic>
+#include <concepts>
+#include <functional>
+#include <ranges>
+#include <utility>
+
+
+namespace avalanche::core::execution {
+
+    template <typename NodeType>
+    concept ExecutableNode = requires(NodeType& node) {
+        { node.execute() };
+    };
+
+    /**
+     * @brief Graph node wrapping a callable, the building block of frame jobs.
+     */
+    class TaskNode : public Node<TaskNode> {
+    public:
+        using task_type = std::function<void()>;
+
+        using Node::Node;
+
+        void set_task(task_type task) {
+            m_task = std::move(task);
+        }
+
+        void execute() {
+            if (m_task) {
+                m_task();
+            }
+        }
+
+    private:
+        task_type m_task{};
+    };
+
+    template <typename GraphType>
+    concept ExecutableGraph = requires(GraphType& graph, typename GraphType::node_id_type nid) {
+        { graph.get_node(nid).execute() };
+        { graph.node_count() } -> std::convertible_to<size_t>;
+        { graph.get_in_degree(nid) } -> std::convertible_to<size_t>;
+        { graph.get_successors(nid) } -> std::ranges::range;
+        { graph.is_batching() } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief Dispatch nodes of a `Graph` (or its `CompiledGraph`) to the global threaded executor, following its edges.
+     *
+     * Every node owns an atomic counter of unfinished predecessors, reset from the in-degree of the graph at the
+     * beginning of each run. The node finishing last releases the successor, so there is no serial pass over the
+     * topological order. Counters are kept between runs, the same graph could be executed every frame without rebuilding.
+     *
+     * Some nodes could be pinned to the thread calling `run()`, see `run_with_inline_nodes()`.
+     *
+     * The graph must not be modified while running.
+     */
+    template <ExecutableNode NodeType, ExecutableGraph GraphType = Graph<NodeType>>
+    class GraphExecutor {
+    public:
+        using graph_type = GraphType;
+        using node_type = NodeType;
+        using node_id_type = typename graph_type::node_id_type;
+        using size_type = typename graph_type::size_type;
+        using counter_type = std::atomic<size_type>;
+
+        static constexpr node_id_type invalid_node_id = -1;
+
+        explicit GraphExecutor(graph_type& graph) : m_graph(graph) {}
+
+        GraphExecutor(const GraphExecutor&) = delete;
+        GraphExecutor& operator=(const GraphExecutor&) = delete;
+
+        ~GraphExecutor() {
+            delete[] m_pending_predecessors;
+            delete[] m_is_inline_node;
+        }
+
+        /**
+         * @brief Execute every node once, resuming after all of them finished.
+         */
+        async<void> run_async() {
+            AVALANCHE_CHECK(!m_is_running.exchange(true, std::memory_order_acq_rel), "GraphExecutor is already running");
+            AVALANCHE_CHECK(!m_graph.is_batching(), "GraphExecutor can't run a graph with uncommitted batch");
+            const size_type num_nodes = prepare();
+            m_priority = threaded_coroutine_executor::get_current_priority();
+
+            detail::async::when_all_counter counter(num_nodes);
+            co_await run_awaitable{*this, counter};
+
+            m_is_running.store(false, std::memory_order_release);
+        }
+
+        /**
+         * @brief Blocking `run_async()`, must not be called from a worker of the executor.
+         * @param priority Lane of the nodes in the executor
+         */
+        void run(const task_priority priority = task_priority::normal) {
+            AVALANCHE_CHECK(threaded_coroutine_executor::get_current_worker_index() == threaded_coroutine_executor::invalid_worker_index, "GraphExecutor::run() called from a worker, co_await run_async() instead");
+            auto task = run_async();
+            task->set_priority(priority);
+            detail::parallel::block_on(task);
+        }
+
+        /**
+         * @brief Blocking run, executing the nodes of `inline_nodes` on the calling thread in the given order, while the
+         * others are dispatched to the workers like `run()`.
+         *
+         * The order must follow the edges between inline nodes. The calling thread waits for the predecessors of each
+         * inline node running on workers, and inline nodes never run on a worker.
+         *
+         * @param priority Lane of the nodes in the executor
+         */
+        template <std::ranges::forward_range Range>
+        void run_with_inline_nodes(const Range& inline_nodes, const task_priority priority = task_priority::normal) {
+            AVALANCHE_CHECK(threaded_coroutine_executor::get_current_worker_index() == threaded_coroutine_executor::invalid_worker_index, "GraphExecutor::run_with_inline_nodes() called from a worker");
+            AVALANCHE_CHECK(!m_is_running.exchange(true, std::memory_order_acq_rel), "GraphExecutor is already running");
+            AVALANCHE_CHECK(!m_graph.is_batching(), "GraphExecutor can't run a graph with uncommitted batch");
+            const size_type num_nodes = prepare();
+            m_priority = priority;
+
+            size_type num_inline_nodes = 0;
+            for (const node_id_type nid : inline_nodes) {
+                m_is_inline_node[nid] = true;
+                ++num_inline_nodes;
+            }
+
+            detail::async::when_all_counter counter(num_nodes - num_inline_nodes);
+            for (size_type nid = 0; nid < num_nodes; ++nid) {
+                if (m_graph.get_in_degree(static_cast<node_id_type>(nid)) == 0 && !m_is_inline_node[nid]) {
+                    spawn(counter, static_cast<node_id_type>(nid));
+                }
+            }
+
+            for (const node_id_type nid : inline_nodes) {
+                counter_type& pending = m_pending_predecessors[nid];
+                for (size_type remaining = pending.load(std::memory_order_acquire); remaining != 0; remaining = pending.load(std::memory_order_acquire)) {
+                    pending.wait(remaining, std::memory_order_acquire);
+                }
+                m_graph.get_node(nid).execute();
+                for (const node_id_type successor : m_graph.get_successors(nid)) {
+                    // Inline successors come later in the order, the loop gets to them
+                    if (m_pending_predecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1 && !m_is_inline_node[successor]) {
+                        spawn(counter, successor);
+                    }
+                }
+            }
+
+            // We are still holding a count, nodes on the workers resume the join coroutine once all of them finished
+            auto task = join(counter);
+            task->set_priority(priority);
+            detail::parallel::block_on(task);
+
+            for (const node_id_type nid : inline_nodes) {
+                m_is_inline_node[nid] = false;
+            }
+            m_is_running.store(false, std::memory_order_release);
+        }
+
+    private:
+        struct run_awaitable {
+            GraphExecutor& executor;
+            detail::async::when_all_counter& counter;
+
+            bool await_ready() const AVALANCHE_NOEXCEPT {
+                return executor.m_num_counters == 0;
+            }
+
+            bool await_suspend(std::coroutine_handle<> parent_handle) {
+                const graph_type& graph = executor.m_graph;
+                for (size_type nid = 0; nid < executor.m_num_counters; ++nid) {
+                    if (graph.get_in_degree(static_cast<node_id_type>(nid)) == 0) {
+                        executor.spawn(counter, static_cast<node_id_type>(nid));
+                    }
+                }
+                return counter.try_suspend(parent_handle);
+            }
+
+            static void await_resume() AVALANCHE_NOEXCEPT {}
+        };
+
+        struct join_awaitable {
+            detail::async::when_all_counter& counter;
+
+            static constexpr bool await_ready() AVALANCHE_NOEXCEPT {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> parent_handle) AVALANCHE_NOEXCEPT {
+                return counter.try_suspend(parent_handle);
+            }
+
+            static void await_resume() AVALANCHE_NOEXCEPT {}
+        };
+
+        static async<void> join(detail::async::when_all_counter& counter) {
+            co_await join_awaitable{counter};
+        }
+
+        /**
+         * @brief Make the counters ready for a new run.
+         * @return Number of nodes
+         */
+        size_type prepare() {
+            const size_type num_nodes = m_graph.node_count();
+            if (num_nodes != m_num_counters) {
+                delete[] m_pending_predecessors;
+                delete[] m_is_inline_node;
+                m_pending_predecessors = num_nodes > 0 ? new counter_type[num_nodes] : nullptr;
+                m_is_inline_node = num_nodes > 0 ? new bool[num_nodes]{} : nullptr;
+                m_num_counters = num_nodes;
+            }
+            for (size_type nid = 0; nid < num_nodes; ++nid) {
+                m_pending_predecessors[nid].store(m_graph.get_in_degree(static_cast<node_id_type>(nid)), std::memory_order_relaxed);
+            }
+            // Published to the workers by pushing the root tasks
+            return num_nodes;
+        }
+
+        void spawn(detail::async::when_all_counter& counter, const node_id_type nid) {
+            auto task = run_node(counter, nid);
+            task->set_priority(m_priority);
+            task->set_completion_listener(&counter);
+            task->schedule();
+            if (task->arrive_at_continuation_handshake()) {
+                // Spawner is holding a count, this never resumes the awaiting coroutine
+                AVALANCHE_MAYBE_UNUSED const auto handle = counter.arrive();
+            }
+        }
+
+        /**
+         * @brief Execute a node, then continue with one of its released successors on the same worker and spawn the others.
+         */
+        detail::async::coroutine<void> run_node(detail::async::when_all_counter& counter, node_id_type nid) {
+            while (nid != invalid_node_id) {
+                m_graph.get_node(nid).execute();
+
+                node_id_type next_nid = invalid_node_id;
+                for (const node_id_type successor : m_graph.get_successors(nid)) {
+                    if (m_pending_predecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        if (m_is_inline_node[successor]) {
+                            // The calling thread is waiting for it
+                            m_pending_predecessors[successor].notify_one();
+                            continue;
+                        }
+                        if (next_nid != invalid_node_id) {
+                            spawn(counter, next_nid);
+                        }
+                        next_nid = successor;
+                    }
+                }
+                if (next_nid != invalid_node_id) {
+                    // Finished `nid` without leaving this coroutine, the last node is counted by the final awaiter
+                    AVALANCHE_MAYBE_UNUSED const auto handle = counter.arrive();
+                }
+                nid = next_nid;
+            }
+            co_return;
+        }
+
+        graph_type& m_graph;
+        counter_type* m_pending_predecessors = nullptr;
+        bool* m_is_inline_node = nullptr;
+        size_type m_num_counters = 0;
+        task_priority m_priority = task_priority::normal;
+        std::atomic<bool> m_is_running{false};
+    };
+
+}
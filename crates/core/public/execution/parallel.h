@@ -0,0 +1,267 @@
+#pragma once
+
+#include "polyfill.h"
+#include "execution/async_coroutine.h"
+#include "execution/combinators.h"
+#include "execution/executor.h"
+#include <bit>
+#include <concepts>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <utility>
+
+
+namespace avalanche::core::execution {
+
+namespace detail::parallel {
+
+    using size_type = threaded_coroutine_executor::size_type;
+
+    /**
+     * @brief Extra splits granted to a chunk running on another worker than the one spawned it.
+     *
+     * A steal means some worker is idle, so the stolen half gets split further to feed it.
+     */
+    constexpr size_type split_budget_on_steal = 2;
+
+    inline size_type initial_split_budget() {
+        // Roughly 4 chunks per worker before any steal happens
+        return std::bit_width(threaded_coroutine_executor::get_global_executor().get_num_workers()) + 2;
+    }
+
+    /**
+     * @brief Shared by every chunk of a parallel loop, lives in the frame of the coroutine awaiting the loop.
+     */
+    template <std::integral T, typename Body>
+    class loop_state {
+    public:
+        loop_state(Body& body, const size_type grain)
+            : m_body(body)
+            , m_grain(grain > 0 ? grain : 1)
+        {}
+
+        loop_state(const loop_state&) = delete;
+        loop_state& operator=(const loop_state&) = delete;
+
+        template <typename Task>
+        void spawn(Task&& task) {
+            m_counter.expect(1);
+            task->set_completion_listener(&m_counter);
+            task->schedule();
+            if (task->arrive_at_continuation_handshake()) {
+                // The spawner is still holding a count, this never resumes the awaiting coroutine
+                AVALANCHE_MAYBE_UNUSED const auto handle = m_counter.arrive();
+            }
+        }
+
+        AVALANCHE_NO_DISCARD size_type grain() const AVALANCHE_NOEXCEPT {
+            return m_grain;
+        }
+
+        void run_body(T begin, T end) {
+            std::invoke(m_body, begin, end);
+        }
+
+        bool try_suspend(std::coroutine_handle<> awaiting) AVALANCHE_NOEXCEPT {
+            return m_counter.try_suspend(awaiting);
+        }
+
+    private:
+        Body& m_body;
+        size_type m_grain;
+        async::when_all_counter m_counter{0};
+    };
+
+    /**
+     * @brief Lazy binary splitting, a chunk hands out its upper half as long as it has split budget left.
+     */
+    template <std::integral T, typename Body>
+    async::coroutine<void> run_chunk(loop_state<T, Body>& state, T begin, T end, size_type split_budget, const size_type spawner) {
+        const size_type worker = threaded_coroutine_executor::get_current_worker_index();
+        if (worker != spawner) {
+            split_budget += split_budget_on_steal;
+        }
+        while (split_budget > 0 && static_cast<size_type>(end - begin) > state.grain()) {
+            const T middle = begin + (end - begin) / 2;
+            --split_budget;
+            state.spawn(run_chunk(state, middle, end, split_budget, worker));
+            end = middle;
+        }
+        state.run_body(begin, end);
+        co_return;
+    }
+
+    template <std::integral T, typename Body>
+    class loop_awaitable {
+    public:
+        loop_awaitable(loop_state<T, Body>& state, const T begin, const T end)
+            : m_state(state)
+            , m_begin(begin)
+            , m_end(end)
+        {}
+
+        bool await_ready() const AVALANCHE_NOEXCEPT {
+            return m_begin >= m_end;
+        }
+
+        bool await_suspend(std::coroutine_handle<> parent_handle) {
+            m_state.spawn(run_chunk(m_state, m_begin, m_end, initial_split_budget(), threaded_coroutine_executor::get_current_worker_index()));
+            return m_state.try_suspend(parent_handle);
+        }
+
+        static void await_resume() AVALANCHE_NOEXCEPT {}
+
+    private:
+        loop_state<T, Body>& m_state;
+        T m_begin;
+        T m_end;
+    };
+
+    /**
+     * @brief Wakes up a thread blocking on a coroutine, see `block_on()`.
+     */
+    class blocking_listener final : public async::completion_listener {
+    public:
+        std::coroutine_handle<> on_completed(promise_state_base&) AVALANCHE_NOEXCEPT override {
+            // Notify while holding the lock, or the waiting thread might return and destroy us in between
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_completed = true;
+            m_cv.notify_all();
+            return std::noop_coroutine();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_is_completed; });
+        }
+
+    private:
+        std::mutex m_mutex{};
+        std::condition_variable m_cv{};
+        bool m_is_completed = false;
+    };
+
+    /**
+     * @brief Run the coroutine on its executor and block calling thread until it finished.
+     *
+     * Must not be called from a worker, that worker would be blocked and can't take part in the job.
+     */
+    template <typename Ret>
+    void block_on(async::coroutine<Ret>& task) {
+        blocking_listener listener{};
+        task->set_completion_listener(&listener);
+        task->schedule();
+        if (!task->arrive_at_continuation_handshake()) {
+            listener.wait();
+        }
+    }
+
+    inline bool should_run_inline(const size_type count, const size_type grain) {
+        // Blocking a worker might deadlock the executor, e.g. there is only one worker
+        return count <= grain || threaded_coroutine_executor::get_current_worker_index() != threaded_coroutine_executor::invalid_worker_index;
+    }
+
+}
+
+    /**
+     * @brief Invoke `function(i)` for every `i` in [begin, end) on the global threaded executor.
+     *
+     * The range is split lazily, down to chunks of `grain` indices at least. A chunk only splits further when it was
+     * stolen by another worker, so a balanced loop ends up with a few big chunks per worker.
+     */
+    template <std::integral T, typename Function>
+    requires std::invocable<Function&, T>
+    async<void> parallel_for_async(const T begin, const T end, const size_t grain, Function function) {
+        auto body = [&function](const T chunk_begin, const T chunk_end) {
+            for (T i = chunk_begin; i < chunk_end; ++i) {
+                std::invoke(function, i);
+            }
+        };
+        detail::parallel::loop_state<T, decltype(body)> state(body, grain);
+        co_await detail::parallel::loop_awaitable<T, decltype(body)>(state, begin, end);
+    }
+
+    /**
+     * @brief Blocking `parallel_for_async()`.
+     *
+     * Runs serially on calling thread if it is a worker of the executor, use `co_await parallel_for_async()` inside
+     * coroutines instead.
+     */
+    template <std::integral T, typename Function>
+    requires std::invocable<Function&, T>
+    void parallel_for(const T begin, const T end, const size_t grain, Function&& function) {
+        if (begin >= end) {
+            return;
+        }
+        if (detail::parallel::should_run_inline(static_cast<size_t>(end - begin), grain)) {
+            for (T i = begin; i < end; ++i) {
+                std::invoke(function, i);
+            }
+            return;
+        }
+        auto task = parallel_for_async(begin, end, grain, std::ref(function));
+        detail::parallel::block_on(task);
+    }
+
+    /**
+     * @brief Invoke `function(element)` for every element in a random access range.
+     */
+    template <std::ranges::random_access_range Range, typename Function>
+    requires std::invocable<Function&, std::ranges::range_reference_t<Range>>
+    void parallel_for(Range& range, const size_t grain, Function&& function) {
+        auto first = std::ranges::begin(range);
+        const auto count = static_cast<size_t>(std::ranges::distance(range));
+        parallel_for(size_t{0}, count, grain, [first, &function](const size_t index) {
+            std::invoke(function, first[static_cast<std::ranges::range_difference_t<Range>>(index)]);
+        });
+    }
+
+    /**
+     * @brief Reduce `function(i)` for every `i` in [begin, end) with `reduction`, starting from `identity`.
+     *
+     * Each chunk reduces locally and then merges into the result, the order of merging is unspecified so
+     * `reduction` must be associative and commutative.
+     */
+    template <std::integral T, typename Value, typename Function, typename Reduction>
+    requires std::invocable<Function&, T> && std::invocable<Reduction&, Value, Value>
+    async<Value> parallel_reduce_async(const T begin, const T end, const size_t grain, Value identity, Function function, Reduction reduction) {
+        Value result = identity;
+        std::mutex result_mutex{};
+        auto body = [&](const T chunk_begin, const T chunk_end) {
+            Value local = identity;
+            for (T i = chunk_begin; i < chunk_end; ++i) {
+                local = std::invoke(reduction, std::move(local), std::invoke(function, i));
+            }
+            std::lock_guard<std::mutex> lock(result_mutex);
+            result = std::invoke(reduction, std::move(result), std::move(local));
+        };
+        detail::parallel::loop_state<T, decltype(body)> state(body, grain);
+        co_await detail::parallel::loop_awaitable<T, decltype(body)>(state, begin, end);
+        co_return std::move(result);
+    }
+
+    /**
+     * @brief Blocking `parallel_reduce_async()`, runs serially on calling thread if it is a worker of the executor.
+     */
+    template <std::integral T, typename Value, typename Function, typename Reduction>
+    requires std::invocable<Function&, T> && std::invocable<Reduction&, Value, Value>
+    Value parallel_reduce(const T begin, const T end, const size_t grain, Value identity, Function&& function, Reduction&& reduction) {
+        if (begin >= end) {
+            return identity;
+        }
+        if (detail::parallel::should_run_inline(static_cast<size_t>(end - begin), grain)) {
+            Value result = std::move(identity);
+            for (T i = begin; i < end; ++i) {
+                result = std::invoke(reduction, std::move(result), std::invoke(function, i));
+            }
+            return result;
+        }
+        auto task = parallel_reduce_async(begin, end, grain, std::move(identity), std::ref(function), std::ref(reduction));
+        detail::parallel::block_on(task);
+        return task->get_result();
+    }
+
+}
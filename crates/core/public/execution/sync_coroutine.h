@@ -2,6 +2,7 @@
 
 #include "polyfill.h"
 #include "container/optional.hpp"
+#include "execution/frame_allocator.h"
 #include <type_traits>
 #include <coroutine>
 #include <utility>
@@ -57,7 +58,7 @@ namespace sync::detail {
     };
 
     template <typename T>
-    class coroutine_context<T>::promise_base {
+    class coroutine_context<T>::promise_base : public pooled_frame {
     public:
         using Outer = coroutine_context;
 
@@ -163,7 +164,7 @@ namespace sync::detail {
             }
         }
 
-        struct promise_type {
+        struct promise_type : pooled_frame {
             using Outer = sync_coroutine_context;
 
             Outer get_return_object() AVALANCHE_NOEXCEPT {
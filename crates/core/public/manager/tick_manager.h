@@ -2,12 +2,17 @@
 
 
 #include "avalanche_core_export.h"
+#include "polyfill.h"
 #include <cstdint>
 #include <cstddef>
 
 
 namespace avalanche::core {
 
+    namespace execution {
+        class promise_state_base;
+    }
+
     using tick_group_t = float;
 
     namespace TickGroup {
@@ -45,6 +50,52 @@ namespace avalanche::core {
          * @param delta_time duration time in millisecond
          */
         virtual void tick(duration_type delta_time) = 0;
+
+        /**
+         * @brief Opt in to tick concurrently with other tickables of the same group, on workers of the job system.
+         *
+         * Such a tickable must not touch states shared with other tickables of its group without synchronization, and
+         * must not register or unregister tickables from `tick()`. Queried when the tick list is rebuilt.
+         */
+        AVALANCHE_NO_DISCARD virtual bool is_parallel_tick_safe() const {
+            return false;
+        }
+    };
+
+    /**
+     * @brief Pacing of the frame loop, durations are in millisecond.
+     */
+    struct TickLoopSettings {
+        // Tick groups in [fixed_step_group_begin, fixed_step_group_end] tick in steps of this delta time, 0 to disable
+        ITickable::duration_type fixed_delta_time = 0;
+        tick_group_t fixed_step_group_begin = TickGroup::PrePhysics;
+        tick_group_t fixed_step_group_end = TickGroup::EndPhysics;
+        // Time exceeding these steps in a frame is dropped, or a slow frame leads to even more steps in the next one
+        uint32_t max_fixed_steps_per_frame = 8;
+        // Upper bound of the delta time of a frame, e.g. after a breakpoint, 0 for unbounded
+        ITickable::duration_type max_delta_time = 250;
+        // `tick_frame()` doesn't return before the frame lasted this long, 0 for unlimited frame rate
+        ITickable::duration_type target_frame_time = 0;
+        // The frame limiter spins instead of sleeping for the last part of the wait, hiding the granularity of OS timers
+        ITickable::duration_type spin_threshold = 2;
+    };
+
+    /**
+     * @brief Timings of a frame, durations are in millisecond.
+     */
+    struct FrameTimingStats {
+        uint64_t frame_index = 0;
+        // Measured time since the previous frame
+        ITickable::duration_type raw_delta_time = 0;
+        // Delta time passed to the variable rate tick groups, `raw_delta_time` clamped by `max_delta_time`
+        ITickable::duration_type delta_time = 0;
+        // Time spent by ticking
+        ITickable::duration_type tick_time = 0;
+        // Time spent by the frame limiter
+        ITickable::duration_type wait_time = 0;
+        uint32_t num_fixed_steps = 0;
+        // Accumulated time not yet consumed by fixed steps, in fraction of a step. Used to interpolate states between steps.
+        ITickable::duration_type fixed_step_alpha = 0;
     };
 
     class AVALANCHE_CORE_API ITickManager {
@@ -55,6 +106,72 @@ namespace avalanche::core {
 
         virtual void unregister_tickable(ITickable* tickable) = 0;
 
+        /**
+         * @brief `tickable` won't tick before `prerequisite` finished in the same frame.
+         *
+         * A prerequisite in an earlier group is always satisfied, one in a later group can't be and is ignored. Tickables of
+         * a group with prerequisites are ticked following a dependency graph, the parallel safe ones on the job system and
+         * the others on the calling thread of `tick_frame()`, waiting for their prerequisites running on workers.
+         * The prerequisite is dropped when either of them is unregistered.
+         */
+        virtual void add_tick_prerequisite(ITickable* tickable, ITickable* prerequisite) = 0;
+
+        virtual void remove_tick_prerequisite(ITickable* tickable, ITickable* prerequisite) = 0;
+
+        /*
+         * Scheduling of a registered tickable. These could be called from any thread, including inside `tick()`, and take
+         * effect at the beginning of the next frame. Only tickables ticking every frame are kept in the tick list, the
+         * others tick on the calling thread of `tick_frame()` after the tick list of their group, ignoring prerequisites,
+         * with the time elapsed since their last tick as delta time.
+         */
+
+        /**
+         * @brief Tick `tickable` once per `interval` milliseconds at most, 0 to tick every frame (the default).
+         */
+        virtual void set_tick_interval(ITickable* tickable, ITickable::duration_type interval) = 0;
+
+        /**
+         * @brief Stop ticking `tickable` until woken up, a sleeping tickable costs nothing per frame.
+         * @param duration Wake up automatically after `duration` milliseconds, 0 to sleep until `wake_tickable()`
+         */
+        virtual void sleep_tickable(ITickable* tickable, ITickable::duration_type duration = 0) = 0;
+
+        virtual void wake_tickable(ITickable* tickable) = 0;
+
+        /**
+         * @brief Low priority tickables take turns to tick, at most `set_round_robin_budget()` of them per frame.
+         *
+         * The tick interval doesn't apply to them.
+         */
+        virtual void set_tick_round_robin(ITickable* tickable, bool is_round_robin) = 0;
+
+        virtual void set_round_robin_budget(size_t max_tickables_per_frame) = 0;
+
+        /**
+         * @brief Could be called from any thread, including inside `tick()`, takes effect at the beginning of the next frame.
+         */
+        virtual void set_loop_settings(const TickLoopSettings& settings) = 0;
+
+        AVALANCHE_NO_DISCARD virtual TickLoopSettings get_loop_settings() const = 0;
+
+        /**
+         * @brief Push `coroutine` to its executor at the beginning of the next frame, backs `execution::next_frame()`.
+         */
+        virtual void resume_on_next_frame(execution::promise_state_base& coroutine) = 0;
+
+        /**
+         * @brief Timings of the last finished frame.
+         */
+        AVALANCHE_NO_DISCARD virtual FrameTimingStats get_frame_stats() const = 0;
+
+        /**
+         * @brief Tick a frame, then wait for the rest of `TickLoopSettings::target_frame_time`.
+         *
+         * Fixed step groups tick zero or more times in a frame, depending on the accumulated time.
+         * Coroutines queued to `execution::main_thread_executor::get_global_executor()` are resumed first.
+         *
+         * @return false after shutdown
+         */
         virtual bool tick_frame() = 0;
 
         /**
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string_view>
+#include "avalanche_core_export.h"
+#include "polyfill.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <intrin.h>
+#   define AVALANCHE_PROFILER_USE_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <x86intrin.h>
+#   define AVALANCHE_PROFILER_USE_RDTSC 1
+#else
+#   define AVALANCHE_PROFILER_USE_RDTSC 0
+#endif
+
+
+namespace avalanche::core {
+
+    /**
+     * @brief Static information of a zone, one per `AVALANCHE_PROFILE_SCOPE` in the code.
+     */
+    struct ProfileZoneLocation {
+        const char* name;
+        const char* function_name;
+        const char* filename;
+        int line;
+    };
+
+    /**
+     * @brief Records zones into a lock-free ring buffer of each thread, drained by the exporter.
+     *
+     * Zones are recorded once they ended, a full buffer drops new zones until the next export.
+     */
+    class AVALANCHE_CORE_API IProfiler {
+    public:
+        using timestamp_type = uint64_t;
+
+        virtual ~IProfiler();
+
+        static IProfiler& get();
+
+        /**
+         * @brief Runtime toggle, zones don't even read the clock while disabled. Disabled by default.
+         */
+        static void set_enabled(bool enabled) AVALANCHE_NOEXCEPT;
+
+        AVALANCHE_NO_DISCARD static bool is_enabled() AVALANCHE_NOEXCEPT;
+
+        /**
+         * @brief Timestamp in the unit of the profiler clock, TSC on x86 and `steady_clock` elsewhere.
+         */
+        AVALANCHE_NO_DISCARD static FORCEINLINE timestamp_type now() AVALANCHE_NOEXCEPT {
+#if AVALANCHE_PROFILER_USE_RDTSC
+            return __rdtsc();
+#else
+            return static_cast<timestamp_type>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        static void submit_zone(const ProfileZoneLocation& location, timestamp_type begin, timestamp_type end) AVALANCHE_NOEXCEPT;
+
+        /**
+         * @brief Name the calling thread in exported traces.
+         */
+        virtual void set_thread_name(std::string_view name) = 0;
+
+        /**
+         * @brief Drain zones recorded since the last export into a Chrome trace JSON file, which is loadable by
+         * chrome://tracing and Perfetto UI.
+         */
+        virtual bool write_chrome_trace(std::string_view path) = 0;
+
+        /**
+         * @brief Drop every zone recorded so far.
+         */
+        virtual void clear() = 0;
+
+        AVALANCHE_NO_DISCARD virtual size_t get_num_dropped_zones() const = 0;
+    };
+
+    class ScopedProfileZone {
+    public:
+        explicit ScopedProfileZone(const ProfileZoneLocation& location) AVALANCHE_NOEXCEPT {
+            if (IProfiler::is_enabled()) {
+                m_location = &location;
+                m_begin = IProfiler::now();
+            }
+        }
+
+        ~ScopedProfileZone() {
+            if (m_location != nullptr) {
+                IProfiler::submit_zone(*m_location, m_begin, IProfiler::now());
+            }
+        }
+
+        ScopedProfileZone(const ScopedProfileZone&) = delete;
+        ScopedProfileZone& operator=(const ScopedProfileZone&) = delete;
+
+    private:
+        const ProfileZoneLocation* m_location = nullptr;
+        IProfiler::timestamp_type m_begin = 0;
+    };
+
+} // namespace avalanche::core
+
+#if AVALANCHE_ENABLE_PROFILER
+#   define AVALANCHE_PROFILE_CONCAT_INNER(a, b) a##b
+#   define AVALANCHE_PROFILE_CONCAT(a, b) AVALANCHE_PROFILE_CONCAT_INNER(a, b)
+    // `name` must be a string literal
+#   define AVALANCHE_PROFILE_SCOPE(name) \
+        static const ::avalanche::core::ProfileZoneLocation AVALANCHE_PROFILE_CONCAT(avalanche_profile_location_, __LINE__) { name, AVALANCHE_CURRENT_FUNCTION, __FILE__, __LINE__ }; \
+        const ::avalanche::core::ScopedProfileZone AVALANCHE_PROFILE_CONCAT(avalanche_profile_zone_, __LINE__)(AVALANCHE_PROFILE_CONCAT(avalanche_profile_location_, __LINE__))
+#   define AVALANCHE_PROFILE_FUNCTION() AVALANCHE_PROFILE_SCOPE(AVALANCHE_CURRENT_FUNCTION)
+    // `name` isn't evaluated at all if the profiler is compiled out
+#   define AVALANCHE_PROFILE_THREAD_NAME(name) ::avalanche::core::IProfiler::get().set_thread_name(name)
+#else
+#   define AVALANCHE_PROFILE_SCOPE(name) ((void)0)
+#   define AVALANCHE_PROFILE_FUNCTION() ((void)0)
+#   define AVALANCHE_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
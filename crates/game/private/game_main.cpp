@@ -27,6 +27,10 @@ int main(int argc, char* argv[]) {
     auto* window = engine->create_window(window::WindowSettings {});
 
     ITickManager& ticker = ITickManager::get();
+    ticker.set_loop_settings({
+        .fixed_delta_time = 1000.f / 60.f,
+        .target_frame_time = 1000.f / 144.f,
+    });
     while (ticker.tick_frame())
         ;
 
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include "avalanche_render_device_export.h"
 #include "container/color.hpp"
+#include "container/small_vector.hpp"
 #include "render_enums.h"
 #include "render_resource.h"
 
@@ -39,14 +40,16 @@ namespace avalanche::rendering {
 
     class AVALANCHE_RENDER_DEVICE_API BindingCommandsMixin {
     public:
+        using dynamic_offset_list = small_vector<size_t, 4>;
+
         virtual ~BindingCommandsMixin() = default;
 
         /// @brief Set the bind group at the given index of a root signature (pipeline layout in Vulkan).
         /// @note Bind group also known as DescriptorSet in Vulkan.
         /// @param index The index of bind group to set in the root signature.
         /// @param bind_group_to_use Bind group that set to.
-        /// @param dynamic_offsets Sizes of dynamic buffer offsets
-        virtual void set_bind_group(uint32_t index, handle_t bind_group_to_use, const vector<size_t>& dynamic_offsets) = 0;
+        /// @param dynamic_offsets Sizes of dynamic buffer offsets, the first few are kept without allocation.
+        virtual void set_bind_group(uint32_t index, handle_t bind_group_to_use, const dynamic_offset_list& dynamic_offsets) = 0;
     };
 
     /// @brief Providing an operation set of rendering
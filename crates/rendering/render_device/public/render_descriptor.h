@@ -2,6 +2,7 @@
 
 
 #include <cstdint>
+#include "container/inplace_vector.hpp"
 #include "render_enums.h"
 #include "render_resource.h"
 
@@ -33,7 +34,10 @@ namespace avalanche::rendering {
     };
 
     struct RenderPassDesc {
-        vector<handle_t> color_attachments;
+        // Graphics APIs bind at most 8 render targets at once
+        static constexpr size_t max_color_attachments = 8;
+
+        inplace_vector<handle_t, max_color_attachments> color_attachments;
         handle_t depth_stencil_attachment;
         size_t max_draw_call_count = 50000000ULL;
     };
@@ -8,6 +8,7 @@
 #include "resource/vulkan_command_buffer.h"
 
 #include <mutex>
+#include <profiler.h>
 #include <render_resource.h>
 
 
@@ -28,7 +29,10 @@ namespace avalanche::rendering::vulkan {
 
     EGraphicsAPIType RenderDeviceImpl::get_graphics_api_type() { return EGraphicsAPIType::Vulkan; }
 
-    void RenderDeviceImpl::wait_for_device_idle() { m_context->device().waitIdle(); }
+    void RenderDeviceImpl::wait_for_device_idle() {
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::wait_for_device_idle");
+        m_context->device().waitIdle();
+    }
 
     void RenderDeviceImpl::enable_display_support() {
         AVALANCHE_CHECK_RUNTIME(core::ServerManager::get().get_server<VulkanWindowServer>() == nullptr,
@@ -45,6 +49,7 @@ namespace avalanche::rendering::vulkan {
         if (m_queued_delete_resource.empty()) {
             return;
         }
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::clean_pending_delete_resource");
         std::lock_guard lock(m_queue_mutex);
         while (!m_queued_delete_resource.empty()) {
             IResource* resource = m_queued_delete_resource.front();
@@ -65,16 +70,19 @@ namespace avalanche::rendering::vulkan {
     handle_t RenderDeviceImpl::create_image_view(const ImageViewDesc &desc) { return create_resource<ImageView>(desc); }
 
     handle_t RenderDeviceImpl::create_command_buffer(const CommandBufferDesc &desc) {
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::create_command_buffer");
         auto *buffer = construct_resource<CommandBuffer>(*this, desc.pool);
         buffer->initialize(desc);
         return get_resource_pool()->register_resource(buffer);
     }
 
     void RenderDeviceImpl::start_encoding_command(handle_t command_buffer) {
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::start_encoding_command");
         get_resource_by_handle<CommandBuffer>(command_buffer)->begin_record();
     }
 
     void RenderDeviceImpl::finish_encoding_command(handle_t command_buffer) {
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::finish_encoding_command");
         get_resource_by_handle<CommandBuffer>(command_buffer)->end_record();
     }
 
@@ -92,6 +100,7 @@ namespace avalanche::rendering::vulkan {
     }
 
     bool RenderDeviceImpl::block_on_fence(handle_t fence, uint32_t excepted_value, uint64_t timeout) {
+        AVALANCHE_PROFILE_SCOPE("RenderDevice::block_on_fence");
         const auto *f = get_resource_by_handle<Fence>(fence);
         vk::Result result = get_context().device().waitForFences({f->raw_handle()}, VK_TRUE, timeout);
         AVALANCHE_CHECK(result != vk::Result::eErrorDeviceLost, "Device lost")
@@ -1,6 +1,7 @@
 #include "shader_compiler.h"
 
 #include <logger.h>
+#include <profiler.h>
 
 namespace avalanche {
 
@@ -9,6 +10,7 @@ namespace avalanche {
     }
 
     Slang::ComPtr<slang::ISession> ShaderCompilerBase::create_compiler_session(const ShaderCompileDesc &desc) {
+        AVALANCHE_PROFILE_SCOPE("ShaderCompiler::create_compiler_session");
         std::lock_guard lock(m_mutex_);
 
         slang::SessionDesc session_desc{};
@@ -29,6 +31,7 @@ namespace avalanche {
     }
 
     std::expected<unique_ptr<ShaderCompileData>, ShaderCompileError> ShaderCompilerBase::compile(const ShaderCompileDesc &desc) {
+        AVALANCHE_PROFILE_SCOPE("ShaderCompiler::compile");
         std::lock_guard lock(m_mutex_);
 
         Slang::ComPtr<slang::ISession> compile_session = create_compiler_session(desc);
@@ -46,7 +49,11 @@ namespace avalanche {
         }
 
         // Compile
-        const SlangResult compile_result = compile_request->compile();
+        SlangResult compile_result;
+        {
+            AVALANCHE_PROFILE_SCOPE("ShaderCompiler::slang_compile");
+            compile_result = compile_request->compile();
+        }
         AVALANCHE_LOGGER.debug("Shader compilation result: \n\t{}", compile_request->getDiagnosticOutput());
         if (compile_result != SLANG_OK) {
             return std::unexpected(ShaderCompileError::InvalidCode);